@@ -0,0 +1,403 @@
+#include "schip8_emulator_analysis_cfg.hpp"
+#include "schip8_emulator_analysis_disassembler.hpp"
+#include "schip8_error.hpp"
+
+#include <algorithm>
+#include <fstream>
+#include <iomanip>
+#include <optional>
+#include <sstream>
+
+namespace SuperChip8::Emulator::Analysis {
+
+namespace {
+
+std::string hex(std::uint16_t value, int width = 3) {
+  std::ostringstream out;
+  out << std::uppercase << std::hex << std::setw(width) << std::setfill('0')
+      << value;
+  return out.str();
+}
+
+}  // namespace
+
+ControlFlowGraph::ControlFlowGraph(const std::uint8_t *program,
+                                   std::size_t size)
+    : _program(program,
+               program + std::min<std::size_t>(
+                             size, Memory::RAM_SIZE - Memory::ROM_START)) {
+  discoverCode();
+  buildBlocks();
+  findCodeWrites();
+}
+
+ControlFlowGraph ControlFlowGraph::fromFile(const std::string &program_path,
+                                            std::error_code &ec) {
+  std::ifstream file(program_path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    ec = Error::FILE_NOT_FOUND;
+    return ControlFlowGraph(nullptr, 0);
+  }
+  std::size_t size = file.tellg();
+  if (size > Memory::RAM_SIZE - Memory::ROM_START) {
+    ec = Error::OUT_OF_RANGE;
+    return ControlFlowGraph(nullptr, 0);
+  }
+  file.seekg(0, std::ios::beg);
+  std::vector<std::uint8_t> buffer(size);
+  file.read(reinterpret_cast<char *>(buffer.data()), size);
+  return ControlFlowGraph(buffer.data(), buffer.size());
+}
+
+bool ControlFlowGraph::isCode(std::uint16_t address) const {
+  return address < Memory::RAM_SIZE && _code[address];
+}
+
+Opcode ControlFlowGraph::opcodeAt(std::uint16_t address) const {
+  if (address < Memory::ROM_START || address + 2 > programEnd()) {
+    return Opcode(0);
+  }
+  std::size_t offset = address - Memory::ROM_START;
+  return Opcode((_program[offset] << 8) | _program[offset + 1]);
+}
+
+std::uint16_t ControlFlowGraph::programEnd() const {
+  return Memory::ROM_START + _program.size();
+}
+
+const std::map<std::uint16_t, BasicBlock> &ControlFlowGraph::blocks() const {
+  return _blocks;
+}
+
+const BasicBlock *ControlFlowGraph::blockAt(std::uint16_t address) const {
+  auto block = _blocks.find(address);
+  return block == _blocks.end() ? nullptr : &block->second;
+}
+
+const std::set<std::uint16_t> &ControlFlowGraph::subroutines() const {
+  return _subroutines;
+}
+
+std::vector<std::uint16_t> ControlFlowGraph::routineBlocks(
+    std::uint16_t entry) const {
+  std::vector<std::uint16_t> routine;
+  std::set<std::uint16_t> visited;
+  std::vector<std::uint16_t> pending = {entry};
+  while (!pending.empty()) {
+    std::uint16_t address = pending.back();
+    pending.pop_back();
+    const BasicBlock *block = blockAt(address);
+    if (!block || !visited.insert(address).second) {
+      continue;
+    }
+    routine.push_back(address);
+    pending.insert(pending.end(), block->successors.begin(),
+                   block->successors.end());
+  }
+  std::sort(routine.begin(), routine.end());
+  return routine;
+}
+
+const std::vector<std::uint16_t> &ControlFlowGraph::computedJumps() const {
+  return _computed_jumps;
+}
+
+const std::vector<CodeWrite> &ControlFlowGraph::codeWrites() const {
+  return _code_writes;
+}
+
+const std::set<std::uint16_t> &ControlFlowGraph::invalidTargets() const {
+  return _invalid_targets;
+}
+
+std::vector<std::pair<std::uint16_t, std::uint16_t>>
+ControlFlowGraph::dataRegions() const {
+  std::vector<std::pair<std::uint16_t, std::uint16_t>> regions;
+  for (std::uint16_t address = Memory::ROM_START; address < programEnd();) {
+    if (_code_bytes[address]) {
+      address++;
+      continue;
+    }
+    std::uint16_t start = address;
+    while (address < programEnd() && !_code_bytes[address]) {
+      address++;
+    }
+    regions.emplace_back(start, address);
+  }
+  return regions;
+}
+
+ControlFlowGraph::Flow ControlFlowGraph::flowOf(const Opcode &opcode,
+                                                std::uint16_t address) {
+  Flow flow;
+  std::uint16_t next = address + 2;
+  switch (opcode.category) {
+    case 0x0:
+      // RET (00EE) and EXIT (00FD)
+      if ((opcode.Y == 0xE && opcode.N == 0xE) ||
+          (opcode.Y == 0xF && opcode.N == 0xD)) {
+        flow.terminates = true;
+        return flow;
+      }
+      break;
+    case 0x1:
+      flow.targets = {opcode.NNN};
+      flow.terminates = true;
+      return flow;
+    case 0x2:
+      // the block ends on the call, the routine goes on after the return
+      flow.targets = {next};
+      flow.calls = {opcode.NNN};
+      flow.terminates = true;
+      return flow;
+    case 0x3:
+    case 0x4:
+    case 0x5:
+    case 0x9:
+      flow.targets = {next, static_cast<std::uint16_t>(next + 2)};
+      flow.terminates = true;
+      return flow;
+    case 0xB:
+      // computed jump, the targets are unknown
+      flow.terminates = true;
+      return flow;
+    case 0xE:
+      if (opcode.NN == 0x9E || opcode.NN == 0xA1) {
+        flow.targets = {next, static_cast<std::uint16_t>(next + 2)};
+        flow.terminates = true;
+        return flow;
+      }
+      break;
+  }
+  flow.targets = {next};
+  return flow;
+}
+
+void ControlFlowGraph::discoverCode() {
+  // recursive descent, with an explicit stack
+  std::vector<std::uint16_t> pending = {Memory::ROM_START};
+  _leaders.insert(Memory::ROM_START);
+  while (!pending.empty()) {
+    std::uint16_t address = pending.back();
+    pending.pop_back();
+    if (address < Memory::ROM_START || address + 2 > programEnd() ||
+        !isKnownOpcode(opcodeAt(address))) {
+      _invalid_targets.insert(address);
+      continue;
+    }
+    if (_code[address]) {
+      continue;
+    }
+
+    Opcode opcode = opcodeAt(address);
+    _code.set(address);
+    _code_bytes.set(address);
+    _code_bytes.set(address + 1);
+    if (opcode.category == 0xB) {
+      _computed_jumps.push_back(address);
+    }
+
+    Flow flow = flowOf(opcode, address);
+    for (std::uint16_t callee : flow.calls) {
+      _subroutines.insert(callee);
+      _leaders.insert(callee);
+      pending.push_back(callee);
+    }
+    for (std::uint16_t target : flow.targets) {
+      if (flow.terminates) {
+        _leaders.insert(target);
+      }
+      pending.push_back(target);
+    }
+  }
+  std::sort(_computed_jumps.begin(), _computed_jumps.end());
+}
+
+void ControlFlowGraph::buildBlocks() {
+  for (std::uint16_t leader : _leaders) {
+    if (!isCode(leader)) {
+      continue;
+    }
+
+    BasicBlock block{leader, leader, {}, {}};
+    std::uint16_t address = leader;
+    while (true) {
+      Opcode opcode = opcodeAt(address);
+      Flow flow = flowOf(opcode, address);
+      std::uint16_t next = address + 2;
+      block.end = next;
+      if (flow.terminates) {
+        block.successors = flow.targets;
+        block.calls = flow.calls;
+        block.returns = opcode.category == 0x0 && opcode.N == 0xE;
+        block.exits = opcode.category == 0x0 && opcode.N == 0xD;
+        block.computed_jump = opcode.category == 0xB;
+        break;
+      }
+      if (!isCode(next) || _leaders.count(next)) {
+        block.successors = {next};
+        break;
+      }
+      address = next;
+    }
+    _blocks.emplace(leader, block);
+  }
+}
+
+void ControlFlowGraph::findCodeWrites() {
+  for (const auto &[start, block] : _blocks) {
+    // I is only known after a SET_I of the same block
+    std::optional<std::uint16_t> I;
+    for (std::uint16_t address = start; address < block.end; address += 2) {
+      Opcode opcode = opcodeAt(address);
+      if (opcode.category == 0xA) {
+        I = opcode.NNN;
+        continue;
+      }
+      if (opcode.category != 0xF) {
+        continue;
+      }
+
+      std::uint16_t size = 0;
+      switch (opcode.NN) {
+        case 0x1E:
+        case 0x29:
+        case 0x30:
+          I.reset();
+          break;
+        case 0x33:
+          size = 3;
+          break;
+        case 0x55:
+          size = opcode.X + 1;
+          break;
+      }
+      if (size == 0 || !I) {
+        continue;
+      }
+      for (std::uint16_t offset = 0; offset < size; offset++) {
+        std::uint16_t written = *I + offset;
+        if (written < Memory::RAM_SIZE && _code_bytes[written]) {
+          _code_writes.push_back({address, *I, size});
+          break;
+        }
+      }
+    }
+  }
+}
+
+std::string ControlFlowGraph::label(std::uint16_t address) const {
+  if (address == Memory::ROM_START) {
+    return "main";
+  }
+  if (_subroutines.count(address)) {
+    return "sub_" + hex(address);
+  }
+  return "L_" + hex(address);
+}
+
+void ControlFlowGraph::writeText(std::ostream &out) const {
+  out << "; " << _program.size() << " bytes, " << _blocks.size()
+      << " blocks, " << _subroutines.size() << " subroutines, "
+      << _computed_jumps.size() << " computed jumps, " << _code_writes.size()
+      << " writes to code\n";
+
+  std::map<std::uint16_t, std::string> comments;
+  for (std::uint16_t address : _computed_jumps) {
+    comments[address] = "computed jump, targets unknown";
+  }
+  for (const CodeWrite &write : _code_writes) {
+    comments[write.instruction] = "writes to code at " + hex(write.address);
+  }
+  for (const auto &[start, block] : _blocks) {
+    for (std::uint16_t target : block.successors) {
+      if (_invalid_targets.count(target)) {
+        comments[block.end - 2] = "continues to " + hex(target) +
+                                  ", outside of the code";
+      }
+    }
+  }
+
+  for (std::uint16_t address = Memory::ROM_START; address < programEnd();) {
+    if (_leaders.count(address) && isCode(address)) {
+      out << "\n" << label(address) << ":\n";
+    }
+
+    if (isCode(address)) {
+      Opcode opcode = opcodeAt(address);
+      std::string instruction = disassemble(opcode);
+      out << "  " << hex(address) << ": " << hex(opcode.raw, 4) << "  "
+          << instruction;
+      auto comment = comments.find(address);
+      if (comment != comments.end()) {
+        out << std::string(std::max<int>(1, 20 - instruction.size()), ' ')
+            << "; " << comment->second;
+      }
+      out << "\n";
+      address += 2;
+      continue;
+    }
+
+    if (_code_bytes[address]) {
+      // second byte of an instruction overlapping the next one
+      address++;
+      continue;
+    }
+
+    // data, 8 bytes per line
+    out << "  " << hex(address) << ": DB";
+    for (std::uint8_t count = 0;
+         count < 8 && address < programEnd() && !_code_bytes[address];
+         count++, address++) {
+      out << " " << hex(_program[address - Memory::ROM_START], 2);
+    }
+    out << "\n";
+  }
+}
+
+void ControlFlowGraph::writeDot(std::ostream &out) const {
+  out << "digraph cfg {\n"
+      << "  node [shape=box fontname=\"monospace\"];\n";
+
+  std::set<std::uint16_t> writing_blocks;
+  for (const CodeWrite &write : _code_writes) {
+    auto block = _blocks.upper_bound(write.instruction);
+    writing_blocks.insert(std::prev(block)->first);
+  }
+
+  for (const auto &[start, block] : _blocks) {
+    out << "  b_" << hex(start) << " [label=\"" << label(start) << ":\\l";
+    for (std::uint16_t address = start; address < block.end; address += 2) {
+      out << hex(address) << ": " << disassemble(opcodeAt(address)) << "\\l";
+    }
+    out << "\"";
+    if (block.computed_jump) {
+      out << " color=red";
+    } else if (writing_blocks.count(start)) {
+      out << " color=orange";
+    }
+    out << "];\n";
+  }
+
+  for (const auto &[start, block] : _blocks) {
+    for (std::uint16_t target : block.successors) {
+      if (_blocks.count(target)) {
+        out << "  b_" << hex(start) << " -> b_" << hex(target) << ";\n";
+      } else {
+        out << "  x_" << hex(target) << " [label=\"" << hex(target)
+            << "\" shape=plaintext fontcolor=red];\n"
+            << "  b_" << hex(start) << " -> x_" << hex(target)
+            << " [color=red];\n";
+      }
+    }
+    for (std::uint16_t callee : block.calls) {
+      if (_blocks.count(callee)) {
+        out << "  b_" << hex(start) << " -> b_" << hex(callee)
+            << " [style=dashed label=\"call\"];\n";
+      }
+    }
+  }
+  out << "}\n";
+}
+
+}  // namespace SuperChip8::Emulator::Analysis
@@ -0,0 +1,152 @@
+#ifndef SUPERCHIP8_EMULATOR_ANALYSIS_CFG_HPP
+#define SUPERCHIP8_EMULATOR_ANALYSIS_CFG_HPP
+
+#include "schip8_emulator_memory_ram.hpp"
+#include "schip8_emulator_opcode.hpp"
+
+#include <bitset>
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <system_error>
+#include <utility>
+#include <vector>
+
+namespace SuperChip8::Emulator::Analysis {
+
+/// @brief Straight-line run of instructions, only entered at its first one
+struct BasicBlock {
+  std::uint16_t start;
+  // address after the last instruction
+  std::uint16_t end;
+  // blocks the execution continues to in the same routine (jump, skip or
+  // fall-through)
+  std::vector<std::uint16_t> successors;
+  // subroutine called by the last instruction (CALL), if any
+  std::vector<std::uint16_t> calls;
+  // last instruction
+  bool returns = false;
+  bool exits = false;
+  bool computed_jump = false;
+};
+
+/// @brief A store (BCD, STORE_REG) whose destination overlaps code
+struct CodeWrite {
+  // address of the store instruction
+  std::uint16_t instruction;
+  // first address written, and number of bytes
+  std::uint16_t address;
+  std::uint16_t size;
+};
+
+/// @brief Control-flow graph of a program loaded at ROM_START
+///
+/// @details The code is found by recursive descent from ROM_START, following
+/// jumps, skips and subroutine calls (2NNN); the bytes never reached are data.
+/// The targets of computed jumps (BNNN) are unknown: the jumps are flagged and
+/// the code only reached through them is seen as data. Writes to code
+/// (self-modifying programs) are detected when I is set by SET_I in the same
+/// block as the store.
+///
+/// The analysis is meant to be reused by the execution engines (ie: to
+/// pre-decode or verify the code), see schip8_tools_disasm.cpp for the
+/// text and Graphviz outputs.
+class ControlFlowGraph {
+ public:
+  /// @brief Analyze a program
+  /// @param program The program bytes, loaded at ROM_START
+  /// @param size The program size
+  ControlFlowGraph(const std::uint8_t *program, std::size_t size);
+
+  /// @brief Analyze a program file
+  /// @param program_path Path to the program
+  /// @param ec error_code
+  ///
+  /// - Error::FILE_NOT_FOUND | If the file cannot be opened
+  ///
+  /// - Error::OUT_OF_RANGE | If the program is too large to fit in memory
+  static ControlFlowGraph fromFile(const std::string &program_path,
+                                   std::error_code &ec);
+
+  /// @return `true` if an instruction starts at the address
+  bool isCode(std::uint16_t address) const;
+
+  /// @return the opcode at an address of the program (0 outside)
+  Opcode opcodeAt(std::uint16_t address) const;
+
+  /// @return the address after the last byte of the program
+  std::uint16_t programEnd() const;
+
+  /// @return the basic blocks, by start address
+  const std::map<std::uint16_t, BasicBlock> &blocks() const;
+
+  /// @return the block starting at an address, nullptr if none
+  const BasicBlock *blockAt(std::uint16_t address) const;
+
+  /// @return the entry points of the subroutines (CALL targets)
+  const std::set<std::uint16_t> &subroutines() const;
+
+  /// @return the blocks of a routine, reached from its entry without
+  /// following the calls
+  std::vector<std::uint16_t> routineBlocks(std::uint16_t entry) const;
+
+  /// @return the addresses of the computed jumps (BNNN)
+  const std::vector<std::uint16_t> &computedJumps() const;
+
+  /// @return the stores that write to code
+  const std::vector<CodeWrite> &codeWrites() const;
+
+  /// @return the jump, skip and call targets outside of the program or on an
+  /// unknown opcode
+  const std::set<std::uint16_t> &invalidTargets() const;
+
+  /// @return the data regions, [start, end) ranges of bytes not part of any
+  /// reached instruction
+  std::vector<std::pair<std::uint16_t, std::uint16_t>> dataRegions() const;
+
+  /// @brief Write the disassembly, with labels, flags and data regions
+  void writeText(std::ostream &out) const;
+
+  /// @brief Write the graph in the Graphviz dot format
+  void writeDot(std::ostream &out) const;
+
+ private:
+  /// @brief Control flow of an instruction
+  struct Flow {
+    // next instructions in the same routine
+    std::vector<std::uint16_t> targets;
+    // subroutine called, if any
+    std::vector<std::uint16_t> calls;
+    // the instruction does not continue to the next one
+    bool terminates = false;
+  };
+  static Flow flowOf(const Opcode &opcode, std::uint16_t address);
+
+  void discoverCode();
+  void buildBlocks();
+  void findCodeWrites();
+
+  /// @return the label of a block (main, sub_XXX or L_XXX)
+  std::string label(std::uint16_t address) const;
+
+  std::vector<std::uint8_t> _program;
+
+  // first byte of the reached instructions
+  std::bitset<Memory::RAM_SIZE> _code;
+  // every byte of the reached instructions
+  std::bitset<Memory::RAM_SIZE> _code_bytes;
+  // first instruction of a block
+  std::set<std::uint16_t> _leaders;
+
+  std::map<std::uint16_t, BasicBlock> _blocks;
+  std::set<std::uint16_t> _subroutines;
+  std::vector<std::uint16_t> _computed_jumps;
+  std::vector<CodeWrite> _code_writes;
+  std::set<std::uint16_t> _invalid_targets;
+};
+
+}  // namespace SuperChip8::Emulator::Analysis
+
+#endif  // SUPERCHIP8_EMULATOR_ANALYSIS_CFG_HPP
@@ -0,0 +1,151 @@
+#include "schip8_emulator_analysis_disassembler.hpp"
+
+#include <iomanip>
+#include <sstream>
+
+namespace SuperChip8::Emulator::Analysis {
+
+namespace {
+
+std::string hex(std::uint16_t value, int width) {
+  std::ostringstream out;
+  out << "0x" << std::uppercase << std::hex << std::setw(width)
+      << std::setfill('0') << value;
+  return out.str();
+}
+
+std::string reg(std::uint8_t index) {
+  std::ostringstream out;
+  out << "V" << std::uppercase << std::hex << static_cast<int>(index);
+  return out.str();
+}
+
+/// @return the instruction, empty for an unknown opcode
+std::string mnemonic(const Opcode &opcode) {
+  std::string vx = reg(opcode.X);
+  std::string vy = reg(opcode.Y);
+  std::string nn = hex(opcode.NN, 2);
+  std::string nnn = hex(opcode.NNN, 3);
+
+  switch (opcode.category) {
+    case 0x0:
+      // decoded on Y and N only, as the VM does
+      if (opcode.Y == 0xC) {
+        return "SCROLL_DOWN " + std::to_string(opcode.N);
+      }
+      switch ((opcode.Y << 4) | opcode.N) {
+        case 0xE0:
+          return "CLEAR";
+        case 0xEE:
+          return "RET";
+        case 0xFB:
+          return "SCROLL_RIGHT";
+        case 0xFC:
+          return "SCROLL_LEFT";
+        case 0xFD:
+          return "EXIT";
+        case 0xFE:
+          return "LOW";
+        case 0xFF:
+          return "HIGH";
+      }
+      return {};
+    case 0x1:
+      return "JMP " + nnn;
+    case 0x2:
+      return "CALL " + nnn;
+    case 0x3:
+      return "SKIP_EQ " + vx + ", " + nn;
+    case 0x4:
+      return "SKIP_NEQ " + vx + ", " + nn;
+    case 0x5:
+      return "SKIP_EQ_REG " + vx + ", " + vy;
+    case 0x6:
+      return "SET " + vx + ", " + nn;
+    case 0x7:
+      return "ADD " + vx + ", " + nn;
+    case 0x8:
+      switch (opcode.N) {
+        case 0x0:
+          return "SET " + vx + ", " + vy;
+        case 0x1:
+          return "OR " + vx + ", " + vy;
+        case 0x2:
+          return "AND " + vx + ", " + vy;
+        case 0x3:
+          return "XOR " + vx + ", " + vy;
+        case 0x4:
+          return "ADD_REG " + vx + ", " + vy;
+        case 0x5:
+          return "SUB_REG " + vx + ", " + vy;
+        case 0x6:
+          return "SHR " + vx;
+        case 0x7:
+          return "SUBN_REG " + vx + ", " + vy;
+        case 0xE:
+          return "SHL " + vx;
+      }
+      return {};
+    case 0x9:
+      return "SKIP_NEQ_REG " + vx + ", " + vy;
+    case 0xA:
+      return "SET_I " + nnn;
+    case 0xB:
+      return "JMP_V0 " + nnn + ", " + vx;
+    case 0xC:
+      return "RAND " + vx + ", " + nn;
+    case 0xD:
+      return "DISP " + vx + ", " + vy + ", " + std::to_string(opcode.N);
+    case 0xE:
+      switch (opcode.NN) {
+        case 0x9E:
+          return "SKIP_KEY " + vx;
+        case 0xA1:
+          return "SKIP_NKEY " + vx;
+      }
+      return {};
+    case 0xF:
+      switch (opcode.NN) {
+        case 0x07:
+          return "GET_DELAY " + vx;
+        case 0x0A:
+          return "WAIT_KEY " + vx;
+        case 0x15:
+          return "SET_DELAY " + vx;
+        case 0x18:
+          return "SET_SOUND " + vx;
+        case 0x1E:
+          return "ADD_I " + vx;
+        case 0x29:
+          return "SET_FONT " + vx;
+        case 0x30:
+          return "SET_FONT_HIGH " + vx;
+        case 0x33:
+          return "BCD " + vx;
+        case 0x55:
+          return "STORE_REG " + vx;
+        case 0x65:
+          return "LD_REG " + vx;
+        case 0x75:
+          return "SAVE_FLAGS " + vx;
+        case 0x85:
+          return "LD_FLAGS " + vx;
+      }
+      return {};
+  }
+  return {};
+}
+
+}  // namespace
+
+bool isKnownOpcode(const Opcode &opcode) { return !mnemonic(opcode).empty(); }
+
+std::string disassemble(const Opcode &opcode) {
+  std::string instruction = mnemonic(opcode);
+  if (instruction.empty()) {
+    return "DW " + hex(opcode.raw, 4);
+  }
+  return instruction;
+}
+
+}  // namespace SuperChip8::Emulator::Analysis
@@ -0,0 +1,24 @@
+#ifndef SUPERCHIP8_EMULATOR_ANALYSIS_DISASSEMBLER_HPP
+#define SUPERCHIP8_EMULATOR_ANALYSIS_DISASSEMBLER_HPP
+
+#include "schip8_emulator_opcode.hpp"
+
+#include <string>
+
+namespace SuperChip8::Emulator::Analysis {
+
+/// @brief Check if an opcode is executed by the VM (an unknown opcode raises
+/// Error::UNKNOWN_OPCODE)
+/// @param opcode The opcode to check
+/// @return `true` if the opcode is known
+bool isKnownOpcode(const Opcode &opcode);
+
+/// @brief Disassemble an opcode, with the mnemonics used in the VM
+/// (ie: "SET V1, 0x05", "DISP V1, V2, 5")
+/// @param opcode The opcode to disassemble
+/// @return the instruction, "DW 0xNNNN" for an unknown opcode
+std::string disassemble(const Opcode &opcode);
+
+}  // namespace SuperChip8::Emulator::Analysis
+
+#endif  // SUPERCHIP8_EMULATOR_ANALYSIS_DISASSEMBLER_HPP
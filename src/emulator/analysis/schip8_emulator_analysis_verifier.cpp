@@ -0,0 +1,242 @@
+#include "schip8_emulator_analysis_verifier.hpp"
+#include "schip8_emulator_fontset.hpp"
+#include "schip8_emulator_memory_registers.hpp"
+
+#include <algorithm>
+#include <deque>
+#include <functional>
+#include <iomanip>
+#include <map>
+#include <optional>
+#include <sstream>
+
+namespace SuperChip8::Emulator::Analysis {
+
+namespace {
+
+// I is a 16 bits register
+constexpr std::uint32_t I_MAX = 0xFFFF;
+// updates of a block entry state before its interval is widened to any I
+constexpr int WIDENING_THRESHOLD = 8;
+// depth returned for a recursive routine, beyond any stack
+constexpr int UNBOUNDED_DEPTH = Memory::STACK_SIZE + 1;
+
+/// @brief Abstract value of I, all the values in [lo, hi]
+struct Interval {
+  std::uint32_t lo;
+  std::uint32_t hi;
+
+  bool operator==(const Interval &other) const = default;
+};
+
+Interval join(const Interval &a, const Interval &b) {
+  return {std::min(a.lo, b.lo), std::max(a.hi, b.hi)};
+}
+
+/// @brief I after an instruction
+Interval transfer(const Opcode &opcode, const Interval &I) {
+  if (opcode.category == 0xA) {
+    // SET_I
+    return {opcode.NNN, opcode.NNN};
+  }
+  if (opcode.category != 0xF) {
+    return I;
+  }
+  switch (opcode.NN) {
+    case 0x1E:
+      // ADD_I, I wraps around past 0xFFFF
+      if (I.hi + 0xFF > I_MAX) {
+        return {0, I_MAX};
+      }
+      return {I.lo, I.hi + 0xFF};
+    case 0x29:
+      return {0, (CHARACTERS - 1) * FONT_HEIGHT_LOW_RES};
+    case 0x30:
+      return {FONT_SIZE_LOW_RES,
+              FONT_SIZE_LOW_RES + (CHARACTERS - 1) * FONT_HEIGHT_HIGH_RES};
+  }
+  return I;
+}
+
+/// @brief Access relative to I, the VM checks that I + last < RAM_SIZE
+struct IAccess {
+  std::uint16_t last;
+  bool write;
+};
+
+std::optional<IAccess> iAccessOf(const Opcode &opcode) {
+  if (opcode.category == 0xD) {
+    // same bound as the checked VM: isSizeReadable(I, sprite_size), with a
+    // single plane (the verifier models the SuperChip-8)
+    std::uint16_t sprite_size = opcode.N == 0 ? 16 * 2 : opcode.N;
+    return IAccess{static_cast<std::uint16_t>(sprite_size - 1), false};
+  }
+  if (opcode.category != 0xF) {
+    return std::nullopt;
+  }
+  switch (opcode.NN) {
+    case 0x33:
+      return IAccess{2, true};
+    case 0x55:
+      return IAccess{opcode.X, true};
+    case 0x65:
+      return IAccess{opcode.X, false};
+  }
+  return std::nullopt;
+}
+
+std::string hex(std::uint32_t value) {
+  std::ostringstream out;
+  out << std::uppercase << std::hex << std::setw(3) << std::setfill('0')
+      << value;
+  return out.str();
+}
+
+}  // namespace
+
+Verification verify(const ControlFlowGraph &cfg) {
+  Verification result;
+
+  // pc
+  for (std::uint16_t address : cfg.computedJumps()) {
+    result.failures.push_back("computed jump at " + hex(address));
+  }
+  for (std::uint16_t address : cfg.invalidTargets()) {
+    result.failures.push_back("pc can reach " + hex(address) +
+                              ", outside of the code");
+  }
+
+  // stack: nesting of the calls, from the routines call graph
+  std::map<std::uint16_t, int> depths;
+  std::function<int(std::uint16_t)> routineDepth =
+      [&](std::uint16_t entry) -> int {
+    auto known = depths.find(entry);
+    if (known != depths.end()) {
+      if (known->second < 0) {
+        result.failures.push_back("recursive call to " + hex(entry));
+        return UNBOUNDED_DEPTH;
+      }
+      return known->second;
+    }
+    depths[entry] = -1;
+    int depth = 0;
+    for (std::uint16_t start : cfg.routineBlocks(entry)) {
+      for (std::uint16_t callee : cfg.blockAt(start)->calls) {
+        depth = std::min(UNBOUNDED_DEPTH,
+                         std::max(depth, 1 + routineDepth(callee)));
+      }
+    }
+    depths[entry] = depth;
+    return depth;
+  };
+  int max_depth = routineDepth(Memory::ROM_START);
+  if (max_depth > Memory::STACK_SIZE) {
+    result.failures.push_back("call nesting beyond the stack size");
+  }
+  for (std::uint16_t start : cfg.routineBlocks(Memory::ROM_START)) {
+    if (cfg.blockAt(start)->returns) {
+      result.failures.push_back("RET outside of a subroutine in " +
+                                hex(start));
+    }
+  }
+
+  // I: interval analysis, calls and returns are context-insensitive edges
+  std::map<std::uint16_t, std::vector<std::uint16_t>> owners;
+  std::map<std::uint16_t, std::vector<std::uint16_t>> return_sites;
+  for (std::uint16_t entry : cfg.subroutines()) {
+    for (std::uint16_t start : cfg.routineBlocks(entry)) {
+      owners[start].push_back(entry);
+    }
+  }
+  for (const auto &[start, block] : cfg.blocks()) {
+    for (std::uint16_t callee : block.calls) {
+      return_sites[callee].push_back(block.end);
+    }
+  }
+
+  std::map<std::uint16_t, Interval> entry_states;
+  std::map<std::uint16_t, int> updates;
+  std::deque<std::uint16_t> pending;
+  auto propagate = [&](std::uint16_t target, const Interval &I) {
+    if (!cfg.blockAt(target)) {
+      return;
+    }
+    auto state = entry_states.find(target);
+    if (state == entry_states.end()) {
+      entry_states.emplace(target, I);
+      pending.push_back(target);
+      return;
+    }
+    Interval joined = join(state->second, I);
+    if (joined == state->second) {
+      return;
+    }
+    if (++updates[target] > WIDENING_THRESHOLD) {
+      joined = {0, I_MAX};
+    }
+    state->second = joined;
+    pending.push_back(target);
+  };
+
+  propagate(Memory::ROM_START, {0, 0});
+  while (!pending.empty()) {
+    std::uint16_t start = pending.front();
+    pending.pop_front();
+    const BasicBlock &block = *cfg.blockAt(start);
+    Interval I = entry_states.at(start);
+    for (std::uint16_t address = start; address < block.end; address += 2) {
+      I = transfer(cfg.opcodeAt(address), I);
+    }
+
+    if (!block.calls.empty()) {
+      // continues after the return, see the RET blocks
+      for (std::uint16_t callee : block.calls) {
+        propagate(callee, I);
+      }
+    } else if (block.returns) {
+      for (std::uint16_t entry : owners[start]) {
+        for (std::uint16_t site : return_sites[entry]) {
+          propagate(site, I);
+        }
+      }
+    } else {
+      for (std::uint16_t successor : block.successors) {
+        propagate(successor, I);
+      }
+    }
+  }
+
+  // checking the I-relative accesses with the fixpoint
+  for (const auto &[start, entry_state] : entry_states) {
+    const BasicBlock &block = *cfg.blockAt(start);
+    Interval I = entry_state;
+    for (std::uint16_t address = start; address < block.end; address += 2) {
+      Opcode opcode = cfg.opcodeAt(address);
+      std::optional<IAccess> access = iAccessOf(opcode);
+      if (access) {
+        if (I.hi + access->last >= Memory::RAM_SIZE) {
+          result.failures.push_back("I can be out of range at " +
+                                    hex(address));
+        } else if (access->write) {
+          for (std::uint32_t written = I.lo; written <= I.hi + access->last;
+               written++) {
+            if (cfg.isCode(written) ||
+                (written > 0 && cfg.isCode(written - 1))) {
+              result.failures.push_back("write to code at " + hex(address));
+              break;
+            }
+          }
+        }
+      }
+      I = transfer(opcode, I);
+    }
+  }
+
+  result.proven = result.failures.empty();
+  if (result.proven) {
+    result.max_stack_depth = max_depth;
+  }
+  return result;
+}
+
+}  // namespace SuperChip8::Emulator::Analysis
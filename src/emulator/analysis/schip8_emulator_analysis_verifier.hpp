@@ -0,0 +1,45 @@
+#ifndef SUPERCHIP8_EMULATOR_ANALYSIS_VERIFIER_HPP
+#define SUPERCHIP8_EMULATOR_ANALYSIS_VERIFIER_HPP
+
+#include "schip8_emulator_analysis_cfg.hpp"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace SuperChip8::Emulator::Analysis {
+
+/// @brief Result of verify()
+struct Verification {
+  // `true` if the program provably never fails a bounds check
+  bool proven = false;
+  // why the proof failed (ie: "computed jump at 2A4")
+  std::vector<std::string> failures;
+  // deepest subroutine nesting (if proven)
+  std::uint8_t max_stack_depth = 0;
+};
+
+/// @brief Prove that a program cannot fail a bounds check of the VM
+///
+/// @details The reachable code (see ControlFlowGraph) is abstract-interpreted
+/// from the boot state (I = 0, empty stack) to prove that:
+///
+/// - pc stays on known instructions of the program: no computed jump (BNNN),
+///   no jump, skip or fall-through outside of the code or onto an unknown
+///   opcode
+///
+/// - the stack stays in [0, STACK_SIZE]: no recursion, a nesting of at most
+///   STACK_SIZE calls, and no RET outside of a subroutine
+///
+/// - the I-relative accesses (DISP, BCD, STORE_REG, LD_REG) stay in RAM, with
+///   the same bounds as the checked VM; I is tracked as an interval, and the
+///   stores must not write to code (which would invalidate the graph)
+///
+/// The VM runs the unchecked interpreter for proven programs.
+/// @param cfg The control-flow graph of the program
+/// @return the verification result
+Verification verify(const ControlFlowGraph &cfg);
+
+}  // namespace SuperChip8::Emulator::Analysis
+
+#endif  // SUPERCHIP8_EMULATOR_ANALYSIS_VERIFIER_HPP
@@ -0,0 +1,640 @@
+#include "schip8_emulator_batch_engine.hpp"
+#include "schip8_emulator_batch_simd.hpp"
+#include "schip8_emulator_fontset.hpp"
+#include "schip8_error.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace SuperChip8::Emulator::Batch {
+
+using System::Graphics::FRAME_ROW_BYTES;
+using System::Graphics::HIGH_RES_VIRTUAL_SCREEN_HEIGHT;
+using System::Graphics::HIGH_RES_VIRTUAL_SCREEN_WIDTH;
+using System::Graphics::LOW_RES_VIRTUAL_SCREEN_HEIGHT;
+using System::Graphics::LOW_RES_VIRTUAL_SCREEN_WIDTH;
+
+// beyond this number of pc groups in a cycle, the remaining lanes are run one
+// by one (divergence)
+constexpr std::size_t MAX_VECTOR_GROUPS = 8;
+// groups smaller than this are run one lane at a time, as a vector kernel
+// always processes every lane
+constexpr std::size_t MIN_VECTOR_LANES = 8;
+
+Engine::Engine(std::size_t lanes, std::uint16_t target_cycles)
+    : _lanes(lanes),
+      _stride((lanes + LANE_ALIGNMENT - 1) / LANE_ALIGNMENT * LANE_ALIGNMENT),
+      _target_cycles(target_cycles) {
+  for (std::vector<std::uint8_t> &v : _V) {
+    v.resize(_stride);
+  }
+  for (std::vector<std::uint8_t> &rpl : _RPL) {
+    rpl.resize(_stride);
+  }
+  for (std::vector<std::uint16_t> &level : _stack) {
+    level.resize(_stride);
+  }
+  _I.resize(_stride);
+  _pc.resize(_stride);
+  _sp.resize(_stride);
+  _delay_timer.resize(_stride);
+  _sound_timer.resize(_stride);
+  _ram.resize(Memory::RAM_SIZE * _stride);
+  _frames.resize(FRAME_SIZE * _stride);
+  _high_res.resize(_stride);
+  _keys.resize(_stride);
+  _key_awaiting_release.resize(_stride);
+  _rng.resize(_stride);
+  _done.resize(_stride);
+  _errors.resize(_stride);
+  _mask.resize(_stride);
+  _executed.resize(_stride);
+  _skip.resize(_stride);
+}
+
+void Engine::loadProgram(const std::string &program_path,
+                         std::error_code &ec) {
+  std::ifstream file(program_path, std::ios::binary | std::ios::ate);
+  if (!file.is_open()) {
+    ec = Error::FILE_NOT_FOUND;
+    return;
+  }
+  std::size_t size = file.tellg();
+  if (Memory::ROM_START + size > Memory::RAM_SIZE) {
+    ec = Error::OUT_OF_RANGE;
+    return;
+  }
+  file.seekg(0, std::ios::beg);
+  _program.resize(size);
+  file.read(reinterpret_cast<char *>(_program.data()), size);
+}
+
+Engine::Observation Engine::reset(const std::vector<std::uint32_t> &seeds) {
+  for (std::size_t i = 0; i < Memory::REGISTERS; i++) {
+    std::fill(_V[i].begin(), _V[i].end(), 0);
+    std::fill(_RPL[i].begin(), _RPL[i].end(), 0);
+  }
+  for (std::vector<std::uint16_t> &level : _stack) {
+    std::fill(level.begin(), level.end(), 0);
+  }
+  std::fill(_I.begin(), _I.end(), 0);
+  std::fill(_pc.begin(), _pc.end(), Memory::ROM_START);
+  std::fill(_sp.begin(), _sp.end(), 0);
+  std::fill(_delay_timer.begin(), _delay_timer.end(), 0);
+  std::fill(_sound_timer.begin(), _sound_timer.end(), 0);
+  std::fill(_frames.begin(), _frames.end(), 0);
+  std::fill(_high_res.begin(), _high_res.end(), 0);
+  std::fill(_keys.begin(), _keys.end(), 0);
+  std::fill(_key_awaiting_release.begin(), _key_awaiting_release.end(), -1);
+  std::fill(_done.begin(), _done.end(), 0);
+  std::fill(_errors.begin(), _errors.end(), std::error_code());
+
+  // RAM: fontset, then the program, the same for every lane
+  std::fill(_ram.begin(), _ram.end(), 0);
+  auto broadcast = [this](const std::uint8_t *data, std::size_t size,
+                          std::uint16_t offset) {
+    for (std::size_t i = 0; i < size; i++) {
+      std::fill_n(&_ram[(offset + i) * _stride], _stride, data[i]);
+    }
+  };
+  broadcast(FONTSET_LOW_RES.data(), FONT_SIZE_LOW_RES, 0);
+  broadcast(FONTSET_HIGH_RES.data(), FONT_SIZE_HIGH_RES, FONT_SIZE_LOW_RES);
+  broadcast(_program.data(), _program.size(), Memory::ROM_START);
+
+  // xorshift32 must not be seeded with 0
+  for (std::size_t lane = 0; lane < _lanes; lane++) {
+    std::uint32_t seed = lane < seeds.size() ? seeds[lane] : 0;
+    _rng[lane] = seed != 0 ? seed : 0x6D2B79F5;
+  }
+
+  return {_frames.data(), _high_res.data(), _done.data()};
+}
+
+Engine::Observation Engine::step(const std::vector<std::uint16_t> &actions) {
+  std::copy_n(actions.begin(), std::min(actions.size(), _lanes),
+              _keys.begin());
+
+  for (std::uint16_t cycle = 0; cycle < _target_cycles; cycle++) {
+    this->cycle();
+  }
+
+  // vblank
+  decrementTimers(_delay_timer.data(), _stride);
+  decrementTimers(_sound_timer.data(), _stride);
+
+  return {_frames.data(), _high_res.data(), _done.data()};
+}
+
+std::size_t Engine::lanes() const { return _lanes; }
+
+std::error_code Engine::error(std::size_t lane) const { return _errors[lane]; }
+
+Memory::Registers Engine::registers(std::size_t lane) const {
+  Memory::Registers registers;
+  for (std::size_t i = 0; i < Memory::REGISTERS; i++) {
+    registers.V[i] = _V[i][lane];
+    registers.RPL[i] = _RPL[i][lane];
+  }
+  for (std::size_t level = 0; level < Memory::STACK_SIZE; level++) {
+    registers.stack[level] = _stack[level][lane];
+  }
+  registers.I = _I[lane];
+  registers.pc = _pc[lane];
+  registers.sp = _sp[lane];
+  registers.delay_timer = _delay_timer[lane];
+  registers.sound_timer = _sound_timer[lane];
+  return registers;
+}
+
+void Engine::fail(std::size_t lane, std::error_code ec) {
+  _errors[lane] = ec;
+  _done[lane] = 1;
+}
+
+void Engine::cycle() {
+  // stopped lanes do not execute anything
+  std::copy(_done.begin(), _done.end(), _executed.begin());
+
+  std::size_t groups = 0;
+  for (std::size_t leader = 0; leader < _lanes; leader++) {
+    if (_executed[leader]) {
+      continue;
+    }
+
+    // too many groups: the lanes diverged, running the rest one by one
+    if (groups == MAX_VECTOR_GROUPS) {
+      for (std::size_t lane = leader; lane < _lanes; lane++) {
+        if (!_executed[lane]) {
+          executeLane(lane);
+        }
+      }
+      return;
+    }
+    groups++;
+
+    std::uint16_t pc = _pc[leader];
+    if (pc + 1 >= Memory::RAM_SIZE) {
+      executeLane(leader);
+      _executed[leader] = 1;
+      continue;
+    }
+
+    // group: the lanes at the same pc, with the same opcode there
+    std::uint8_t high = ram(pc, leader);
+    std::uint8_t low = ram(pc + 1, leader);
+    const std::uint8_t *ram_high = &_ram[pc * _stride];
+    const std::uint8_t *ram_low = &_ram[(pc + 1) * _stride];
+    std::fill_n(_mask.begin(), leader, 0);
+    std::size_t count = 0;
+    for (std::size_t lane = leader; lane < _lanes; lane++) {
+      bool member = !_executed[lane] && _pc[lane] == pc &&
+                    ram_high[lane] == high && ram_low[lane] == low;
+      _mask[lane] = member ? 0xFF : 0x00;
+      count += member;
+    }
+
+    Opcode opcode((high << 8) | low);
+    if (count < MIN_VECTOR_LANES || !executeVector(opcode)) {
+      for (std::size_t lane = leader; lane < _lanes; lane++) {
+        if (_mask[lane]) {
+          _pc[lane] += 2;
+          executeLaneOpcode(lane, opcode);
+        }
+      }
+    }
+
+    for (std::size_t lane = leader; lane < _lanes; lane++) {
+      _executed[lane] |= _mask[lane];
+    }
+  }
+}
+
+bool Engine::executeVector(const Opcode &opcode) {
+  const std::uint8_t *mask = _mask.data();
+  std::uint8_t *vx = _V[opcode.X].data();
+  std::uint8_t *vy = _V[opcode.Y].data();
+  std::uint8_t *vf = _V[0xF].data();
+  bool skips = false;
+
+  switch (opcode.category) {
+    case 0x1:
+      // JMP: 1NNN
+      for (std::size_t lane = 0; lane < _stride; lane++) {
+        _pc[lane] = mask[lane] ? opcode.NNN : _pc[lane];
+      }
+      return true;
+    case 0x3:
+      // SKIP_EQ: 3XNN
+      maskedCompare(vx, nullptr, opcode.NN, true, _skip.data(), mask, _stride);
+      skips = true;
+      break;
+    case 0x4:
+      // SKIP_NEQ: 4XNN
+      maskedCompare(vx, nullptr, opcode.NN, false, _skip.data(), mask,
+                    _stride);
+      skips = true;
+      break;
+    case 0x5:
+      // SKIP_EQ_REG: 5XY0
+      if (opcode.N != 0x0) {
+        return false;
+      }
+      maskedCompare(vx, vy, 0, true, _skip.data(), mask, _stride);
+      skips = true;
+      break;
+    case 0x6:
+      // SET: 6XNN
+      maskedApply<OpSet>(vx, nullptr, opcode.NN, vf, mask, _stride);
+      break;
+    case 0x7:
+      // ADD: 7XNN
+      maskedApply<OpAdd>(vx, nullptr, opcode.NN, vf, mask, _stride);
+      break;
+    case 0x8:
+      switch (opcode.N) {
+        case 0x0:
+          maskedApply<OpSet>(vx, vy, 0, vf, mask, _stride);
+          break;
+        case 0x1:
+          maskedApply<OpOr>(vx, vy, 0, vf, mask, _stride);
+          break;
+        case 0x2:
+          maskedApply<OpAnd>(vx, vy, 0, vf, mask, _stride);
+          break;
+        case 0x3:
+          maskedApply<OpXor>(vx, vy, 0, vf, mask, _stride);
+          break;
+        case 0x4:
+          maskedApply<OpAddCarry>(vx, vy, 0, vf, mask, _stride);
+          break;
+        case 0x5:
+          maskedApply<OpSubBorrow>(vx, vy, 0, vf, mask, _stride);
+          break;
+        case 0x6:
+          maskedApply<OpShr>(vx, vy, 0, vf, mask, _stride);
+          break;
+        case 0x7:
+          maskedApply<OpSubnBorrow>(vx, vy, 0, vf, mask, _stride);
+          break;
+        case 0xE:
+          maskedApply<OpShl>(vx, vy, 0, vf, mask, _stride);
+          break;
+        default:
+          return false;
+      }
+      break;
+    case 0x9:
+      // SKIP_NEQ_REG: 9XY0
+      maskedCompare(vx, vy, 0, false, _skip.data(), mask, _stride);
+      skips = true;
+      break;
+    case 0xA:
+      // SET_I: ANNN
+      for (std::size_t lane = 0; lane < _stride; lane++) {
+        _I[lane] = mask[lane] ? opcode.NNN : _I[lane];
+      }
+      break;
+    default:
+      return false;
+  }
+
+  // instructions are 2 bytes long (and skipping adds another 2)
+  if (skips) {
+    for (std::size_t lane = 0; lane < _stride; lane++) {
+      _pc[lane] += (mask[lane] & 2) + (_skip[lane] & 2);
+    }
+  } else {
+    for (std::size_t lane = 0; lane < _stride; lane++) {
+      _pc[lane] += mask[lane] & 2;
+    }
+  }
+  return true;
+}
+
+void Engine::executeLane(std::size_t lane) {
+  std::uint16_t pc = _pc[lane];
+  if (pc + 1 >= Memory::RAM_SIZE) {
+    fail(lane, Error::OUT_OF_RANGE);
+    return;
+  }
+
+  Opcode opcode((ram(pc, lane) << 8) | ram(pc + 1, lane));
+  // instructions are 2 bytes long
+  _pc[lane] += 2;
+  executeLaneOpcode(lane, opcode);
+}
+
+void Engine::executeLaneOpcode(std::size_t lane, const Opcode &opcode) {
+  std::uint8_t &vx = _V[opcode.X][lane];
+  std::uint8_t &vy = _V[opcode.Y][lane];
+  std::uint8_t &vf = _V[0xF][lane];
+  std::uint16_t &pc = _pc[lane];
+  std::uint16_t &I = _I[lane];
+  std::uint8_t flag = 0;
+
+  switch (opcode.category) {
+    case 0x0:
+      if (opcode.Y == 0xC) {
+        // SCROLL_DOWN: 00CN
+        scrollDown(lane, opcode.N);
+      } else if (opcode.raw == 0x00E0) {
+        // CLEAR: 00E0
+        std::memset(frame(lane), 0, FRAME_SIZE);
+      } else if (opcode.raw == 0x00EE) {
+        // RET: 00EE
+        if (_sp[lane] == 0) {
+          fail(lane, Error::STACK_UNDERFLOW);
+          return;
+        }
+        pc = _stack[--_sp[lane]][lane];
+      } else if (opcode.raw == 0x00FB) {
+        // SCROLL_RIGHT: 00FB
+        scrollHorizontal(lane, 4);
+      } else if (opcode.raw == 0x00FC) {
+        // SCROLL_LEFT: 00FC
+        scrollHorizontal(lane, -4);
+      } else if (opcode.raw == 0x00FD) {
+        // EXIT: 00FD
+        _done[lane] = 1;
+      } else if (opcode.raw == 0x00FE) {
+        // LOW: 00FE
+        _high_res[lane] = 0;
+      } else if (opcode.raw == 0x00FF) {
+        // HIGH: 00FF
+        _high_res[lane] = 1;
+      } else {
+        fail(lane, Error::UNKNOWN_OPCODE);
+      }
+      break;
+    case 0x1:
+      // JMP: 1NNN
+      pc = opcode.NNN;
+      break;
+    case 0x2:
+      // CALL: 2NNN
+      if (_sp[lane] >= Memory::STACK_SIZE) {
+        fail(lane, Error::STACK_OVERFLOW);
+        return;
+      }
+      _stack[_sp[lane]++][lane] = pc;
+      pc = opcode.NNN;
+      break;
+    case 0x3:
+      // SKIP_EQ: 3XNN
+      pc += vx == opcode.NN ? 2 : 0;
+      break;
+    case 0x4:
+      // SKIP_NEQ: 4XNN
+      pc += vx != opcode.NN ? 2 : 0;
+      break;
+    case 0x5:
+      // SKIP_EQ_REG: 5XY0 (the VM ignores N)
+      pc += vx == vy ? 2 : 0;
+      break;
+    case 0x6:
+      // SET: 6XNN
+      vx = opcode.NN;
+      break;
+    case 0x7:
+      // ADD: 7XNN
+      vx += opcode.NN;
+      break;
+    case 0x8:
+      switch (opcode.N) {
+        case 0x0:
+          vx = vy;
+          break;
+        case 0x1:
+          vx |= vy;
+          break;
+        case 0x2:
+          vx &= vy;
+          break;
+        case 0x3:
+          vx ^= vy;
+          break;
+        case 0x4:
+          vx = OpAddCarry::apply(vx, vy, flag);
+          vf = flag;
+          break;
+        case 0x5:
+          vx = OpSubBorrow::apply(vx, vy, flag);
+          vf = flag;
+          break;
+        case 0x6:
+          vx = OpShr::apply(vx, vy, flag);
+          vf = flag;
+          break;
+        case 0x7:
+          vx = OpSubnBorrow::apply(vx, vy, flag);
+          vf = flag;
+          break;
+        case 0xE:
+          vx = OpShl::apply(vx, vy, flag);
+          vf = flag;
+          break;
+        default:
+          fail(lane, Error::UNKNOWN_OPCODE);
+          break;
+      }
+      break;
+    case 0x9:
+      // SKIP_NEQ_REG: 9XY0
+      pc += vx != vy ? 2 : 0;
+      break;
+    case 0xA:
+      // SET_I: ANNN
+      I = opcode.NNN;
+      break;
+    case 0xB:
+      // JMP_V0: BNNN (jumps to NNN + VX, like the VM)
+      pc = opcode.NNN + vx;
+      break;
+    case 0xC: {
+      // RAND: CXNN (xorshift32)
+      std::uint32_t state = _rng[lane];
+      state ^= state << 13;
+      state ^= state >> 17;
+      state ^= state << 5;
+      _rng[lane] = state;
+      vx = (state & 0xFF) & opcode.NN;
+      break;
+    }
+    case 0xD: {
+      // DISP: DXYN / DXY0
+      std::uint8_t height = opcode.N == 0x0 ? 16 : opcode.N;
+      std::uint8_t width = opcode.N == 0x0 ? 16 : 8;
+      // same bounds as the VM (RAM::isSizeReadable)
+      if (I >= Memory::RAM_SIZE ||
+          I + height * (width / 8) > Memory::RAM_SIZE) {
+        fail(lane, Error::OUT_OF_RANGE);
+        return;
+      }
+      std::array<std::uint8_t, 32> data;
+      for (std::uint8_t i = 0; i < height * (width / 8); i++) {
+        data[i] = ram(I + i, lane);
+      }
+      std::uint8_t x = vx;
+      std::uint8_t y = vy;
+      vf = addSprite(lane, data.data(), height, width, x, y);
+      break;
+    }
+    case 0xE: {
+      bool pressed = vx < 16 && (_keys[lane] & (1 << vx));
+      if (opcode.NN == 0x9E) {
+        // SKIP_KEY: EX9E
+        pc += pressed ? 2 : 0;
+      } else if (opcode.NN == 0xA1) {
+        // SKIP_NKEY: EXA1
+        pc += pressed ? 0 : 2;
+      } else {
+        fail(lane, Error::UNKNOWN_OPCODE);
+      }
+      break;
+    }
+    case 0xF:
+      switch (opcode.NN) {
+        case 0x07:
+          vx = _delay_timer[lane];
+          break;
+        case 0x0A: {
+          // WAIT_KEY: FX0A, same press and release logic as the VM
+          std::int8_t &awaiting = _key_awaiting_release[lane];
+          if (awaiting < 0) {
+            for (std::uint8_t key = 0; key < 16; key++) {
+              if (_keys[lane] & (1 << key)) {
+                awaiting = key;
+                break;
+              }
+            }
+          } else if (!(_keys[lane] & (1 << awaiting))) {
+            vx = awaiting;
+            awaiting = -1;
+            break;
+          }
+          pc -= 2;
+          break;
+        }
+        case 0x15:
+          _delay_timer[lane] = vx;
+          break;
+        case 0x18:
+          _sound_timer[lane] = vx;
+          break;
+        case 0x1E:
+          I += vx;
+          break;
+        case 0x29:
+          I = (vx % 0x10) * FONT_HEIGHT_LOW_RES;
+          break;
+        case 0x30:
+          I = (vx % 0x10) * FONT_HEIGHT_HIGH_RES + FONT_SIZE_LOW_RES;
+          break;
+        case 0x33:
+          if (I + 2 >= Memory::RAM_SIZE) {
+            fail(lane, Error::OUT_OF_RANGE);
+            return;
+          }
+          ram(I, lane) = vx / 100;
+          ram(I + 1, lane) = (vx / 10) % 10;
+          ram(I + 2, lane) = vx % 10;
+          break;
+        case 0x55:
+          if (I + opcode.X >= Memory::RAM_SIZE) {
+            fail(lane, Error::OUT_OF_RANGE);
+            return;
+          }
+          for (std::uint8_t i = 0; i <= opcode.X; i++) {
+            ram(I + i, lane) = _V[i][lane];
+          }
+          break;
+        case 0x65:
+          if (I + opcode.X >= Memory::RAM_SIZE) {
+            fail(lane, Error::OUT_OF_RANGE);
+            return;
+          }
+          for (std::uint8_t i = 0; i <= opcode.X; i++) {
+            _V[i][lane] = ram(I + i, lane);
+          }
+          break;
+        case 0x75:
+          for (std::uint8_t i = 0; i <= opcode.X; i++) {
+            _RPL[i][lane] = _V[i][lane];
+          }
+          break;
+        case 0x85:
+          for (std::uint8_t i = 0; i <= opcode.X; i++) {
+            _V[i][lane] = _RPL[i][lane];
+          }
+          break;
+        default:
+          fail(lane, Error::UNKNOWN_OPCODE);
+          break;
+      }
+      break;
+  }
+}
+
+bool Engine::addSprite(std::size_t lane, const std::uint8_t *data,
+                       std::uint8_t height, std::uint8_t width, std::uint8_t x,
+                       std::uint8_t y) {
+  std::uint8_t *pixels = frame(lane);
+  int screen_width = _high_res[lane] ? HIGH_RES_VIRTUAL_SCREEN_WIDTH
+                                     : LOW_RES_VIRTUAL_SCREEN_WIDTH;
+  int screen_height = _high_res[lane] ? HIGH_RES_VIRTUAL_SCREEN_HEIGHT
+                                      : LOW_RES_VIRTUAL_SCREEN_HEIGHT;
+  bool collision = false;
+
+  for (int row = 0; row < height; row++) {
+    // sprite row, left aligned on 16 bits
+    std::uint16_t bits = width == 16 ? (data[row * 2] << 8) | data[row * 2 + 1]
+                                     : data[row] << 8;
+    std::uint8_t *screen_row = &pixels[((y + row) % screen_height) *
+                                       FRAME_ROW_BYTES];
+    for (int column = 0; bits != 0; column++, bits <<= 1) {
+      if (bits & 0x8000) {
+        // wrapping around the screen
+        int wrap_x = (x + column) % screen_width;
+        std::uint8_t bit = 0x80 >> (wrap_x % 8);
+        collision = collision || (screen_row[wrap_x / 8] & bit);
+        screen_row[wrap_x / 8] ^= bit;
+      }
+    }
+  }
+
+  return collision;
+}
+
+void Engine::scrollDown(std::size_t lane, std::uint8_t n) {
+  std::uint8_t *pixels = frame(lane);
+  int height = _high_res[lane] ? HIGH_RES_VIRTUAL_SCREEN_HEIGHT
+                               : LOW_RES_VIRTUAL_SCREEN_HEIGHT;
+  for (int row = height - 1; row >= n; row--) {
+    std::memcpy(&pixels[row * FRAME_ROW_BYTES],
+                &pixels[(row - n) * FRAME_ROW_BYTES], FRAME_ROW_BYTES);
+  }
+  std::memset(pixels, 0, std::min<int>(n, height) * FRAME_ROW_BYTES);
+}
+
+void Engine::scrollHorizontal(std::size_t lane, int n) {
+  std::uint8_t *pixels = frame(lane);
+  int width = _high_res[lane] ? HIGH_RES_VIRTUAL_SCREEN_WIDTH
+                              : LOW_RES_VIRTUAL_SCREEN_WIDTH;
+  int height = _high_res[lane] ? HIGH_RES_VIRTUAL_SCREEN_HEIGHT
+                               : LOW_RES_VIRTUAL_SCREEN_HEIGHT;
+  for (int row = 0; row < height; row++) {
+    std::uint8_t *screen_row = &pixels[row * FRAME_ROW_BYTES];
+    std::array<std::uint8_t, FRAME_ROW_BYTES> shifted = {0};
+    for (int x = 0; x < width; x++) {
+      int source = x - n;
+      if (source >= 0 && source < width &&
+          (screen_row[source / 8] & (0x80 >> (source % 8)))) {
+        shifted[x / 8] |= 0x80 >> (x % 8);
+      }
+    }
+    std::memcpy(screen_row, shifted.data(), FRAME_ROW_BYTES);
+  }
+}
+
+}  // namespace SuperChip8::Emulator::Batch
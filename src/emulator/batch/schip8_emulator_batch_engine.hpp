@@ -0,0 +1,155 @@
+#ifndef SUPERCHIP8_EMULATOR_BATCH_ENGINE_HPP
+#define SUPERCHIP8_EMULATOR_BATCH_ENGINE_HPP
+
+#include "schip8_emulator_memory_ram.hpp"
+#include "schip8_emulator_memory_registers.hpp"
+#include "schip8_emulator_opcode.hpp"
+#include "schip8_system_graphics_display.hpp"
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace SuperChip8::Emulator::Batch {
+
+// size of a packed framebuffer (see System::Graphics::Frame)
+constexpr std::size_t FRAME_SIZE =
+    System::Graphics::FRAME_ROW_BYTES *
+    System::Graphics::HIGH_RES_VIRTUAL_SCREEN_HEIGHT;
+
+/// @brief Lockstep batch engine, runs the same program in many environments
+/// (lanes) that only differ by their input and random seed
+///
+/// @details The machine state is stored as structure-of-arrays: each register
+/// (V0 to VF, I, pc, sp, timers, stack levels) and each RAM address is an
+/// array with one entry per lane. Every cycle, the lanes are grouped by
+/// program counter (and opcode, as the RAM can be modified): the ALU, skip
+/// and jump opcodes of a group run for all its lanes at once with the SIMD
+/// kernels of schip8_emulator_batch_simd.hpp, the other opcodes (draw, memory,
+/// stack, keys...) and groups too small or too many (divergence) fall back to
+/// a per lane interpreter with the VM semantics.
+///
+/// Unlike the VM, CXNN uses a per lane xorshift32 generator seeded by reset(),
+/// and the environments have no devices: the keys come from step() and the
+/// observations are packed framebuffers.
+class Engine {
+ public:
+  /// @brief Observation returned by reset() and step(), valid until the next
+  /// call
+  struct Observation {
+    // lane-major packed framebuffers, FRAME_SIZE bytes per lane
+    const std::uint8_t *frames;
+    // 1 if the lane is in 128x64, 0 if in 64x32
+    const std::uint8_t *high_res;
+    // 1 once the lane exited (00FD) or failed (see error())
+    const std::uint8_t *done;
+  };
+
+  /// @param lanes Number of environments
+  /// @param target_cycles CPU cycles per step
+  Engine(std::size_t lanes, std::uint16_t target_cycles);
+
+  /// @brief Load the program run by every lane
+  /// @param program_path Path to the program to load
+  /// @param ec error_code
+  ///
+  /// - Error::FILE_NOT_FOUND | If the file cannot be opened
+  ///
+  /// - Error::OUT_OF_RANGE | If the program is too large to fit in memory
+  void loadProgram(const std::string &program_path, std::error_code &ec);
+
+  /// @brief Restart every lane from the loaded program
+  /// @param seeds Random seed of each lane (lanes() entries)
+  /// @return the initial observation
+  Observation reset(const std::vector<std::uint32_t> &seeds);
+
+  /// @brief Run one frame (target cycles and vblank) on every running lane
+  /// @param actions Keypad state of each lane for this frame, one bit per key
+  /// (bit N set: key N down), lanes() entries
+  /// @return the observation after the frame
+  Observation step(const std::vector<std::uint16_t> &actions);
+
+  /// @return the number of environments
+  std::size_t lanes() const;
+
+  /// @return the error that stopped a lane, if any
+  std::error_code error(std::size_t lane) const;
+
+  /// @return a copy of the registers of a lane, to compare it with the VM
+  /// (see Memory::Registers::hash())
+  Memory::Registers registers(std::size_t lane) const;
+
+ private:
+  /// @brief Execute one instruction on every running lane
+  void cycle();
+
+  /// @brief Execute an opcode for all the lanes of the group mask
+  /// @return `false` if the opcode has no vector implementation
+  bool executeVector(const Opcode &opcode);
+
+  /// @brief Execute the instruction at the pc of a lane (per lane fallback)
+  void executeLane(std::size_t lane);
+
+  /// @brief Execute an already fetched opcode on a lane (pc already advanced)
+  void executeLaneOpcode(std::size_t lane, const Opcode &opcode);
+
+  /// @brief Stop a lane with an error
+  void fail(std::size_t lane, std::error_code ec);
+
+  std::uint8_t &ram(std::uint16_t address, std::size_t lane) {
+    return _ram[address * _stride + lane];
+  }
+  std::uint8_t *frame(std::size_t lane) { return &_frames[lane * FRAME_SIZE]; }
+
+  /// @brief Draw a sprite on the packed framebuffer of a lane (wrapping)
+  /// @return `true` if a collision occurred
+  bool addSprite(std::size_t lane, const std::uint8_t *data,
+                 std::uint8_t height, std::uint8_t width, std::uint8_t x,
+                 std::uint8_t y);
+  void scrollDown(std::size_t lane, std::uint8_t n);
+  void scrollHorizontal(std::size_t lane, int n);
+
+  std::size_t _lanes;
+  // lanes rounded up to LANE_ALIGNMENT, the size of every per lane array
+  std::size_t _stride;
+  std::uint16_t _target_cycles;
+
+  std::vector<std::uint8_t> _program;
+
+  // REGISTERS, one entry per lane
+  std::array<std::vector<std::uint8_t>, Memory::REGISTERS> _V;
+  std::array<std::vector<std::uint8_t>, Memory::REGISTERS> _RPL;
+  std::vector<std::uint16_t> _I;
+  std::vector<std::uint16_t> _pc;
+  std::vector<std::uint8_t> _sp;
+  std::array<std::vector<std::uint16_t>, Memory::STACK_SIZE> _stack;
+  std::vector<std::uint8_t> _delay_timer;
+  std::vector<std::uint8_t> _sound_timer;
+
+  // RAM, address-major: _ram[address * _stride + lane]
+  std::vector<std::uint8_t> _ram;
+
+  // DISPLAY
+  std::vector<std::uint8_t> _frames;
+  std::vector<std::uint8_t> _high_res;
+
+  // INPUT
+  std::vector<std::uint16_t> _keys;
+  std::vector<std::int8_t> _key_awaiting_release;
+
+  std::vector<std::uint32_t> _rng;
+  std::vector<std::uint8_t> _done;
+  std::vector<std::error_code> _errors;
+
+  // per cycle scratch: lanes of the current group, lanes already executed,
+  // lanes skipping their next instruction
+  std::vector<std::uint8_t> _mask;
+  std::vector<std::uint8_t> _executed;
+  std::vector<std::uint8_t> _skip;
+};
+
+}  // namespace SuperChip8::Emulator::Batch
+
+#endif  // SUPERCHIP8_EMULATOR_BATCH_ENGINE_HPP
@@ -0,0 +1,344 @@
+#ifndef SUPERCHIP8_EMULATOR_BATCH_SIMD_HPP
+#define SUPERCHIP8_EMULATOR_BATCH_SIMD_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__AVX2__) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
+namespace SuperChip8::Emulator::Batch {
+
+/** Masked lane kernels
+ *
+ * The lockstep engine keeps every register as an array with one byte per
+ * lane, and executes an opcode for all the lanes of a group at once: a lane
+ * takes part when its byte in `mask` is 0xFF (0x00 otherwise). Arrays are
+ * padded to LANE_ALIGNMENT lanes, so the kernels never have a tail to handle.
+ *
+ * Each operation provides the same computation for 32 lanes (AVX2), 16 lanes
+ * (SSE2) and one lane (scalar fallback), the widest one available at compile
+ * time is used (see NATIVE_ARCH in CMakeLists.txt to enable AVX2).
+ */
+
+#if defined(__AVX2__)
+constexpr std::size_t LANE_ALIGNMENT = 32;
+#else
+constexpr std::size_t LANE_ALIGNMENT = 16;
+#endif
+
+// ALU operations of 8XYN (and 6XNN/7XNN, with y broadcast)
+// `flag` receives the VF value of the operation, when it has one
+struct OpSet {
+  static constexpr bool HAS_FLAG = false;
+  static std::uint8_t apply(std::uint8_t, std::uint8_t y, std::uint8_t &) {
+    return y;
+  }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i, __m256i y, __m256i &) { return y; }
+#elif defined(__SSE2__)
+  static __m128i apply(__m128i, __m128i y, __m128i &) { return y; }
+#endif
+};
+
+struct OpOr {
+  static constexpr bool HAS_FLAG = false;
+  static std::uint8_t apply(std::uint8_t x, std::uint8_t y, std::uint8_t &) {
+    return x | y;
+  }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i x, __m256i y, __m256i &) {
+    return _mm256_or_si256(x, y);
+  }
+#elif defined(__SSE2__)
+  static __m128i apply(__m128i x, __m128i y, __m128i &) {
+    return _mm_or_si128(x, y);
+  }
+#endif
+};
+
+struct OpAnd {
+  static constexpr bool HAS_FLAG = false;
+  static std::uint8_t apply(std::uint8_t x, std::uint8_t y, std::uint8_t &) {
+    return x & y;
+  }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i x, __m256i y, __m256i &) {
+    return _mm256_and_si256(x, y);
+  }
+#elif defined(__SSE2__)
+  static __m128i apply(__m128i x, __m128i y, __m128i &) {
+    return _mm_and_si128(x, y);
+  }
+#endif
+};
+
+struct OpXor {
+  static constexpr bool HAS_FLAG = false;
+  static std::uint8_t apply(std::uint8_t x, std::uint8_t y, std::uint8_t &) {
+    return x ^ y;
+  }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i x, __m256i y, __m256i &) {
+    return _mm256_xor_si256(x, y);
+  }
+#elif defined(__SSE2__)
+  static __m128i apply(__m128i x, __m128i y, __m128i &) {
+    return _mm_xor_si128(x, y);
+  }
+#endif
+};
+
+// 7XNN (no flag)
+struct OpAdd {
+  static constexpr bool HAS_FLAG = false;
+  static std::uint8_t apply(std::uint8_t x, std::uint8_t y, std::uint8_t &) {
+    return x + y;
+  }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i x, __m256i y, __m256i &) {
+    return _mm256_add_epi8(x, y);
+  }
+#elif defined(__SSE2__)
+  static __m128i apply(__m128i x, __m128i y, __m128i &) {
+    return _mm_add_epi8(x, y);
+  }
+#endif
+};
+
+// 8XY4: VF = carry
+struct OpAddCarry {
+  static constexpr bool HAS_FLAG = true;
+  static std::uint8_t apply(std::uint8_t x, std::uint8_t y,
+                            std::uint8_t &flag) {
+    flag = (x + y) >> 8;
+    return x + y;
+  }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i x, __m256i y, __m256i &flag) {
+    __m256i sum = _mm256_add_epi8(x, y);
+    // carry if the saturated sum differs from the wrapped one
+    flag = _mm256_and_si256(
+        _mm256_xor_si256(_mm256_cmpeq_epi8(_mm256_adds_epu8(x, y), sum),
+                         _mm256_set1_epi8(-1)),
+        _mm256_set1_epi8(1));
+    return sum;
+  }
+#elif defined(__SSE2__)
+  static __m128i apply(__m128i x, __m128i y, __m128i &flag) {
+    __m128i sum = _mm_add_epi8(x, y);
+    flag = _mm_andnot_si128(_mm_cmpeq_epi8(_mm_adds_epu8(x, y), sum),
+                            _mm_set1_epi8(1));
+    return sum;
+  }
+#endif
+};
+
+// 8XY5: VF = not borrow (x >= y)
+struct OpSubBorrow {
+  static constexpr bool HAS_FLAG = true;
+  static std::uint8_t apply(std::uint8_t x, std::uint8_t y,
+                            std::uint8_t &flag) {
+    flag = x >= y ? 1 : 0;
+    return x - y;
+  }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i x, __m256i y, __m256i &flag) {
+    flag = _mm256_and_si256(_mm256_cmpeq_epi8(_mm256_max_epu8(x, y), x),
+                            _mm256_set1_epi8(1));
+    return _mm256_sub_epi8(x, y);
+  }
+#elif defined(__SSE2__)
+  static __m128i apply(__m128i x, __m128i y, __m128i &flag) {
+    flag = _mm_and_si128(_mm_cmpeq_epi8(_mm_max_epu8(x, y), x),
+                         _mm_set1_epi8(1));
+    return _mm_sub_epi8(x, y);
+  }
+#endif
+};
+
+// 8XY7: VX = VY - VX, VF = not borrow (y >= x)
+struct OpSubnBorrow {
+  static constexpr bool HAS_FLAG = true;
+  static std::uint8_t apply(std::uint8_t x, std::uint8_t y,
+                            std::uint8_t &flag) {
+    return OpSubBorrow::apply(y, x, flag);
+  }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i x, __m256i y, __m256i &flag) {
+    return OpSubBorrow::apply(y, x, flag);
+  }
+#elif defined(__SSE2__)
+  static __m128i apply(__m128i x, __m128i y, __m128i &flag) {
+    return OpSubBorrow::apply(y, x, flag);
+  }
+#endif
+};
+
+// 8XY6: VX >>= 1, VF = lsb
+struct OpShr {
+  static constexpr bool HAS_FLAG = true;
+  static std::uint8_t apply(std::uint8_t x, std::uint8_t, std::uint8_t &flag) {
+    flag = x & 0x1;
+    return x >> 1;
+  }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i x, __m256i, __m256i &flag) {
+    flag = _mm256_and_si256(x, _mm256_set1_epi8(1));
+    return _mm256_and_si256(_mm256_srli_epi16(x, 1), _mm256_set1_epi8(0x7F));
+  }
+#elif defined(__SSE2__)
+  static __m128i apply(__m128i x, __m128i, __m128i &flag) {
+    flag = _mm_and_si128(x, _mm_set1_epi8(1));
+    return _mm_and_si128(_mm_srli_epi16(x, 1), _mm_set1_epi8(0x7F));
+  }
+#endif
+};
+
+// 8XYE: VX <<= 1, VF = msb
+struct OpShl {
+  static constexpr bool HAS_FLAG = true;
+  static std::uint8_t apply(std::uint8_t x, std::uint8_t, std::uint8_t &flag) {
+    flag = (x & 0x80) >> 7;
+    return x << 1;
+  }
+#if defined(__AVX2__)
+  static __m256i apply(__m256i x, __m256i, __m256i &flag) {
+    flag = _mm256_and_si256(_mm256_srli_epi16(x, 7), _mm256_set1_epi8(1));
+    return _mm256_add_epi8(x, x);
+  }
+#elif defined(__SSE2__)
+  static __m128i apply(__m128i x, __m128i, __m128i &flag) {
+    flag = _mm_and_si128(_mm_srli_epi16(x, 7), _mm_set1_epi8(1));
+    return _mm_add_epi8(x, x);
+  }
+#endif
+};
+
+/// @brief vx = op(vx, vy) for the lanes of the mask, and vf = flag when the
+/// operation has one (written after vx, vf can alias vx or vy)
+/// @param vy Second operand, per lane (nullptr to use `constant` instead)
+template <typename Op>
+inline void maskedApply(std::uint8_t *vx, const std::uint8_t *vy,
+                        std::uint8_t constant, std::uint8_t *vf,
+                        const std::uint8_t *mask, std::size_t lanes) {
+  std::size_t lane = 0;
+#if defined(__AVX2__)
+  const __m256i broadcast = _mm256_set1_epi8(static_cast<char>(constant));
+  for (; lane < lanes; lane += 32) {
+    __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + lane));
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(vx + lane));
+    __m256i y = vy ? _mm256_loadu_si256(
+                         reinterpret_cast<const __m256i *>(vy + lane))
+                   : broadcast;
+    __m256i flag = _mm256_setzero_si256();
+    __m256i result = Op::apply(x, y, flag);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(vx + lane),
+                        _mm256_blendv_epi8(x, result, m));
+    if constexpr (Op::HAS_FLAG) {
+      __m256i f = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(vf + lane));
+      _mm256_storeu_si256(reinterpret_cast<__m256i *>(vf + lane),
+                          _mm256_blendv_epi8(f, flag, m));
+    }
+  }
+#elif defined(__SSE2__)
+  const __m128i broadcast = _mm_set1_epi8(static_cast<char>(constant));
+  for (; lane < lanes; lane += 16) {
+    __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + lane));
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(vx + lane));
+    __m128i y = vy ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(vy + lane))
+                   : broadcast;
+    __m128i flag = _mm_setzero_si128();
+    __m128i result = Op::apply(x, y, flag);
+    // SSE2 has no byte blend: (result & m) | (x & ~m)
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(vx + lane),
+                     _mm_or_si128(_mm_and_si128(m, result),
+                                  _mm_andnot_si128(m, x)));
+    if constexpr (Op::HAS_FLAG) {
+      __m128i f = _mm_loadu_si128(reinterpret_cast<const __m128i *>(vf + lane));
+      _mm_storeu_si128(reinterpret_cast<__m128i *>(vf + lane),
+                       _mm_or_si128(_mm_and_si128(m, flag),
+                                    _mm_andnot_si128(m, f)));
+    }
+  }
+#endif
+  // scalar fallback (and nothing left when a vector path ran)
+  for (; lane < lanes; lane++) {
+    std::uint8_t flag = 0;
+    std::uint8_t result = Op::apply(vx[lane], vy ? vy[lane] : constant, flag);
+    if (mask[lane]) {
+      vx[lane] = result;
+      if constexpr (Op::HAS_FLAG) {
+        vf[lane] = flag;
+      }
+    }
+  }
+}
+
+/// @brief skip[lane] = 0xFF where (vx == operand) == equal, for the lanes of
+/// the mask (3XNN, 4XNN, 5XY0, 9XY0)
+/// @param vy Second operand, per lane (nullptr to use `constant` instead)
+inline void maskedCompare(const std::uint8_t *vx, const std::uint8_t *vy,
+                          std::uint8_t constant, bool equal,
+                          std::uint8_t *skip, const std::uint8_t *mask,
+                          std::size_t lanes) {
+  std::size_t lane = 0;
+#if defined(__AVX2__)
+  const __m256i broadcast = _mm256_set1_epi8(static_cast<char>(constant));
+  const __m256i invert = equal ? _mm256_setzero_si256() : _mm256_set1_epi8(-1);
+  for (; lane < lanes; lane += 32) {
+    __m256i m = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(mask + lane));
+    __m256i x = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(vx + lane));
+    __m256i y = vy ? _mm256_loadu_si256(
+                         reinterpret_cast<const __m256i *>(vy + lane))
+                   : broadcast;
+    __m256i eq = _mm256_xor_si256(_mm256_cmpeq_epi8(x, y), invert);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(skip + lane),
+                        _mm256_and_si256(eq, m));
+  }
+#elif defined(__SSE2__)
+  const __m128i broadcast = _mm_set1_epi8(static_cast<char>(constant));
+  const __m128i invert = equal ? _mm_setzero_si128() : _mm_set1_epi8(-1);
+  for (; lane < lanes; lane += 16) {
+    __m128i m = _mm_loadu_si128(reinterpret_cast<const __m128i *>(mask + lane));
+    __m128i x = _mm_loadu_si128(reinterpret_cast<const __m128i *>(vx + lane));
+    __m128i y = vy ? _mm_loadu_si128(reinterpret_cast<const __m128i *>(vy + lane))
+                   : broadcast;
+    __m128i eq = _mm_xor_si128(_mm_cmpeq_epi8(x, y), invert);
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(skip + lane),
+                     _mm_and_si128(eq, m));
+  }
+#endif
+  for (; lane < lanes; lane++) {
+    bool eq = vx[lane] == (vy ? vy[lane] : constant);
+    skip[lane] = (eq == equal) ? mask[lane] : 0;
+  }
+}
+
+/// @brief Decrement the non zero timers (vblank)
+inline void decrementTimers(std::uint8_t *timers, std::size_t lanes) {
+  std::size_t lane = 0;
+#if defined(__AVX2__)
+  const __m256i one = _mm256_set1_epi8(1);
+  for (; lane < lanes; lane += 32) {
+    __m256i t = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(timers + lane));
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(timers + lane),
+                        _mm256_subs_epu8(t, one));
+  }
+#elif defined(__SSE2__)
+  const __m128i one = _mm_set1_epi8(1);
+  for (; lane < lanes; lane += 16) {
+    __m128i t = _mm_loadu_si128(reinterpret_cast<const __m128i *>(timers + lane));
+    _mm_storeu_si128(reinterpret_cast<__m128i *>(timers + lane),
+                     _mm_subs_epu8(t, one));
+  }
+#endif
+  for (; lane < lanes; lane++) {
+    timers[lane] -= timers[lane] > 0;
+  }
+}
+
+}  // namespace SuperChip8::Emulator::Batch
+
+#endif  // SUPERCHIP8_EMULATOR_BATCH_SIMD_HPP
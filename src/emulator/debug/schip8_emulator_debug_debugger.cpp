@@ -0,0 +1,601 @@
+#include "schip8_emulator_debug_debugger.hpp"
+#include "schip8_emulator_analysis_disassembler.hpp"
+
+#include <algorithm>
+#include <bit>
+#include <cctype>
+#include <cstdlib>
+#include <iomanip>
+#include <sstream>
+
+namespace SuperChip8::Emulator::Debug {
+
+namespace {
+
+constexpr std::uint32_t registerBit(std::uint8_t reg) { return 1u << reg; }
+
+// V0 to VX
+constexpr std::uint32_t registersUpTo(std::uint8_t x) {
+  return (1u << (x + 1)) - 1;
+}
+
+// VX to VY, in either order (5XY2 / 5XY3)
+constexpr std::uint32_t registersBetween(std::uint8_t x, std::uint8_t y) {
+  std::uint8_t low = std::min(x, y);
+  return registersUpTo(std::max(x, y)) & ~(registerBit(low) - 1);
+}
+
+// bytes read by F002 (see System::Audio::AUDIO_PATTERN_SIZE)
+constexpr std::uint16_t AUDIO_PATTERN_BYTES = 16;
+
+const char *HELP =
+    "c, continue            resume the execution\n"
+    "s, step [n]            execute n instructions (default: 1)\n"
+    "n, next                step, over a subroutine call (2NNN)\n"
+    "b, break <addr>        break when pc reaches addr\n"
+    "d, delete <addr>       remove the breakpoint at addr\n"
+    "w, watch <addr> [acc]  break on an access to the RAM at addr\n"
+    "wr, watchreg <reg> [acc]\n"
+    "                       break on an access to a register (V0 to VF, I)\n"
+    "                       acc: r, w (default), rw, or off to remove\n"
+    "r, regs                print the registers\n"
+    "bt, stack              print the call stack\n"
+    "x <addr> [n]           print n bytes of RAM from addr (default: 16)\n"
+    "i, info                list the breakpoints and watchpoints\n"
+    "q, quit                stop the VM\n"
+    "h, help                print this help\n";
+
+/// @brief Parse a hexadecimal address (ie: 2a0 or 0x2a0)
+bool parseAddress(std::istream &args, std::uint16_t &address) {
+  std::string token;
+  if (!(args >> token)) {
+    return false;
+  }
+  std::size_t end = 0;
+  unsigned long value = 0;
+  try {
+    value = std::stoul(token, &end, 16);
+  } catch (const std::exception &) {
+    return false;
+  }
+  if (end != token.size() || value >= Memory::XO_RAM_SIZE) {
+    return false;
+  }
+  address = value;
+  return true;
+}
+
+/// @brief Parse an access kind: r, w, rw or off (0), w if not given
+bool parseAccess(std::istream &args, std::uint8_t &access) {
+  std::string token;
+  if (!(args >> token) || token == "w") {
+    access = WRITE;
+  } else if (token == "r") {
+    access = READ;
+  } else if (token == "rw") {
+    access = READ_WRITE;
+  } else if (token == "off") {
+    access = 0;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/// @brief Parse a register name: V0 to VF or I
+bool parseRegister(std::istream &args, std::uint8_t &reg) {
+  std::string token;
+  if (!(args >> token)) {
+    return false;
+  }
+  if (token == "I" || token == "i") {
+    reg = REGISTER_I;
+    return true;
+  }
+  if (token.size() != 2 || (token[0] != 'V' && token[0] != 'v') ||
+      !std::isxdigit(static_cast<unsigned char>(token[1]))) {
+    return false;
+  }
+  reg = std::stoi(token.substr(1), nullptr, 16);
+  return true;
+}
+
+std::string registerName(std::uint8_t reg) {
+  if (reg == REGISTER_I) {
+    return "I";
+  }
+  std::ostringstream name;
+  name << "V" << std::uppercase << std::hex << static_cast<int>(reg);
+  return name.str();
+}
+
+std::string hex(std::uint16_t value, int width = 3) {
+  std::ostringstream out;
+  out << std::hex << std::setw(width) << std::setfill('0') << value;
+  return out.str();
+}
+
+}  // namespace
+
+template <typename Platform>
+Accesses accessesOf(const Opcode &opcode, const Memory::Registers &registers,
+                    std::uint8_t planes) {
+  Accesses accesses;
+  std::uint32_t vx = registerBit(opcode.X);
+  std::uint32_t vy = registerBit(opcode.Y);
+  std::uint32_t v0 = registerBit(0x0);
+  std::uint32_t vf = registerBit(0xF);
+  std::uint32_t i = registerBit(REGISTER_I);
+  // FX55 / FX65 leave I at I + X + 1
+  std::uint32_t i_incremented = Platform::LOAD_STORE_INCREMENTS_I ? i : 0;
+
+  switch (opcode.category) {
+    case 0x3:
+    case 0x4:
+    case 0xE:
+      accesses.registers_read = vx;
+      break;
+    case 0x5:
+      if (Platform::XO_CHIP && opcode.N == 0x2) {
+        accesses.registers_read = registersBetween(opcode.X, opcode.Y) | i;
+        accesses.ram_write_address = registers.I;
+        accesses.ram_write_size = std::abs(opcode.Y - opcode.X) + 1;
+      } else if (Platform::XO_CHIP && opcode.N == 0x3) {
+        accesses.registers_read = i;
+        accesses.registers_written = registersBetween(opcode.X, opcode.Y);
+        accesses.ram_read_address = registers.I;
+        accesses.ram_read_size = std::abs(opcode.Y - opcode.X) + 1;
+      } else {
+        accesses.registers_read = vx | vy;
+      }
+      break;
+    case 0x9:
+      accesses.registers_read = vx | vy;
+      break;
+    case 0x6:
+    case 0xC:
+      accesses.registers_written = vx;
+      break;
+    case 0x7:
+      accesses.registers_read = vx;
+      accesses.registers_written = vx;
+      break;
+    case 0x8:
+      switch (opcode.N) {
+        case 0x0:
+          accesses.registers_read = vy;
+          accesses.registers_written = vx;
+          break;
+        case 0x1:
+        case 0x2:
+        case 0x3:
+          accesses.registers_read = vx | vy;
+          accesses.registers_written = vx;
+          if constexpr (Platform::LOGIC_RESETS_VF) {
+            accesses.registers_written |= vf;
+          }
+          break;
+        case 0x4:
+        case 0x5:
+        case 0x7:
+          accesses.registers_read = vx | vy;
+          accesses.registers_written = vx | vf;
+          break;
+        case 0x6:
+        case 0xE:
+          // shift quirk: VX = VY shifted
+          accesses.registers_read = Platform::SHIFT_USES_VY ? vy : vx;
+          accesses.registers_written = vx | vf;
+          break;
+      }
+      break;
+    case 0xA:
+      accesses.registers_written = i;
+      break;
+    case 0xB:
+      accesses.registers_read = Platform::JUMP_USES_VX ? vx : v0;
+      break;
+    case 0xD: {
+      accesses.registers_read = vx | vy | i;
+      accesses.registers_written = vf;
+      accesses.ram_read_address = registers.I;
+      // a sprite per selected plane, one after the other
+      accesses.ram_read_size =
+          (opcode.N == 0 ? 32 : opcode.N) * std::popcount(planes);
+      break;
+    }
+    case 0xF:
+      if constexpr (Platform::XO_CHIP) {
+        if (opcode.raw == 0xF000) {
+          // the address is the next word
+          accesses.registers_written = i;
+          accesses.ram_read_address = registers.pc + 2;
+          accesses.ram_read_size = 2;
+          break;
+        }
+        if (opcode.raw == 0xF002) {
+          accesses.registers_read = i;
+          accesses.ram_read_address = registers.I;
+          accesses.ram_read_size = AUDIO_PATTERN_BYTES;
+          break;
+        }
+      }
+      switch (opcode.NN) {
+        case 0x07:
+        case 0x0A:
+          accesses.registers_written = vx;
+          break;
+        case 0x15:
+        case 0x18:
+          accesses.registers_read = vx;
+          break;
+        case 0x3A:
+          if constexpr (Platform::XO_CHIP) {
+            accesses.registers_read = vx;
+          }
+          break;
+        case 0x1E:
+          accesses.registers_read = vx | i;
+          accesses.registers_written = i;
+          break;
+        case 0x29:
+        case 0x30:
+          accesses.registers_read = vx;
+          accesses.registers_written = i;
+          break;
+        case 0x33:
+          accesses.registers_read = vx | i;
+          accesses.ram_write_address = registers.I;
+          accesses.ram_write_size = 3;
+          break;
+        case 0x55:
+          accesses.registers_read = registersUpTo(opcode.X) | i;
+          accesses.registers_written = i_incremented;
+          accesses.ram_write_address = registers.I;
+          accesses.ram_write_size = opcode.X + 1;
+          break;
+        case 0x65:
+          accesses.registers_read = i;
+          accesses.registers_written = registersUpTo(opcode.X) | i_incremented;
+          accesses.ram_read_address = registers.I;
+          accesses.ram_read_size = opcode.X + 1;
+          break;
+        case 0x75:
+          accesses.registers_read = registersUpTo(opcode.X);
+          break;
+        case 0x85:
+          accesses.registers_written = registersUpTo(opcode.X);
+          break;
+      }
+      break;
+  }
+  return accesses;
+}
+
+Debugger::Debugger(std::istream &in, std::ostream &out) : _in(in), _out(out) {}
+
+void Debugger::addBreakpoint(std::uint16_t address) {
+  _breakpoints.set(address);
+}
+
+void Debugger::removeBreakpoint(std::uint16_t address) {
+  _breakpoints.reset(address);
+}
+
+void Debugger::watchMemory(std::uint16_t address, std::uint8_t access) {
+  _memory_read_watchpoints.set(address, access & READ);
+  _memory_write_watchpoints.set(address, access & WRITE);
+  _memory_watchpoints =
+      (_memory_read_watchpoints | _memory_write_watchpoints).count();
+}
+
+void Debugger::watchRegister(std::uint8_t reg, std::uint8_t access) {
+  std::uint32_t bit = registerBit(reg);
+  _register_read_watchpoints =
+      access & READ ? _register_read_watchpoints | bit
+                    : _register_read_watchpoints & ~bit;
+  _register_write_watchpoints =
+      access & WRITE ? _register_write_watchpoints | bit
+                     : _register_write_watchpoints & ~bit;
+}
+
+void Debugger::pause() { _break_requested.store(true); }
+
+bool Debugger::isPaused() const { return _paused.load(); }
+
+template <typename Platform>
+bool Debugger::beforeStep(const Memory::BasicRAM<Platform::MEMORY_SIZE> &ram,
+                          const Memory::Registers &registers,
+                          std::uint8_t planes) {
+  std::string reason;
+  if (_break_requested.load()) {
+    _break_requested.store(false);
+    reason = "paused";
+  } else if (_steps > 0 && --_steps == 0) {
+    reason = "step";
+  } else if (_stepping_over && registers.pc == _step_over_pc &&
+             registers.sp == _step_over_sp) {
+    reason = "next";
+  } else if (_breakpoints[registers.pc]) {
+    reason = "breakpoint";
+  } else if (_memory_watchpoints > 0 || _register_read_watchpoints != 0 ||
+             _register_write_watchpoints != 0) {
+    std::error_code ec;
+    Opcode opcode(ram.readWord(registers.pc, ec));
+    if (!ec) {
+      reason = watchpointHit(accessesOf<Platform>(opcode, registers, planes));
+    }
+  }
+
+  if (reason.empty()) {
+    return true;
+  }
+
+  _steps = 0;
+  _stepping_over = false;
+  _out << reason << " at " << hex(registers.pc) << std::endl;
+  printInstruction(ram, registers.pc);
+  return prompt(ram, registers);
+}
+
+template <std::uint32_t SIZE>
+void Debugger::onFault(const std::error_code &ec,
+                       const Memory::BasicRAM<SIZE> &ram,
+                       const Memory::Registers &registers) {
+  // pc already points after the faulty instruction
+  std::uint16_t address = registers.pc - 2;
+  _out << "fault at " << hex(address) << ": " << ec.message() << std::endl;
+  printInstruction(ram, address);
+  printRegisters(registers);
+  _out << "the VM is stopped, quit or continue to exit" << std::endl;
+  prompt(ram, registers);
+}
+
+template <std::uint32_t SIZE>
+bool Debugger::prompt(const Memory::BasicRAM<SIZE> &ram,
+                      const Memory::Registers &registers) {
+  _paused.store(true);
+  std::string line;
+  while (true) {
+    _out << "(schip8) " << std::flush;
+    if (!std::getline(_in, line)) {
+      // no more commands
+      _paused.store(false);
+      return false;
+    }
+
+    std::istringstream args(line);
+    std::string command;
+    if (!(args >> command)) {
+      continue;
+    }
+
+    if (command == "c" || command == "continue") {
+      break;
+    } else if (command == "s" || command == "step") {
+      std::uint32_t steps = 1;
+      if (!(args >> steps)) {
+        steps = 1;
+      }
+      _steps = std::max<std::uint32_t>(steps, 1);
+      break;
+    } else if (command == "n" || command == "next") {
+      std::error_code ec;
+      Opcode opcode(ram.readWord(registers.pc, ec));
+      if (!ec && opcode.category == 0x2) {
+        // returns to the next instruction, at the same stack depth
+        _stepping_over = true;
+        _step_over_pc = registers.pc + 2;
+        _step_over_sp = registers.sp;
+      } else {
+        _steps = 1;
+      }
+      break;
+    } else if (command == "b" || command == "break") {
+      std::uint16_t address;
+      if (!parseAddress(args, address)) {
+        _out << "usage: break <addr>" << std::endl;
+        continue;
+      }
+      addBreakpoint(address);
+    } else if (command == "d" || command == "delete") {
+      std::uint16_t address;
+      if (!parseAddress(args, address)) {
+        _out << "usage: delete <addr>" << std::endl;
+        continue;
+      }
+      removeBreakpoint(address);
+    } else if (command == "w" || command == "watch") {
+      std::uint16_t address;
+      std::uint8_t access;
+      if (!parseAddress(args, address) || !parseAccess(args, access)) {
+        _out << "usage: watch <addr> [r|w|rw|off]" << std::endl;
+        continue;
+      }
+      watchMemory(address, access);
+    } else if (command == "wr" || command == "watchreg") {
+      std::uint8_t reg;
+      std::uint8_t access;
+      if (!parseRegister(args, reg) || !parseAccess(args, access)) {
+        _out << "usage: watchreg <V0..VF|I> [r|w|rw|off]" << std::endl;
+        continue;
+      }
+      watchRegister(reg, access);
+    } else if (command == "r" || command == "regs") {
+      printRegisters(registers);
+    } else if (command == "bt" || command == "stack") {
+      printStack(registers);
+    } else if (command == "x") {
+      std::uint16_t address;
+      std::uint16_t size = 16;
+      if (!parseAddress(args, address)) {
+        _out << "usage: x <addr> [n]" << std::endl;
+        continue;
+      }
+      if (!(args >> size)) {
+        size = 16;
+      }
+      printMemory(ram, address, size);
+    } else if (command == "i" || command == "info") {
+      printWatchpoints();
+    } else if (command == "q" || command == "quit") {
+      _paused.store(false);
+      return false;
+    } else if (command == "h" || command == "help") {
+      _out << HELP;
+    } else {
+      _out << "unknown command: " << command << " (see help)" << std::endl;
+    }
+  }
+  _paused.store(false);
+  return true;
+}
+
+std::string Debugger::watchpointHit(const Accesses &accesses) const {
+  std::uint32_t read = accesses.registers_read & _register_read_watchpoints;
+  std::uint32_t written =
+      accesses.registers_written & _register_write_watchpoints;
+  for (std::uint8_t reg = 0; reg <= REGISTER_I; reg++) {
+    if (read & registerBit(reg)) {
+      return "watchpoint (read " + registerName(reg) + ")";
+    }
+    if (written & registerBit(reg)) {
+      return "watchpoint (write " + registerName(reg) + ")";
+    }
+  }
+
+  if (_memory_watchpoints == 0) {
+    return {};
+  }
+  for (std::uint16_t offset = 0; offset < accesses.ram_read_size; offset++) {
+    std::uint16_t address = accesses.ram_read_address + offset;
+    if (_memory_read_watchpoints[address]) {
+      return "watchpoint (read " + hex(address) + ")";
+    }
+  }
+  for (std::uint16_t offset = 0; offset < accesses.ram_write_size; offset++) {
+    std::uint16_t address = accesses.ram_write_address + offset;
+    if (_memory_write_watchpoints[address]) {
+      return "watchpoint (write " + hex(address) + ")";
+    }
+  }
+  return {};
+}
+
+template <std::uint32_t SIZE>
+void Debugger::printInstruction(const Memory::BasicRAM<SIZE> &ram,
+                                std::uint16_t address) {
+  std::error_code ec;
+  std::uint16_t raw = ram.readWord(address, ec);
+  if (ec) {
+    _out << "  " << hex(address) << ": <out of range>" << std::endl;
+    return;
+  }
+  _out << "  " << hex(address) << ": " << hex(raw, 4) << "  "
+       << Analysis::disassemble(Opcode(raw)) << std::endl;
+}
+
+void Debugger::printRegisters(const Memory::Registers &registers) {
+  for (std::uint8_t reg = 0; reg < Memory::REGISTERS; reg++) {
+    _out << registerName(reg) << "=" << hex(registers.V[reg], 2)
+         << (reg % 8 == 7 ? "\n" : " ");
+  }
+  _out << "I=" << hex(registers.I) << " pc=" << hex(registers.pc)
+       << " sp=" << static_cast<int>(registers.sp)
+       << " DT=" << static_cast<int>(registers.delay_timer.load())
+       << " ST=" << static_cast<int>(registers.sound_timer.load())
+       << std::endl;
+}
+
+void Debugger::printStack(const Memory::Registers &registers) {
+  if (registers.sp == 0) {
+    _out << "empty stack" << std::endl;
+    return;
+  }
+  // innermost call first
+  for (std::uint8_t level = registers.sp; level > 0; level--) {
+    _out << "#" << static_cast<int>(registers.sp - level) << " return to "
+         << hex(registers.stack[level - 1]) << std::endl;
+  }
+}
+
+template <std::uint32_t SIZE>
+void Debugger::printMemory(const Memory::BasicRAM<SIZE> &ram,
+                           std::uint16_t address, std::uint16_t size) {
+  for (std::uint16_t offset = 0; offset < size; offset++) {
+    std::error_code ec;
+    std::uint8_t byte = ram.readByte(address + offset, ec);
+    if (ec) {
+      break;
+    }
+    if (offset % 16 == 0) {
+      _out << (offset == 0 ? "" : "\n") << hex(address + offset) << ":";
+    }
+    _out << " " << hex(byte, 2);
+  }
+  _out << std::endl;
+}
+
+void Debugger::printWatchpoints() {
+  for (std::uint32_t address = 0; address < Memory::XO_RAM_SIZE; address++) {
+    if (_breakpoints[address]) {
+      _out << "breakpoint " << hex(address) << std::endl;
+    }
+  }
+  for (std::uint32_t address = 0; address < Memory::XO_RAM_SIZE; address++) {
+    bool read = _memory_read_watchpoints[address];
+    bool write = _memory_write_watchpoints[address];
+    if (read || write) {
+      _out << "watch " << hex(address) << " " << (read ? "r" : "")
+           << (write ? "w" : "") << std::endl;
+    }
+  }
+  for (std::uint8_t reg = 0; reg <= REGISTER_I; reg++) {
+    bool read = _register_read_watchpoints & registerBit(reg);
+    bool write = _register_write_watchpoints & registerBit(reg);
+    if (read || write) {
+      _out << "watchreg " << registerName(reg) << " " << (read ? "r" : "")
+           << (write ? "w" : "") << std::endl;
+    }
+  }
+}
+
+template Accesses accessesOf<SuperChip>(
+    const Opcode &opcode, const Memory::Registers &registers,
+    std::uint8_t planes);
+template bool Debugger::beforeStep<SuperChip>(
+    const Memory::BasicRAM<SuperChip::MEMORY_SIZE> &ram,
+    const Memory::Registers &registers, std::uint8_t planes);
+template Accesses accessesOf<SuperChipModern>(
+    const Opcode &opcode, const Memory::Registers &registers,
+    std::uint8_t planes);
+template bool Debugger::beforeStep<SuperChipModern>(
+    const Memory::BasicRAM<SuperChipModern::MEMORY_SIZE> &ram,
+    const Memory::Registers &registers, std::uint8_t planes);
+template Accesses accessesOf<SuperChipLegacy>(
+    const Opcode &opcode, const Memory::Registers &registers,
+    std::uint8_t planes);
+template bool Debugger::beforeStep<SuperChipLegacy>(
+    const Memory::BasicRAM<SuperChipLegacy::MEMORY_SIZE> &ram,
+    const Memory::Registers &registers, std::uint8_t planes);
+template Accesses accessesOf<Chip8>(
+    const Opcode &opcode, const Memory::Registers &registers,
+    std::uint8_t planes);
+template bool Debugger::beforeStep<Chip8>(
+    const Memory::BasicRAM<Chip8::MEMORY_SIZE> &ram,
+    const Memory::Registers &registers, std::uint8_t planes);
+template Accesses accessesOf<XOChip>(
+    const Opcode &opcode, const Memory::Registers &registers,
+    std::uint8_t planes);
+template bool Debugger::beforeStep<XOChip>(
+    const Memory::BasicRAM<XOChip::MEMORY_SIZE> &ram,
+    const Memory::Registers &registers, std::uint8_t planes);
+
+template void Debugger::onFault(const std::error_code &ec,
+                                const Memory::RAM &ram,
+                                const Memory::Registers &registers);
+template void Debugger::onFault(
+    const std::error_code &ec, const Memory::BasicRAM<Memory::XO_RAM_SIZE> &ram,
+    const Memory::Registers &registers);
+
+}  // namespace SuperChip8::Emulator::Debug
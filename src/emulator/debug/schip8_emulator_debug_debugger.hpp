@@ -0,0 +1,156 @@
+#ifndef SUPERCHIP8_EMULATOR_DEBUG_DEBUGGER_HPP
+#define SUPERCHIP8_EMULATOR_DEBUG_DEBUGGER_HPP
+
+#include "schip8_emulator_memory_ram.hpp"
+#include "schip8_emulator_memory_registers.hpp"
+#include "schip8_emulator_opcode.hpp"
+#include "schip8_emulator_platform.hpp"
+
+#include <atomic>
+#include <bitset>
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <system_error>
+
+namespace SuperChip8::Emulator::Debug {
+
+// register index of I in the register watchpoints (V0 to VF are 0 to 15)
+constexpr std::uint8_t REGISTER_I = Memory::REGISTERS;
+
+/// @brief Kind of access of a watchpoint
+enum Access : std::uint8_t { READ = 1, WRITE = 2, READ_WRITE = READ | WRITE };
+
+/// @brief Registers and RAM accessed by an instruction
+struct Accesses {
+  // bit N: VN (bit REGISTER_I: I)
+  std::uint32_t registers_read = 0;
+  std::uint32_t registers_written = 0;
+  std::uint16_t ram_read_address = 0;
+  std::uint16_t ram_read_size = 0;
+  std::uint16_t ram_write_address = 0;
+  std::uint16_t ram_write_size = 0;
+};
+
+/// @brief Compute the registers and RAM an instruction is about to access
+/// @tparam Platform The platform of the VM: its instructions (XO-CHIP) and
+/// quirks change the accesses (see schip8_emulator_platform.hpp)
+/// @param opcode The instruction
+/// @param registers The registers before the instruction is executed (for I
+/// and pc)
+/// @param planes The display planes selected (XO-CHIP: DXYN reads a sprite
+/// per plane)
+/// @return the accesses
+template <typename Platform>
+Accesses accessesOf(const Opcode &opcode, const Memory::Registers &registers,
+                    std::uint8_t planes = 0x1);
+
+/// @brief Debug policy of VM::run() without debugger, the loop is not
+/// instrumented at all
+struct NoDebugger {
+  static constexpr bool ENABLED = false;
+};
+
+/// @brief Interactive debugger, debug policy of VM::run()
+///
+/// @details The instrumented CPU loop calls beforeStep() before each
+/// instruction. It breaks on the PC breakpoints (a bitmap indexed by PC), on
+/// the RAM and V/I watchpoints, after a step or a step over, and on faults,
+/// then reads commands (see `help`) until the execution is resumed. The
+/// debugger starts paused on the first instruction.
+///
+/// The execution is paused while a command is awaited: the CPU thread is
+/// blocked on the input stream, and the VM freezes the timers (see
+/// isPaused()).
+class Debugger {
+ public:
+  static constexpr bool ENABLED = true;
+
+  /// @param in The stream commands are read from
+  /// @param out The stream the debugger writes to
+  Debugger(std::istream &in = std::cin, std::ostream &out = std::cout);
+
+  void addBreakpoint(std::uint16_t address);
+  void removeBreakpoint(std::uint16_t address);
+
+  /// @brief Watch accesses to a RAM address
+  /// @param address The address to watch
+  /// @param access The accesses to break on (0 to remove the watchpoint)
+  void watchMemory(std::uint16_t address, std::uint8_t access);
+
+  /// @brief Watch accesses to a register
+  /// @param reg The register (0x0 to 0xF for V0 to VF, REGISTER_I for I)
+  /// @param access The accesses to break on (0 to remove the watchpoint)
+  void watchRegister(std::uint8_t reg, std::uint8_t access);
+
+  /// @brief Break before the next instruction
+  void pause();
+
+  /// @return `true` while the debugger is waiting for a command
+  bool isPaused() const;
+
+  /// @brief Called by the instrumented loop before each instruction
+  /// @tparam Platform The platform of the VM (see accessesOf())
+  /// @param ram The VM memory (RAM or XO-CHIP memory)
+  /// @param registers The VM registers (pc is the next instruction)
+  /// @param planes The display planes selected
+  /// @return `false` if the user quit, the VM is then stopped
+  template <typename Platform>
+  bool beforeStep(const Memory::BasicRAM<Platform::MEMORY_SIZE> &ram,
+                  const Memory::Registers &registers, std::uint8_t planes);
+
+  /// @brief Called by the instrumented loop when an instruction failed, for a
+  /// post-mortem inspection
+  /// @param ec The error raised by the instruction
+  /// @param ram The VM memory (RAM or XO-CHIP memory)
+  /// @param registers The VM registers
+  template <std::uint32_t SIZE>
+  void onFault(const std::error_code &ec, const Memory::BasicRAM<SIZE> &ram,
+               const Memory::Registers &registers);
+
+ private:
+  /// @brief Read and execute commands until the execution is resumed
+  /// @return `false` if the user quit
+  template <std::uint32_t SIZE>
+  bool prompt(const Memory::BasicRAM<SIZE> &ram,
+              const Memory::Registers &registers);
+
+  /// @return a description of the watchpoint hit by the accesses, empty if
+  /// none
+  std::string watchpointHit(const Accesses &accesses) const;
+
+  template <std::uint32_t SIZE>
+  void printInstruction(const Memory::BasicRAM<SIZE> &ram,
+                        std::uint16_t address);
+  void printRegisters(const Memory::Registers &registers);
+  void printStack(const Memory::Registers &registers);
+  template <std::uint32_t SIZE>
+  void printMemory(const Memory::BasicRAM<SIZE> &ram, std::uint16_t address,
+                   std::uint16_t size);
+  void printWatchpoints();
+
+  std::istream &_in;
+  std::ostream &_out;
+
+  // indexed by address, over the whole XO-CHIP address space
+  std::bitset<Memory::XO_RAM_SIZE> _breakpoints;
+  std::bitset<Memory::XO_RAM_SIZE> _memory_read_watchpoints;
+  std::bitset<Memory::XO_RAM_SIZE> _memory_write_watchpoints;
+  std::size_t _memory_watchpoints = 0;
+  std::uint32_t _register_read_watchpoints = 0;
+  std::uint32_t _register_write_watchpoints = 0;
+
+  // instructions left before breaking (0: no step in progress)
+  std::uint32_t _steps = 0;
+  // step over a CALL: break when returning to this pc at this stack depth
+  bool _stepping_over = false;
+  std::uint16_t _step_over_pc = 0;
+  std::uint8_t _step_over_sp = 0;
+
+  std::atomic<bool> _break_requested = true;
+  std::atomic<bool> _paused = false;
+};
+
+}  // namespace SuperChip8::Emulator::Debug
+
+#endif  // SUPERCHIP8_EMULATOR_DEBUG_DEBUGGER_HPP
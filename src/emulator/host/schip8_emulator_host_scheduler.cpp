@@ -0,0 +1,117 @@
+#include "schip8_emulator_host_scheduler.hpp"
+
+#include <algorithm>
+
+namespace SuperChip8::Emulator::Host {
+
+namespace {
+
+// index of the worker running on this thread, in its scheduler
+thread_local const Scheduler *t_scheduler = nullptr;
+thread_local unsigned t_worker_index = 0;
+
+}  // namespace
+
+Scheduler::Scheduler(unsigned workers) {
+  if (workers == 0) {
+    workers = std::max(1u, std::thread::hardware_concurrency());
+  }
+
+  for (unsigned i = 0; i < workers; i++) {
+    _queues.push_back(std::make_unique<WorkerQueue>());
+  }
+  for (unsigned i = 0; i < workers; i++) {
+    _workers.emplace_back(
+        [this, i](std::stop_token stop_token) { work(stop_token, i); });
+  }
+}
+
+Scheduler::~Scheduler() {
+  for (std::jthread &worker : _workers) {
+    worker.request_stop();
+  }
+  _work_cv.notify_all();
+  _workers.clear();
+}
+
+void Scheduler::submit(task_t task) {
+  unsigned index = t_scheduler == this
+                       ? t_worker_index
+                       : _next_queue.fetch_add(1) % _queues.size();
+
+  _pending.fetch_add(1);
+  {
+    std::lock_guard lock(_queues[index]->mutex);
+    _queues[index]->tasks.push_back(std::move(task));
+  }
+  {
+    // taking the lock so a worker going to sleep cannot miss the wake up
+    std::lock_guard lock(_sleep_mutex);
+  }
+  _work_cv.notify_one();
+}
+
+void Scheduler::wait() {
+  std::unique_lock lock(_sleep_mutex);
+  _done_cv.wait(lock, [this] { return _pending.load() == 0; });
+}
+
+unsigned Scheduler::workerCount() const { return _workers.size(); }
+
+bool Scheduler::findTask(unsigned index, task_t &task) {
+  // own queue first, newest task
+  {
+    WorkerQueue &queue = *_queues[index];
+    std::lock_guard lock(queue.mutex);
+    if (!queue.tasks.empty()) {
+      task = std::move(queue.tasks.back());
+      queue.tasks.pop_back();
+      return true;
+    }
+  }
+
+  // stealing the oldest task of the other queues
+  for (std::size_t i = 1; i < _queues.size(); i++) {
+    WorkerQueue &victim = *_queues[(index + i) % _queues.size()];
+    std::lock_guard lock(victim.mutex);
+    if (!victim.tasks.empty()) {
+      task = std::move(victim.tasks.front());
+      victim.tasks.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+void Scheduler::work(std::stop_token stop_token, unsigned index) {
+  t_scheduler = this;
+  t_worker_index = index;
+
+  task_t task;
+  while (!stop_token.stop_requested()) {
+    if (findTask(index, task)) {
+      task();
+      task = nullptr;
+      if (_pending.fetch_sub(1) == 1) {
+        std::lock_guard lock(_sleep_mutex);
+        _done_cv.notify_all();
+      }
+      continue;
+    }
+
+    // no task anywhere: sleeping until one is submitted
+    std::unique_lock lock(_sleep_mutex);
+    _work_cv.wait(lock, stop_token, [this] {
+      for (const std::unique_ptr<WorkerQueue> &queue : _queues) {
+        std::lock_guard queue_lock(queue->mutex);
+        if (!queue->tasks.empty()) {
+          return true;
+        }
+      }
+      return false;
+    });
+  }
+}
+
+}  // namespace SuperChip8::Emulator::Host
@@ -0,0 +1,81 @@
+#ifndef SUPERCHIP8_EMULATOR_HOST_SCHEDULER_HPP
+#define SUPERCHIP8_EMULATOR_HOST_SCHEDULER_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace SuperChip8::Emulator::Host {
+
+/// @brief Work-stealing scheduler, runs tasks on a fixed pool of worker
+/// threads
+///
+/// @details Each worker owns a task queue. A worker pops its own tasks from
+/// the back of its queue (LIFO, cache friendly) and, once it is empty, steals
+/// from the front of the other queues (FIFO), so an idle worker never waits
+/// while another one still has work queued. Tasks submitted from outside the
+/// pool are spread over the queues round robin, tasks submitted from a worker
+/// go to its own queue.
+class Scheduler {
+ public:
+  using task_t = std::function<void()>;
+
+  /// @param workers Number of worker threads (0: one per hardware thread)
+  explicit Scheduler(unsigned workers = 0);
+
+  /// @brief Stop the workers, the tasks still queued are dropped
+  ~Scheduler();
+
+  Scheduler(const Scheduler &) = delete;
+  Scheduler &operator=(const Scheduler &) = delete;
+
+  /// @brief Queue a task, can be called from any thread (including a task)
+  /// @param task The task to run
+  void submit(task_t task);
+
+  /// @brief Block until every submitted task has run
+  /// @details Must not be called from a task.
+  void wait();
+
+  /// @return the number of worker threads
+  unsigned workerCount() const;
+
+ private:
+  struct WorkerQueue {
+    std::mutex mutex;
+    std::deque<task_t> tasks;
+  };
+
+  /// @brief Worker loop
+  void work(std::stop_token stop_token, unsigned index);
+
+  /// @brief Pop a task from the worker own queue, or steal one
+  /// @param index The worker index
+  /// @param task The task found
+  /// @return `true` if a task was found
+  bool findTask(unsigned index, task_t &task);
+
+  std::vector<std::unique_ptr<WorkerQueue>> _queues;
+
+  // tasks submitted and not yet run
+  std::atomic<std::size_t> _pending = 0;
+  // used to spread the submitted tasks over the queues
+  std::atomic<std::size_t> _next_queue = 0;
+
+  // for sleeping workers (no task) and waiters (wait())
+  std::mutex _sleep_mutex;
+  std::condition_variable_any _work_cv;
+  std::condition_variable _done_cv;
+
+  std::vector<std::jthread> _workers;
+};
+
+}  // namespace SuperChip8::Emulator::Host
+
+#endif  // SUPERCHIP8_EMULATOR_HOST_SCHEDULER_HPP
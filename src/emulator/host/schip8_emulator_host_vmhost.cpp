@@ -0,0 +1,83 @@
+#include "schip8_emulator_host_vmhost.hpp"
+
+namespace SuperChip8::Emulator::Host {
+
+VMHost::VMHost(unsigned workers) : _scheduler(workers) {}
+
+VMHost::instance_id_t VMHost::addInstance(const std::string &program_path,
+                                          std::uint16_t target_cycles,
+                                          std::error_code &ec) {
+  auto instance = std::make_unique<Instance>(target_cycles);
+  instance->vm.boot(program_path, ec);
+  if (ec) {
+    return 0;
+  }
+
+  if (!_free_ids.empty()) {
+    instance_id_t id = _free_ids.back();
+    _free_ids.pop_back();
+    _instances[id] = std::move(instance);
+    return id;
+  }
+  _instances.push_back(std::move(instance));
+  return _instances.size() - 1;
+}
+
+void VMHost::removeInstance(instance_id_t id) {
+  _instances[id].reset();
+  _free_ids.push_back(id);
+}
+
+void VMHost::setKey(instance_id_t id, std::uint8_t key, bool pressed) {
+  std::uint16_t mask = 1 << (key & 0xF);
+  if (pressed) {
+    _instances[id]->keys.fetch_or(mask);
+  } else {
+    _instances[id]->keys.fetch_and(~mask);
+  }
+}
+
+void VMHost::runFrame() {
+  for (const std::unique_ptr<Instance> &instance : _instances) {
+    if (instance && instance->vm.isRunning()) {
+      Instance *running = instance.get();
+      _scheduler.submit([this, running] { runInstanceFrame(*running); });
+    }
+  }
+  _scheduler.wait();
+}
+
+void VMHost::runInstanceFrame(Instance &instance) {
+  std::uint16_t keys = instance.keys.load();
+  for (std::uint8_t key = 0; key < 16; key++) {
+    instance.vm.setKey(key, keys & (1 << key));
+  }
+
+  instance.vm.runFrame(instance.ec);
+
+  std::lock_guard lock(instance.frame_mutex);
+  instance.vm.display().packFrontBuffer(instance.frame);
+  instance.frame_count++;
+}
+
+std::uint64_t VMHost::frame(instance_id_t id,
+                            System::Graphics::Frame &frame) const {
+  const Instance &instance = *_instances[id];
+  std::lock_guard lock(instance.frame_mutex);
+  frame = instance.frame;
+  return instance.frame_count;
+}
+
+bool VMHost::isRunning(instance_id_t id) const {
+  return _instances[id]->vm.isRunning();
+}
+
+std::error_code VMHost::error(instance_id_t id) const {
+  return _instances[id]->ec;
+}
+
+std::size_t VMHost::instanceCount() const {
+  return _instances.size() - _free_ids.size();
+}
+
+}  // namespace SuperChip8::Emulator::Host
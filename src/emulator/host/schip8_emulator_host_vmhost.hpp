@@ -0,0 +1,99 @@
+#ifndef SUPERCHIP8_EMULATOR_HOST_VMHOST_HPP
+#define SUPERCHIP8_EMULATOR_HOST_VMHOST_HPP
+
+#include "schip8_emulator_host_scheduler.hpp"
+#include "schip8_emulator_vm.hpp"
+#include "schip8_system_graphics_display.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace SuperChip8::Emulator::Host {
+
+/// @brief In-process host running many headless VM instances on a fixed pool
+/// of worker threads
+///
+/// @details Each runFrame() call advances every running instance by one frame
+/// of CPU cycles (followed by its vblank), one task per instance on the
+/// work-stealing Scheduler. Instances own no thread and no window: their
+/// frames are published after each vblank and their keys are injected by the
+/// caller, from any thread.
+class VMHost {
+ public:
+  using instance_id_t = std::size_t;
+
+  /// @param workers Number of worker threads (0: one per hardware thread)
+  explicit VMHost(unsigned workers = 0);
+
+  /// @brief Create an instance and load its program
+  /// @param program_path Path to the program to load
+  /// @param target_cycles Target CPU cycles per frame
+  /// @param ec error_code, see VM::boot()
+  /// @return the instance id (valid until removeInstance())
+  instance_id_t addInstance(const std::string &program_path,
+                            std::uint16_t target_cycles, std::error_code &ec);
+
+  /// @brief Destroy an instance, its id can be reused by addInstance()
+  /// @details Must not be called during runFrame().
+  void removeInstance(instance_id_t id);
+
+  /// @brief Set the state of a keypad key of an instance
+  /// @details Can be called from any thread, it is applied before the next
+  /// frame of the instance.
+  /// @param id The instance id
+  /// @param key The keypad key (0x0 to 0xF)
+  /// @param pressed `true` if the key is down
+  void setKey(instance_id_t id, std::uint8_t key, bool pressed);
+
+  /// @brief Advance every running instance by one frame, in parallel
+  /// @details Blocks until all the instances have run their frame.
+  void runFrame();
+
+  /// @brief Copy the last frame published by an instance
+  /// @param id The instance id
+  /// @param frame The frame to fill
+  /// @return the number of frames the instance has run
+  std::uint64_t frame(instance_id_t id,
+                      System::Graphics::Frame &frame) const;
+
+  /// @return `true` while the program of the instance has not exited or failed
+  bool isRunning(instance_id_t id) const;
+
+  /// @return the error that stopped the instance, if any
+  std::error_code error(instance_id_t id) const;
+
+  /// @return the number of live instances
+  std::size_t instanceCount() const;
+
+ private:
+  struct Instance {
+    explicit Instance(std::uint16_t target_cycles) : vm(target_cycles) {}
+
+    VM vm;
+    // keypad state requested by setKey(), one bit per key
+    std::atomic<std::uint16_t> keys = 0;
+    std::error_code ec;
+
+    // last published frame
+    mutable std::mutex frame_mutex;
+    System::Graphics::Frame frame;
+    std::uint64_t frame_count = 0;
+  };
+
+  /// @brief Run one frame of an instance and publish it (worker task)
+  void runInstanceFrame(Instance &instance);
+
+  Scheduler _scheduler;
+  std::vector<std::unique_ptr<Instance>> _instances;
+  // ids of the removed instances
+  std::vector<instance_id_t> _free_ids;
+};
+
+}  // namespace SuperChip8::Emulator::Host
+
+#endif  // SUPERCHIP8_EMULATOR_HOST_VMHOST_HPP
@@ -1,63 +1,104 @@
 #include "schip8_emulator_memory_ram.hpp"
 #include "schip8_error.hpp"
 
+#include <algorithm>
+
 namespace SuperChip8::Emulator::Memory {
 
-void RAM::clear() { _memory.fill(0); }
+template <std::uint32_t SIZE>
+void BasicRAM<SIZE>::clear() {
+  _memory.clear();
+}
 
-void RAM::clearProgram() {
-  std::fill(_memory.begin() + ROM_START, _memory.end(), 0);
+template <std::uint32_t SIZE>
+void BasicRAM<SIZE>::clearProgram() {
+  for (std::uint16_t page = ROM_START / RAM_PAGE_SIZE; page < PAGES; page++) {
+    _memory.overwrite(page).fill(0);
+  }
 }
 
-void RAM::loadData(const std::uint8_t *data, std::size_t size,
-                   std::uint16_t offset, std::error_code &ec) {
-  if (offset + size > RAM_SIZE) {
+template <std::uint32_t SIZE>
+void BasicRAM<SIZE>::loadData(const std::uint8_t *data, std::size_t size,
+                              std::uint16_t offset, std::error_code &ec) {
+  if (offset + size > SIZE) {
     ec = Error::OUT_OF_RANGE;
     return;
   }
 
-  std::copy(data, data + size, _memory.begin() + offset);
+  // page by page
+  while (size > 0) {
+    std::uint16_t in_page = offset % RAM_PAGE_SIZE;
+    std::size_t count = std::min<std::size_t>(size, RAM_PAGE_SIZE - in_page);
+    std::copy(data, data + count,
+              _memory.write(offset / RAM_PAGE_SIZE).begin() + in_page);
+    data += count;
+    offset += count;
+    size -= count;
+  }
 }
 
-std::uint8_t RAM::readByte(std::uint16_t address, std::error_code &ec) const {
-  if (address >= RAM_SIZE) {
+template <std::uint32_t SIZE>
+std::uint8_t BasicRAM<SIZE>::readByte(std::uint16_t address,
+                                      std::error_code &ec) const {
+  if (address >= SIZE) {
     ec = Error::OUT_OF_RANGE;
     return 0;
   }
 
-  return _memory[address];
+  return _memory.read(address / RAM_PAGE_SIZE)[address % RAM_PAGE_SIZE];
 }
 
-std::uint16_t RAM::readWord(std::uint16_t address, std::error_code &ec) const {
-  if (address + 1 >= RAM_SIZE) {
+template <std::uint32_t SIZE>
+std::uint16_t BasicRAM<SIZE>::readWord(std::uint16_t address,
+                                       std::error_code &ec) const {
+  if (address + 1u >= SIZE) {
     ec = Error::OUT_OF_RANGE;
     return 0;
   }
 
-  return (_memory[address] << 8) | _memory[address + 1];
+  // the two bytes can be on different pages
+  std::uint16_t next = address + 1;
+  return (_memory.read(address / RAM_PAGE_SIZE)[address % RAM_PAGE_SIZE]
+          << 8) |
+         _memory.read(next / RAM_PAGE_SIZE)[next % RAM_PAGE_SIZE];
 }
 
-void RAM::writeByte(std::uint16_t address, std::uint8_t value,
-                    std::error_code &ec) {
-  if (address >= RAM_SIZE) {
+template <std::uint32_t SIZE>
+void BasicRAM<SIZE>::writeByte(std::uint16_t address, std::uint8_t value,
+                               std::error_code &ec) {
+  if (address >= SIZE) {
     ec = Error::OUT_OF_RANGE;
     return;
   }
 
-  _memory[address] = value;
+  _memory.write(address / RAM_PAGE_SIZE)[address % RAM_PAGE_SIZE] = value;
 }
 
-std::uint8_t *RAM::getBytePointer(std::uint16_t address, std::error_code &ec) {
-  if (address >= RAM_SIZE) {
+template <std::uint32_t SIZE>
+void BasicRAM<SIZE>::readData(std::uint16_t address, std::uint8_t *data,
+                              std::size_t size, std::error_code &ec) const {
+  if (address + size > SIZE) {
     ec = Error::OUT_OF_RANGE;
-    return nullptr;
+    return;
   }
 
-  return &_memory[address];
+  for (std::size_t i = 0; i < size; i++, address++) {
+    data[i] = _memory.read(address / RAM_PAGE_SIZE)[address % RAM_PAGE_SIZE];
+  }
+}
+
+template <std::uint32_t SIZE>
+bool BasicRAM<SIZE>::isSizeReadable(std::uint16_t address,
+                                    std::size_t size) const {
+  return address + size <= SIZE;
 }
 
-bool RAM::isSizeReadable(std::uint16_t address, std::size_t size) const {
-  return (address + size) < RAM_SIZE;
+template <std::uint32_t SIZE>
+std::size_t BasicRAM<SIZE>::sharedPages() const {
+  return _memory.sharedPages();
 }
 
+template class BasicRAM<RAM_SIZE>;
+template class BasicRAM<XO_RAM_SIZE>;
+
 }  // namespace SuperChip8::Emulator::Memory
@@ -1,6 +1,8 @@
 #ifndef SUPERCHIP8_EMULATOR_MEMORY_RAM_HPP
 #define SUPERCHIP8_EMULATOR_MEMORY_RAM_HPP
 
+#include "schip8_cowpages.hpp"
+
 #include <array>
 #include <cstdint>
 #include <system_error>
@@ -31,12 +33,28 @@ namespace SuperChip8::Emulator::Memory {
 constexpr std::uint16_t RAM_SIZE = 4096;
 constexpr std::uint16_t ROM_START = 0x200;
 
-class RAM {
+// XO-CHIP address space (0x0000 to 0xFFFF, same layout up to 0x1FF)
+constexpr std::uint32_t XO_RAM_SIZE = 65536;
+
+// The memory is split in pages shared copy-on-write between copies of the RAM
+// (see VM::fork())
+constexpr std::uint16_t RAM_PAGE_SIZE = 256;
+constexpr std::uint16_t RAM_PAGES = RAM_SIZE / RAM_PAGE_SIZE;
+
+/// @brief Memory of SIZE bytes
+///
+/// @details Instantiated for RAM_SIZE (CHIP-8/SCHIP, see RAM) and XO_RAM_SIZE
+/// (XO-CHIP), in schip8_emulator_memory_ram.cpp.
+/// @tparam SIZE The memory size (in bytes), a multiple of RAM_PAGE_SIZE
+template <std::uint32_t SIZE>
+class BasicRAM {
  public:
-  /// @brief Zeroes out the memory (0x000 to 0xFFF)
+  static constexpr std::uint32_t PAGES = SIZE / RAM_PAGE_SIZE;
+
+  /// @brief Zeroes out the memory (0x000 to SIZE - 1)
   void clear();
 
-  /// @brief Zeroes out the program memory (0x200 to 0xFFF)
+  /// @brief Zeroes out the program memory (0x200 to SIZE - 1)
   void clearProgram();
 
   /// @brief Load data into memory
@@ -74,13 +92,15 @@ class RAM {
   void writeByte(std::uint16_t address, std::uint8_t value,
                  std::error_code &ec);
 
-  /// @brief Get a pointer to the byte at the address
-  /// @param address Address to get the pointer from
+  /// @brief Read consecutive bytes from memory
+  /// @param address Address to read from
+  /// @param data Where to copy the bytes
+  /// @param size Number of bytes to read
   /// @param ec Error::OUT_OF_RANGE
   ///
-  /// - If the address is beyond the memory size
-  /// @return Pointer to the byte at the address (nullptr if error)
-  std::uint8_t *getBytePointer(std::uint16_t address, std::error_code &ec);
+  /// - If the data is beyond the memory size
+  void readData(std::uint16_t address, std::uint8_t *data, std::size_t size,
+                std::error_code &ec) const;
 
   /// @brief Check if the address and size are within the memory bounds
   /// @param address Address to check
@@ -88,10 +108,32 @@ class RAM {
   /// @return `true` if the address and size are within the memory bounds
   bool isSizeReadable(std::uint16_t address, std::size_t size) const;
 
+  /// @return the number of pages shared with another copy of the RAM
+  std::size_t sharedPages() const;
+
+  // Unchecked accesses, for the programs proven to stay in bounds (see
+  // Analysis::verify()); inlined, as they run on every instruction
+
+  std::uint8_t readByteUnchecked(std::uint16_t address) const {
+    return _memory.read(address / RAM_PAGE_SIZE)[address % RAM_PAGE_SIZE];
+  }
+
+  std::uint16_t readWordUnchecked(std::uint16_t address) const {
+    return (readByteUnchecked(address) << 8) | readByteUnchecked(address + 1);
+  }
+
+  void writeByteUnchecked(std::uint16_t address, std::uint8_t value) {
+    _memory.write(address / RAM_PAGE_SIZE)[address % RAM_PAGE_SIZE] = value;
+  }
+
  private:
-  std::array<std::uint8_t, RAM_SIZE> _memory = {0};
+  using Page = std::array<std::uint8_t, RAM_PAGE_SIZE>;
+
+  CowPages<Page, PAGES> _memory;
 };
 
+using RAM = BasicRAM<RAM_SIZE>;
+
 }  // namespace SuperChip8::Emulator::Memory
 
 #endif  // SUPERCHIP8_EMULATOR_MEMORY_RAM_HPP
\ No newline at end of file
@@ -1,8 +1,23 @@
 #include "schip8_emulator_memory_registers.hpp"
 #include "schip8_error.hpp"
+#include "schip8_hash.hpp"
 
 namespace SuperChip8::Emulator::Memory {
 
+Registers::Registers(const Registers &other) { *this = other; }
+
+Registers &Registers::operator=(const Registers &other) {
+  V = other.V;
+  RPL = other.RPL;
+  I = other.I;
+  delay_timer = other.delay_timer.load();
+  sound_timer = other.sound_timer.load();
+  pc = other.pc;
+  sp = other.sp;
+  stack = other.stack;
+  return *this;
+}
+
 void Registers::clear() {
   V.fill(0);
   RPL.fill(0);
@@ -34,4 +49,18 @@ std::uint16_t Registers::popFromStack(std::error_code &ec) {
   return stack[sp];
 }
 
+std::uint64_t Registers::hash() const {
+  std::uint64_t hash = fnv1a(FNV_OFFSET_BASIS, V.data(), V.size());
+  hash = fnv1a(hash, I >> 8);
+  hash = fnv1a(hash, I & 0xFF);
+  hash = fnv1a(hash, pc >> 8);
+  hash = fnv1a(hash, pc & 0xFF);
+  hash = fnv1a(hash, sp);
+  for (std::uint16_t address : stack) {
+    hash = fnv1a(hash, address >> 8);
+    hash = fnv1a(hash, address & 0xFF);
+  }
+  return hash;
+}
+
 }  // namespace SuperChip8::Emulator::Memory
@@ -15,6 +15,13 @@ constexpr std::uint8_t STACK_SIZE = 16;
 
 class Registers {
  public:
+  Registers() = default;
+
+  /// @brief Copy the registers (the timers are atomics, hence not copyable by
+  /// default)
+  Registers(const Registers &other);
+  Registers &operator=(const Registers &other);
+
   /// @brief Set all registers, I, delay_timer, sound_timer to 0 and pc to
   /// ROM_START
   void clear();
@@ -33,6 +40,18 @@ class Registers {
   /// @return the value popped from the stack
   std::uint16_t popFromStack(std::error_code &ec);
 
+  // Unchecked stack accesses, for the programs proven to stay in bounds (see
+  // Analysis::verify())
+
+  void pushToStackUnchecked(std::uint16_t value) { stack[sp++] = value; }
+
+  std::uint16_t popFromStackUnchecked() { return stack[--sp]; }
+
+  /// @brief Hash the CPU state (FNV-1a): V, I, pc, sp and the stack
+  /// @details The timers are left out, as they depend on the frame timing.
+  /// @return the 64 bits hash
+  std::uint64_t hash() const;
+
   // General purpose registers: V0 to VF [VF is used as a flag]
   std::array<std::uint8_t, REGISTERS> V = {0};
   // RPL flags
@@ -0,0 +1,154 @@
+#include "schip8_emulator_cycletuner.hpp"
+#include "schip8_error.hpp"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace SuperChip8::Emulator {
+
+namespace {
+
+// cycles of an iteration of a delay timer loop (FX07, 3X00, 1NNN)
+constexpr std::uint16_t DELAY_POLL_CYCLES = 3;
+// reads of a running delay timer in a frame that make it a loop, a single
+// one can be a plain check
+constexpr std::uint16_t MIN_DELAY_POLLS = 2;
+
+/// @brief Parse a `<hash> <platform> <cycles>` store line
+bool parseStoreLine(const std::string &line, std::uint64_t &rom_hash,
+                    std::string &platform, std::uint16_t &cycles) {
+  std::istringstream stream(line);
+  std::uint32_t value = 0;
+  stream >> std::hex >> rom_hash >> platform >> std::dec >> value;
+  if (stream.fail() || value < AUTO_CYCLES_MIN || value > AUTO_CYCLES_MAX) {
+    return false;
+  }
+  cycles = value;
+  return true;
+}
+
+std::string storeKey(std::uint64_t rom_hash, std::string_view platform) {
+  std::ostringstream key;
+  key << std::hex << rom_hash << ' ' << platform;
+  return key.str();
+}
+
+}  // namespace
+
+std::uint16_t CycleTuner::endFrame(const FrameActivity &activity,
+                                   std::uint16_t target_cycles) {
+  if (activity.key_waits > 0) {
+    return target_cycles;
+  }
+
+  std::uint32_t idle_cycles = activity.skipped_cycles;
+  if (activity.delay_polls >= MIN_DELAY_POLLS) {
+    idle_cycles += activity.delay_polls * DELAY_POLL_CYCLES;
+  }
+  if (idle_cycles == 0) {
+    if (activity.draws == 0) {
+      // computing only, no hint of the speed it should run at
+      return target_cycles;
+    }
+    // the frame ended in the middle of the drawing: starved
+    _window_frames = 0;
+    _window_busy_cycles = 0;
+    return std::min<std::uint32_t>(
+        target_cycles + std::max(target_cycles / 4, 1), AUTO_CYCLES_MAX);
+  }
+
+  std::uint16_t busy_cycles =
+      target_cycles - std::min<std::uint32_t>(idle_cycles, target_cycles);
+  _window_busy_cycles = std::max(_window_busy_cycles, busy_cycles);
+  if (++_window_frames < AUTO_CYCLES_WINDOW) {
+    return target_cycles;
+  }
+
+  std::uint32_t needed_cycles =
+      std::clamp<std::uint32_t>(_window_busy_cycles + _window_busy_cycles / 4,
+                                AUTO_CYCLES_MIN, AUTO_CYCLES_MAX);
+  _window_frames = 0;
+  _window_busy_cycles = 0;
+  if (needed_cycles >= target_cycles) {
+    return target_cycles;
+  }
+  // halfway, a slow scene may come back
+  return target_cycles - (target_cycles - needed_cycles + 1) / 2;
+}
+
+std::filesystem::path defaultCycleStorePath() {
+  std::filesystem::path config;
+  if (const char *xdg_config = std::getenv("XDG_CONFIG_HOME");
+      xdg_config && *xdg_config) {
+    config = xdg_config;
+  } else if (const char *home = std::getenv("HOME"); home && *home) {
+    config = std::filesystem::path(home) / ".config";
+  } else {
+    return {};
+  }
+  return config / "superchip8" / "cycles";
+}
+
+std::optional<std::uint16_t> loadTunedCycles(
+    const std::filesystem::path &store, std::uint64_t rom_hash,
+    std::string_view platform) {
+  std::ifstream file(store);
+  std::string line;
+  while (std::getline(file, line)) {
+    std::uint64_t line_hash = 0;
+    std::string line_platform;
+    std::uint16_t cycles = 0;
+    if (parseStoreLine(line, line_hash, line_platform, cycles) &&
+        line_hash == rom_hash && line_platform == platform) {
+      return cycles;
+    }
+  }
+  return std::nullopt;
+}
+
+void saveTunedCycles(const std::filesystem::path &store,
+                     std::uint64_t rom_hash, std::string_view platform,
+                     std::uint16_t cycles, std::error_code &ec) {
+  // the other ROMs are kept, the malformed lines dropped
+  std::vector<std::string> lines;
+  std::string key = storeKey(rom_hash, platform);
+  {
+    std::ifstream file(store);
+    std::string line;
+    while (std::getline(file, line)) {
+      std::uint64_t line_hash = 0;
+      std::string line_platform;
+      std::uint16_t line_cycles = 0;
+      if (parseStoreLine(line, line_hash, line_platform, line_cycles) &&
+          storeKey(line_hash, line_platform) != key) {
+        lines.push_back(line);
+      }
+    }
+  }
+  lines.push_back(key + ' ' + std::to_string(cycles));
+
+  // written aside then renamed, an interrupted write never leaves a torn store
+  std::error_code fs_ec;
+  std::filesystem::create_directories(store.parent_path(), fs_ec);
+  std::filesystem::path temporary = store;
+  temporary += ".tmp";
+  std::ofstream file(temporary, std::ios::trunc);
+  for (const std::string &line : lines) {
+    file << line << '\n';
+  }
+  file.close();
+  if (file.fail()) {
+    ec = Error::CYCLE_STORE_ERROR;
+    return;
+  }
+  std::filesystem::rename(temporary, store, fs_ec);
+  if (fs_ec) {
+    ec = Error::CYCLE_STORE_ERROR;
+  }
+}
+
+}  // namespace SuperChip8::Emulator
@@ -0,0 +1,91 @@
+#ifndef SUPERCHIP8_EMULATOR_CYCLETUNER_HPP
+#define SUPERCHIP8_EMULATOR_CYCLETUNER_HPP
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string_view>
+#include <system_error>
+
+namespace SuperChip8::Emulator {
+
+/** Automatic cycles per frame
+ *
+ * Most programs pace themselves on the delay timer: they draw a frame, then
+ * spin on FX07 until the timer runs out. The cycles spent spinning are the
+ * host CPU burnt for nothing, and a program that never gets to spin is too
+ * slow. Each frame, the CPU counts what the program did (see FrameActivity),
+ * and the tuner moves the target cycles:
+ *
+ * - up by a quarter when the frame ran out of cycles in the middle of its
+ *   drawing (sprites drawn, and no idle point reached)
+ * - down, once per second, halfway to the most cycles a frame of the last
+ *   second needed before idling (plus a quarter of margin)
+ *
+ * The frames waiting for a key (FX0A) tell nothing about the speed of the
+ * program, the target is left as is. The tuned target is stored per ROM
+ * (FNV-1a hash of its bytes) and platform, the next launch starts from it.
+ */
+
+// bounds of the tuned target
+constexpr std::uint16_t AUTO_CYCLES_MIN = 5;
+constexpr std::uint16_t AUTO_CYCLES_MAX = 1000;
+// frames between two decreases of the target
+constexpr std::uint16_t AUTO_CYCLES_WINDOW = 60;
+
+/// @brief What the program did during a frame, counted by the CPU
+struct FrameActivity {
+  // FX07 reads of a running delay timer (ie: FX07, 3X00, 1NNN loops)
+  std::uint16_t delay_polls = 0;
+  // FX0A executions still waiting for a key
+  std::uint16_t key_waits = 0;
+  // DXYN
+  std::uint16_t draws = 0;
+  // cycles left when the frame ended early (DXYN waiting for the vblank)
+  std::uint16_t skipped_cycles = 0;
+};
+
+/// @brief Picks the target cycles per frame from the activity of the frames
+class CycleTuner {
+ public:
+  /// @brief Account for a frame
+  /// @param activity The activity of the frame
+  /// @param target_cycles The target cycles the frame ran with
+  /// @return the target cycles of the next frame
+  std::uint16_t endFrame(const FrameActivity &activity,
+                         std::uint16_t target_cycles);
+
+ private:
+  std::uint16_t _window_frames = 0;
+  // most cycles a frame of the window ran before idling
+  std::uint16_t _window_busy_cycles = 0;
+};
+
+/// @return the default cycle store, `$XDG_CONFIG_HOME/superchip8/cycles` (or
+/// `~/.config/superchip8/cycles`), empty if there is no home directory
+std::filesystem::path defaultCycleStorePath();
+
+/// @brief Look a ROM up in a cycle store
+/// @param store The store (one `<hash> <platform> <cycles>` line per ROM)
+/// @param rom_hash The FNV-1a hash of the ROM
+/// @param platform The platform name
+/// @return the stored target cycles, std::nullopt if none
+std::optional<std::uint16_t> loadTunedCycles(
+    const std::filesystem::path &store, std::uint64_t rom_hash,
+    std::string_view platform);
+
+/// @brief Store the target cycles of a ROM, replacing its previous value
+/// @param store The store, created with its directory if needed
+/// @param rom_hash The FNV-1a hash of the ROM
+/// @param platform The platform name
+/// @param cycles The target cycles
+/// @param ec Error::CYCLE_STORE_ERROR
+///
+/// - If the store cannot be written
+void saveTunedCycles(const std::filesystem::path &store,
+                     std::uint64_t rom_hash, std::string_view platform,
+                     std::uint16_t cycles, std::error_code &ec);
+
+}  // namespace SuperChip8::Emulator
+
+#endif  // SUPERCHIP8_EMULATOR_CYCLETUNER_HPP
@@ -0,0 +1,53 @@
+#include "schip8_emulator_inputscript.hpp"
+#include "schip8_error.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <sstream>
+
+namespace SuperChip8::Emulator {
+
+std::vector<InputEvent> parseInputScript(const std::string &script,
+                                         std::error_code &ec) {
+  std::vector<InputEvent> events;
+  std::istringstream stream(script);
+  std::string token;
+
+  while (std::getline(stream, token, ',')) {
+    if (token.empty()) {
+      continue;
+    }
+
+    // <frame>:<key><+|->
+    std::size_t colon = token.find(':');
+    if (colon == std::string::npos || colon == 0 ||
+        token.size() != colon + 3) {
+      ec = Error::INVALID_INPUT_SCRIPT;
+      return {};
+    }
+
+    char key = token[colon + 1];
+    char action = token[colon + 2];
+    if (!std::isxdigit(static_cast<unsigned char>(key)) ||
+        (action != '+' && action != '-') ||
+        !std::all_of(token.begin(), token.begin() + colon,
+                     [](unsigned char c) { return std::isdigit(c); })) {
+      ec = Error::INVALID_INPUT_SCRIPT;
+      return {};
+    }
+
+    events.push_back(
+        {static_cast<std::uint32_t>(std::stoul(token.substr(0, colon))),
+         static_cast<std::uint8_t>(std::stoul(std::string(1, key), nullptr, 16)),
+         action == '+'});
+  }
+
+  // keeping the script order for events of the same frame
+  std::stable_sort(events.begin(), events.end(),
+                   [](const InputEvent &a, const InputEvent &b) {
+                     return a.frame < b.frame;
+                   });
+  return events;
+}
+
+}  // namespace SuperChip8::Emulator
@@ -0,0 +1,39 @@
+#ifndef SUPERCHIP8_EMULATOR_INPUTSCRIPT_HPP
+#define SUPERCHIP8_EMULATOR_INPUTSCRIPT_HPP
+
+#include <cstdint>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace SuperChip8::Emulator {
+
+/// @brief A scripted key press or release, applied before the given frame
+struct InputEvent {
+  std::uint32_t frame;
+  std::uint8_t key;
+  bool pressed;
+};
+
+/** Input script format
+ *
+ * A comma separated list of `<frame>:<key><+|->` events, where frame is a
+ * decimal frame number, key a keypad key in hexadecimal (0 to F), `+` a press
+ * and `-` a release.
+ *
+ * ie: "30:5+,34:5-,90:a+,91:a-" presses 5 on frame 30, releases it on frame 34,
+ * then taps A on frame 90.
+ */
+
+/// @brief Parse an input script
+/// @param script The script to parse (an empty script has no event)
+/// @param ec Error::INVALID_INPUT_SCRIPT
+///
+/// - If an event is malformed
+/// @return the events, sorted by frame
+std::vector<InputEvent> parseInputScript(const std::string &script,
+                                         std::error_code &ec);
+
+}  // namespace SuperChip8::Emulator
+
+#endif  // SUPERCHIP8_EMULATOR_INPUTSCRIPT_HPP
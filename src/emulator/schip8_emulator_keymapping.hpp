@@ -3,8 +3,8 @@
 
 #include "schip8_system_input_key.hpp"
 
+#include <array>
 #include <cstdint>
-#include <map>
 
 namespace SuperChip8::Emulator {
 
@@ -25,26 +25,31 @@ constexpr std::uint8_t KEY_MAPPED_COUNT = 16;
  *  |     |A|0|B|F|     |  |     |Z|X|C|V|     |
  *  |     +-+-+-+-+     |  |     +-+-+-+-+     |
  *  +-------------------+  +-------------------+
+ *
+ * key_map gives the keyboard key of each keypad key.
  */
-const std::map<std::uint8_t, SuperChip8::System::Input::Key> key_map = {
-    {0x1, SuperChip8::System::Input::Key::ONE},
-    {0x2, SuperChip8::System::Input::Key::TWO},
-    {0x3, SuperChip8::System::Input::Key::THREE},
-    {0xC, SuperChip8::System::Input::Key::FOUR},
-    {0x4, SuperChip8::System::Input::Key::Q},
-    {0x5, SuperChip8::System::Input::Key::W},
-    {0x6, SuperChip8::System::Input::Key::E},
-    {0xD, SuperChip8::System::Input::Key::R},
-    {0x7, SuperChip8::System::Input::Key::A},
-    {0x8, SuperChip8::System::Input::Key::S},
-    {0x9, SuperChip8::System::Input::Key::D},
-    {0xE, SuperChip8::System::Input::Key::F},
-    {0xA, SuperChip8::System::Input::Key::Z},
-    {0x0, SuperChip8::System::Input::Key::X},
-    {0xB, SuperChip8::System::Input::Key::C},
-    {0xF, SuperChip8::System::Input::Key::V},
+constexpr std::array<System::Input::Key, KEY_MAPPED_COUNT> key_map = {
+    System::Input::Key::X,    System::Input::Key::ONE,   // 0 1
+    System::Input::Key::TWO,  System::Input::Key::THREE, // 2 3
+    System::Input::Key::Q,    System::Input::Key::W,     // 4 5
+    System::Input::Key::E,    System::Input::Key::A,     // 6 7
+    System::Input::Key::S,    System::Input::Key::D,     // 8 9
+    System::Input::Key::Z,    System::Input::Key::C,     // A B
+    System::Input::Key::FOUR, System::Input::Key::R,     // C D
+    System::Input::Key::F,    System::Input::Key::V,     // E F
 };
 
+/// @brief SuperChip-8 keypad keys, indexed by keyboard key (-1 if the key is
+/// not mapped), the inverse of key_map
+constexpr std::array<std::int8_t, System::Input::KEY_COUNT> keypad_map = [] {
+  std::array<std::int8_t, System::Input::KEY_COUNT> map{};
+  map.fill(-1);
+  for (std::uint8_t i = 0; i < KEY_MAPPED_COUNT; i++) {
+    map[static_cast<std::size_t>(key_map[i])] = i;
+  }
+  return map;
+}();
+
 }  // namespace SuperChip8::Emulator
 
 #endif  // SUPERCHIP8_EMULATOR_KEYMAPPING_HPP
\ No newline at end of file
@@ -0,0 +1,138 @@
+#ifndef SUPERCHIP8_EMULATOR_PLATFORM_HPP
+#define SUPERCHIP8_EMULATOR_PLATFORM_HPP
+
+#include "schip8_emulator_memory_ram.hpp"
+
+#include <cstdint>
+#include <filesystem>
+#include <string_view>
+
+namespace SuperChip8::Emulator {
+
+/** Platforms
+ *
+ * A platform sets, at compile time, the memory size, the number of display
+ * planes, the XO-CHIP instructions and the quirks of the interpreter:
+ *
+ * - SHIFT_USES_VY: 8XY6 / 8XYE shift VY into VX (VX is shifted in place
+ *   otherwise)
+ * - LOAD_STORE_INCREMENTS_I: FX55 / FX65 leave I at I + X + 1
+ * - JUMP_USES_VX: BNNN jumps to NNN + VX (BXNN), to NNN + V0 otherwise
+ * - LOGIC_RESETS_VF: 8XY1 / 8XY2 / 8XY3 reset VF
+ * - CLIP_SPRITES: the sprites are clipped at the screen edges (they wrap
+ *   around otherwise), their position still wraps
+ * - DISPLAY_WAIT: DXYN waits for the vblank, the CPU ends its frame
+ *
+ * The VM is instantiated once per platform (see BasicVM), the quirks are
+ * resolved at compile time in the opcode handlers.
+ */
+
+/// @brief SuperChip-8 as emulated by default: the modern SCHIP quirks, with
+/// the sprites wrapping around the screen (needed by some games)
+struct SuperChip {
+  static constexpr std::string_view NAME = "schip";
+  static constexpr std::uint32_t MEMORY_SIZE = Memory::RAM_SIZE;
+  static constexpr std::uint8_t PLANES = 1;
+  static constexpr bool XO_CHIP = false;
+
+  static constexpr bool SHIFT_USES_VY = false;
+  static constexpr bool LOAD_STORE_INCREMENTS_I = false;
+  static constexpr bool JUMP_USES_VX = true;
+  static constexpr bool LOGIC_RESETS_VF = false;
+  static constexpr bool CLIP_SPRITES = false;
+  static constexpr bool DISPLAY_WAIT = false;
+};
+
+/// @brief Modern SuperChip-8 (as most SCHIP games expect it): SuperChip with
+/// clipped sprites
+struct SuperChipModern : SuperChip {
+  static constexpr std::string_view NAME = "schip-modern";
+
+  static constexpr bool CLIP_SPRITES = true;
+};
+
+/// @brief SuperChip-8 1.1 on the HP48: SuperChip-8 modern waiting for the
+/// vblank on DXYN
+struct SuperChipLegacy : SuperChipModern {
+  static constexpr std::string_view NAME = "schip-legacy";
+
+  static constexpr bool DISPLAY_WAIT = true;
+};
+
+/// @brief Original CHIP-8 (COSMAC VIP), the SuperChip-8 instructions are kept
+struct Chip8 : SuperChip {
+  static constexpr std::string_view NAME = "chip8";
+
+  static constexpr bool SHIFT_USES_VY = true;
+  static constexpr bool LOAD_STORE_INCREMENTS_I = true;
+  static constexpr bool JUMP_USES_VX = false;
+  static constexpr bool LOGIC_RESETS_VF = true;
+  static constexpr bool CLIP_SPRITES = true;
+  static constexpr bool DISPLAY_WAIT = true;
+};
+
+/// @brief XO-CHIP platform: the SuperChip-8 instruction set extended with 64
+/// KB of memory, 2 display planes (4 colors), F000 NNNN (long I), FN01
+/// (plane selection), 5XY2 / 5XY3 (register range save / load), 00DN (scroll
+/// up), F002 (audio pattern) and FX3A (pitch), with the Octo quirks
+struct XOChip {
+  static constexpr std::string_view NAME = "xo-chip";
+  static constexpr std::uint32_t MEMORY_SIZE = Memory::XO_RAM_SIZE;
+  static constexpr std::uint8_t PLANES = 2;
+  static constexpr bool XO_CHIP = true;
+
+  static constexpr bool SHIFT_USES_VY = true;
+  static constexpr bool LOAD_STORE_INCREMENTS_I = true;
+  static constexpr bool JUMP_USES_VX = false;
+  static constexpr bool LOGIC_RESETS_VF = false;
+  static constexpr bool CLIP_SPRITES = false;
+  static constexpr bool DISPLAY_WAIT = false;
+};
+
+// platform names, for the command line help
+constexpr std::string_view PLATFORM_NAMES =
+    "schip | schip-modern | schip-legacy | chip8 | xo-chip";
+
+/// @brief Call a visitor with the platform of the given name
+///
+/// @details The visitor is called with a default constructed platform (ie:
+/// `[](auto platform) { BasicVM<decltype(platform)> vm(10); ... }`), so that
+/// the platform is only resolved once, at startup.
+/// @param name The platform name (see PLATFORM_NAMES)
+/// @param visitor The visitor
+/// @return `false` if the name is unknown (the visitor is not called)
+template <typename Visitor>
+bool visitPlatform(std::string_view name, Visitor &&visitor) {
+  if (name == SuperChip::NAME) {
+    visitor(SuperChip{});
+  } else if (name == SuperChipModern::NAME) {
+    visitor(SuperChipModern{});
+  } else if (name == SuperChipLegacy::NAME) {
+    visitor(SuperChipLegacy{});
+  } else if (name == Chip8::NAME) {
+    visitor(Chip8{});
+  } else if (name == XOChip::NAME) {
+    visitor(XOChip{});
+  } else {
+    return false;
+  }
+  return true;
+}
+
+/// @brief Check if a ROM targets XO-CHIP, from its extension (.xo8)
+/// @param rom_path Path to the ROM
+/// @return `true` if the ROM is an XO-CHIP ROM
+inline bool isXOChipRom(const std::filesystem::path &rom_path) {
+  return rom_path.extension() == ".xo8";
+}
+
+/// @brief Default platform name of a ROM, from its extension
+/// @param rom_path Path to the ROM
+/// @return XOChip::NAME for an XO-CHIP ROM, SuperChip::NAME otherwise
+inline std::string_view defaultPlatform(const std::filesystem::path &rom_path) {
+  return isXOChipRom(rom_path) ? XOChip::NAME : SuperChip::NAME;
+}
+
+}  // namespace SuperChip8::Emulator
+
+#endif  // SUPERCHIP8_EMULATOR_PLATFORM_HPP
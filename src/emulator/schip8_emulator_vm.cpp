@@ -1,86 +1,360 @@
+#include "schip8_emulator_analysis_cfg.hpp"
+#include "schip8_emulator_analysis_verifier.hpp"
 #include "schip8_emulator_fontset.hpp"
 #include "schip8_emulator_keymapping.hpp"
 #include "schip8_emulator_vm.hpp"
 #include "schip8_error.hpp"
+#include "schip8_hash.hpp"
 #include "schip8_system_graphics_sprite.hpp"
+#include "schip8_system_log_logger.hpp"
 
+#include <algorithm>
+#include <bit>
 #include <chrono>
+#include <cstdlib>
+#include <filesystem>
 #include <fstream>
-#include <system_error>
 #include <iostream>
+#include <system_error>
 
 namespace SuperChip8::Emulator {
 
-VM::VM(std::uint16_t target_cycles)
+namespace {
+
+System::Log::Message<System::Log::Level::ERROR> UNKNOWN_OPCODE{
+    "vm", "unknown_opcode", {"opcode", "pc"}};
+System::Log::Message<System::Log::Level::ERROR> CPU_FAULT{
+    "vm", "fault", {"error", "pc"}};
+System::Log::Message<System::Log::Level::INFO> VM_STARTED{
+    "vm", "started", {"platform", "cpu", "cycles"}};
+System::Log::Message<System::Log::Level::DEBUG> CYCLES_TUNED{
+    "vm", "cycles_tuned", {"from", "to"}};
+System::Log::Message<System::Log::Level::ERROR> ROM_NOT_FOUND{
+    "rom", "not_found", {"path"}};
+System::Log::Message<System::Log::Level::ERROR> ROM_TOO_LARGE{
+    "rom", "too_large", {"path", "size"}};
+System::Log::Message<System::Log::Level::INFO> ROM_LOADED{
+    "rom", "loaded", {"path", "size", "hash", "verified"}};
+System::Log::Message<System::Log::Level::INFO> STARTUP{
+    "vm", "startup", {"program_ms", "audio_ms", "window_ms", "verified"}};
+System::Log::Message<System::Log::Level::INFO> FIRST_FRAME{
+    "vm", "first_frame", {"ms"}};
+System::Log::Message<System::Log::Level::INFO> CYCLES_LOADED{
+    "vm", "cycles_loaded", {"cycles"}};
+System::Log::Message<System::Log::Level::INFO> CYCLES_SAVED{
+    "vm", "cycles_saved", {"cycles"}};
+System::Log::Message<System::Log::Level::ERROR> CYCLES_NOT_SAVED{
+    "vm", "cycles_not_saved", {"error"}};
+System::Log::Message<System::Log::Level::INFO> FRAMES{
+    "display", "frames", {"skipped", "missed"}};
+System::Log::Message<System::Log::Level::INFO> CAPTURE_FINISHED{
+    "capture", "finished", {"frames", "dropped"}};
+System::Log::Message<System::Log::Level::ERROR> CAPTURE_FAILED{
+    "capture", "failed", {"error"}};
+
+
+// milliseconds elapsed since a time point
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+  return std::chrono::duration<double, std::milli>(
+             std::chrono::steady_clock::now() - start)
+      .count();
+}
+
+}  // namespace
+
+template <typename Platform>
+BasicVM<Platform>::BasicVM(std::uint16_t target_cycles)
     : _display([this]() { handleVBlankInterrupt(); }),
-      _gen(_rd()),
+      // initialize the random number generator
+      _gen(std::chrono::high_resolution_clock::now().time_since_epoch().count()),
       _dist(0, 255),
-      _target_cycles(target_cycles) {
-  // initialize the random number generator
-  _gen.seed(
-      std::chrono::high_resolution_clock::now().time_since_epoch().count());
+      _target_cycles(target_cycles) {}
+
+template <typename Platform>
+BasicVM<Platform>::BasicVM(const BasicVM &parent)
+    : _ram(parent._ram),
+      _registers(parent._registers),
+      _display(parent._display, [this]() { handleVBlankInterrupt(); }),
+      _gen(parent._gen),
+      _dist(parent._dist),
+      _running(parent._running.load()),
+      _program_loaded(parent._program_loaded.load()),
+      _verified(parent._verified),
+      _keyPressed(parent._keyPressed),
+      _key_awaiting_release(parent._key_awaiting_release),
+      _audio_pattern(parent._audio_pattern),
+      _pitch(parent._pitch),
+      _target_cycles(parent._target_cycles.load()) {}
+
+template <typename Platform>
+std::unique_ptr<BasicVM<Platform>> BasicVM<Platform>::fork() const {
+  return std::unique_ptr<BasicVM>(new BasicVM(*this));
 }
 
-void VM::turnOn(const std::string &program_path, std::error_code &ec) {
-  // Initialize the memory
-  _registers.clear();
-  _ram.clear();
+template <typename Platform>
+typename BasicVM<Platform>::State BasicVM<Platform>::saveState() const {
+  return {_ram,
+          _registers,
+          _display.saveBackBuffer(),
+          _gen,
+          _keyPressed,
+          _key_awaiting_release,
+          _audio_pattern,
+          _pitch,
+          _running.load()};
+}
 
-  // load fontset
-  _ram.loadData(FONTSET_LOW_RES.data(), FONT_SIZE_LOW_RES, 0, ec);
-  _ram.loadData(FONTSET_HIGH_RES.data(), FONT_SIZE_HIGH_RES, FONT_SIZE_LOW_RES,
-                ec);
-  if (ec) {
-    return;
-  }
+template <typename Platform>
+void BasicVM<Platform>::loadState(const State &state) {
+  _ram = state.ram;
+  _registers = state.registers;
+  _display.restoreBackBuffer(state.back_buffer);
+  _gen = state.gen;
+  _keyPressed = state.keyPressed;
+  _key_awaiting_release = state.key_awaiting_release;
+  _audio_pattern = state.audio_pattern;
+  _pitch = state.pitch;
+  publishAudioPattern();
+  _running.store(state.running);
+}
 
-  // Initialize the audio device
-  _audioDevice.open(ec);
-  if (ec) {
-    return;
-  }
-  // SOUND_FILE_PATH is defined in CMakeLists.txt
-  _audioDevice.registerSound(SoundType::BEEP,
-                             std::string(SOUND_FILE_PATH) + "/beep.wav", ec);
+template <typename Platform>
+void BasicVM<Platform>::setRunAhead(std::uint8_t frames) {
+  _run_ahead_frames = frames;
+}
+
+template <typename Platform>
+void BasicVM<Platform>::setSingleThread(bool single_thread) {
+  _single_thread = single_thread;
+}
+
+template <typename Platform>
+void BasicVM<Platform>::setAutoCycles(const std::filesystem::path &store) {
+  _auto_cycles = true;
+  _cycle_store = store;
+}
+
+template <typename Platform>
+void BasicVM<Platform>::setFilter(System::Graphics::Filter filter) {
+  _display.setFilter(filter);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::setVSync(bool vsync) {
+  _display.setVSync(vsync);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::setFrameSkip(std::uint8_t max_skip) {
+  _display.setFrameSkip(max_skip);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::setFrameStats(bool frame_stats) {
+  _frame_stats = frame_stats;
+}
+
+template <typename Platform>
+void BasicVM<Platform>::attachDebugger(
+    std::unique_ptr<Debug::Debugger> debugger) {
+  _debugger = std::move(debugger);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::attachSpectatorServer(
+    std::unique_ptr<System::Stream::SpectatorServer> spectator_server) {
+  _spectator_server = std::move(spectator_server);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::attachFrameExport(
+    std::unique_ptr<System::Stream::SharedFrameWriter> frame_export) {
+  _frame_export = std::move(frame_export);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::attachRecorder(
+    std::unique_ptr<System::Capture::Recorder> recorder) {
+  _recorder = std::move(recorder);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::attachConsole(
+    std::unique_ptr<System::Terminal::Console> console) {
+  _console = std::move(console);
+  _display.setConsole(_console.get());
+  _keyboard.setConsole(_console.get());
+}
+
+template <typename Platform>
+void BasicVM<Platform>::turnOn(const std::string &program_path,
+                               std::error_code &ec) {
+  _turn_on_time = std::chrono::steady_clock::now();
+
+  // Initialize the memory
+  initializeMemory(ec);
   if (ec) {
     return;
   }
 
+  // Load the program and initialize the audio device in the background, the
+  // window must be created on the main thread
+  std::error_code program_ec;
+  std::error_code audio_ec;
+  double program_time = 0;
+  double audio_time = 0;
+  std::jthread program_loader([&]() {
+    loadProgram(program_path, program_ec);
+    program_time = millisecondsSince(_turn_on_time);
+  });
+  std::jthread audio_initializer([&]() {
+    // no sound in a terminal, the host may have no audio device
+    if (!_console) {
+      _audioDevice.open(audio_ec);
+    }
+    audio_time = millisecondsSince(_turn_on_time);
+  });
+
   // Initialize the display
   _display.clear();
   _display.createWindow("SuperChiP-8", ec);
+  double window_time = millisecondsSince(_turn_on_time);
+
+  program_loader.join();
+  audio_initializer.join();
+  System::Log::write(STARTUP, program_time, audio_time, window_time,
+                     _verified);
   if (ec) {
     return;
   }
-
-  loadProgram(program_path, ec);
-  if (ec) {
+  if (audio_ec) {
+    ec = audio_ec;
+    return;
+  }
+  if (program_ec) {
+    ec = program_ec;
     return;
   }
 
+  if (_debugger) {
+    _auto_cycles = false;
+  }
+  if (_auto_cycles && !_cycle_store.empty()) {
+    if (auto cycles =
+            loadTunedCycles(_cycle_store, _rom_hash, Platform::NAME)) {
+      _target_cycles = *cycles;
+      System::Log::write(CYCLES_LOADED, *cycles);
+    }
+  }
+
+  // the keys are polled while the display waits for the next frame
+  _vblank_time = std::chrono::steady_clock::now();
+  _display.setInputHandler([this]() { pollInput(); });
+
   _running.store(true);
-  _cpu_thread = std::jthread(&VM::run, this, std::ref(ec));
+  // after the store: a stop() racing with it either is seen here, or clears
+  // _running after it
+  if (_stop_requested.load()) {
+    _running.store(false);
+  }
+  const char *cpu = "thread";
+  if (_debugger) {
+    _run_ahead_frames = 0;
+    _single_thread = false;
+    cpu = "debugger";
+    _cpu_thread =
+        std::jthread(&BasicVM::run<Debug::Debugger, true>, this, std::ref(ec));
+  } else if (_run_ahead_frames > 0 || _single_thread) {
+    // the CPU runs in the vblank handler, on the display thread
+    _display.setSingleThreaded(true);
+    cpu = _run_ahead_frames > 0 ? "run-ahead" : "single-thread";
+  } else if (_verified) {
+    _cpu_thread = std::jthread(&BasicVM::run<Debug::NoDebugger, false>, this,
+                               std::ref(ec));
+  } else {
+    _cpu_thread = std::jthread(&BasicVM::run<Debug::NoDebugger, true>, this,
+                               std::ref(ec));
+  }
+  System::Log::write(VM_STARTED, Platform::NAME, cpu, _target_cycles.load());
 
   // Start the draw loop [must be executed in the main thread]
   drawLoop();
+
+  // the draw loop stopped the VM: the CPU thread is done with ec once joined
+  if (_cpu_thread.joinable()) {
+    _cpu_thread.join();
+  }
+  if (_cpu_error) {
+    ec = _cpu_error;
+  }
 }
 
-void VM::turnOff() {
+template <typename Platform>
+void BasicVM<Platform>::stop() {
+  static_assert(std::atomic<bool>::is_always_lock_free,
+                "stop() must stay async-signal-safe");
+  _stop_requested.store(true);
+  // the draw loop wakes the CPU thread up once it returns
   _running.store(false);
-  _cpu_sleep_cv.notify_one();
+}
+
+template <typename Platform>
+void BasicVM<Platform>::turnOff() {
+  _running.store(false);
+  wakeCpu();
 
-  _cpu_thread.request_stop();
-  _cpu_thread.join();
+  if (_cpu_thread.joinable()) {
+    _cpu_thread.request_stop();
+    _cpu_thread.join();
+  }
 
   _audioDevice.close();
   _display.closeWindow();
+  const System::Graphics::FramePacer &pacer = _display.framePacer();
+  // the histogram is the report asked for, not a log
+  if (_frame_stats) {
+    pacer.histogram().write(std::cerr);
+    std::cerr << "frames: " << pacer.skippedFrames() << " skipped, "
+              << pacer.missedFrames() << " missed" << std::endl;
+  }
+  System::Log::write(FRAMES, pacer.skippedFrames(), pacer.missedFrames());
+  if (_auto_cycles && _program_loaded.load() && !_cycle_store.empty()) {
+    std::error_code ec;
+    saveTunedCycles(_cycle_store, _rom_hash, Platform::NAME,
+                    _target_cycles.load(), ec);
+    if (ec) {
+      System::Log::write(CYCLES_NOT_SAVED, ec);
+    } else {
+      System::Log::write(CYCLES_SAVED, _target_cycles.load());
+    }
+  }
+  // removes the socket file and the shared-memory object, and finishes the
+  // video
+  _spectator_server.reset();
+  _frame_export.reset();
+  if (_recorder) {
+    std::error_code ec;
+    _recorder->close(ec);
+    if (ec) {
+      System::Log::write(CAPTURE_FAILED, ec);
+    } else {
+      System::Log::write(CAPTURE_FINISHED, _recorder->encodedFrames(),
+                         _recorder->droppedFrames());
+    }
+    _recorder.reset();
+  }
 }
 
-void VM::loadProgram(const std::string &program_path, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::loadProgram(const std::string &program_path,
+                                    std::error_code &ec) {
   _ram.clearProgram();
   std::ifstream file(program_path, std::ios::binary | std::ios::ate);
+  // the file name, the path may not fit in a log record
+  std::string name = std::filesystem::path(program_path).filename().string();
   if (!file.is_open()) {
     ec = Error::FILE_NOT_FOUND;
+    System::Log::write(ROM_NOT_FOUND, name);
     return;
   }
   std::size_t size = file.tellg();
@@ -90,108 +364,512 @@ void VM::loadProgram(const std::string &program_path, std::error_code &ec) {
 
   _ram.loadData(buffer.data(), size, Memory::ROM_START, ec);
   if (ec) {
+    System::Log::write(ROM_TOO_LARGE, name, size);
     return;
   }
+  _rom_hash = fnv1a(FNV_OFFSET_BASIS, buffer.data(), size);
+
+  // programs proven to stay in bounds run without bounds checks (the
+  // verifier models the SuperChip-8 instruction set and memory, with FX55 /
+  // FX65 leaving I untouched)
+  if constexpr (!Platform::XO_CHIP && !Platform::LOAD_STORE_INCREMENTS_I) {
+    _verified =
+        Analysis::verify(Analysis::ControlFlowGraph(buffer.data(), size))
+            .proven;
+  }
+  System::Log::write(ROM_LOADED, name, size, System::Log::Hex{_rom_hash, 16},
+                     _verified);
 
   _program_loaded.store(true);
 }
 
-void VM::run(std::error_code &ec) {
-  while (!_program_loaded.load() && _running.load()) {
-    // wait for the program to be loaded
-    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+template <typename Platform>
+void BasicVM<Platform>::boot(const std::string &program_path,
+                             std::error_code &ec) {
+  initializeMemory(ec);
+  if (ec) {
+    return;
   }
 
-  while (_running.load() && _program_loaded.load()) {
-    ec.clear();
+  _display.selectPlanes(0x1);
+  _display.clear();
+  _keyPressed.fill(false);
+  _key_awaiting_release = -1;
+  _audio_pattern = System::Audio::DEFAULT_AUDIO_PATTERN;
+  _pitch = System::Audio::DEFAULT_PITCH;
+  publishAudioPattern();
+  _executed_instructions = 0;
+
+  loadProgram(program_path, ec);
+  if (ec) {
+    return;
+  }
+
+  _running.store(true);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::runFrame(std::error_code &ec) {
+  executeCycles(ec);
+  if (ec) {
+    stopOnFault(ec);
+    return;
+  }
+
+  // vblank, without any device
+  updateTimers();
+  _display.swapBuffers();
+}
+
+template <typename Platform>
+void BasicVM<Platform>::executeCycles(std::error_code &ec) {
+  if (_verified) {
+    executeCyclesLoop<false>(ec);
+  } else {
+    executeCyclesLoop<true>(ec);
+  }
+}
+
+template <typename Platform>
+void BasicVM<Platform>::skipInstruction() {
+  if constexpr (Platform::XO_CHIP) {
+    // skipping both words of F000 NNNN
+    std::error_code ec;
+    if (_ram.readWord(_registers.pc, ec) == 0xF000 && !ec) {
+      _registers.pc += 2;
+    }
+  }
+  _registers.pc += 2;
+}
+
+template <typename Platform>
+void BasicVM<Platform>::raiseFault(Fault fault) {
+  if (_fault == Fault::NONE) {
+    _fault = fault;
+    // the handlers raise after the fetch, or before it for the fetch itself
+    _fault_pc = _registers.pc - 2;
+  }
+  // the CPU loop checks the fault with the key changes, before the next
+  // instruction
+  _next_input_cycle = 0;
+}
+
+template <typename Platform>
+void BasicVM<Platform>::raiseUnknownOpcode(const Opcode &opcode) {
+  if (!_muted) {
+    System::Log::write(UNKNOWN_OPCODE, System::Log::Hex{opcode.raw, 4},
+                       System::Log::Hex{_registers.pc - 2u, 3});
+  }
+  raiseFault(Fault::UNKNOWN_OPCODE);
+}
 
-    Opcode opcode(_ram.readWord(_registers.pc, ec));
-    // instructions are 2 bytes long
+template <typename Platform>
+std::error_code BasicVM<Platform>::takeFault() {
+  std::error_code ec;
+  switch (_fault) {
+    case Fault::NONE:
+      return ec;
+    case Fault::OUT_OF_RANGE:
+      ec = Error::OUT_OF_RANGE;
+      break;
+    case Fault::STACK_OVERFLOW:
+      ec = Error::STACK_OVERFLOW;
+      break;
+    case Fault::STACK_UNDERFLOW:
+      ec = Error::STACK_UNDERFLOW;
+      break;
+    case Fault::UNKNOWN_OPCODE:
+      ec = Error::UNKNOWN_OPCODE;
+      break;
+  }
+  _fault = Fault::NONE;
+  return ec;
+}
+
+template <typename Platform>
+void BasicVM<Platform>::stopOnFault(const std::error_code &ec) {
+  System::Log::write(CPU_FAULT, ec, System::Log::Hex{_fault_pc, 3});
+  _running.store(false);
+  wakeCpu();
+}
+
+template <typename Platform>
+void BasicVM<Platform>::wakeCpu() {
+  { std::lock_guard lock(_cpu_sleep_mutex); }
+  _cpu_sleep_cv.notify_one();
+}
+
+template <typename Platform>
+std::uint8_t BasicVM<Platform>::readByte(std::uint16_t address) {
+  if (address >= Platform::MEMORY_SIZE) {
+    raiseFault(Fault::OUT_OF_RANGE);
+    return 0;
+  }
+  return _ram.readByteUnchecked(address);
+}
+
+template <typename Platform>
+std::uint16_t BasicVM<Platform>::readWord(std::uint16_t address) {
+  if (address + 1u >= Platform::MEMORY_SIZE) {
+    raiseFault(Fault::OUT_OF_RANGE);
+    return 0;
+  }
+  return _ram.readWordUnchecked(address);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::writeByte(std::uint16_t address, std::uint8_t value) {
+  if (address >= Platform::MEMORY_SIZE) {
+    raiseFault(Fault::OUT_OF_RANGE);
+    return;
+  }
+  _ram.writeByteUnchecked(address, value);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::readData(std::uint16_t address, std::uint8_t *data,
+                                 std::size_t size) {
+  if (address + size > Platform::MEMORY_SIZE) {
+    raiseFault(Fault::OUT_OF_RANGE);
+    return;
+  }
+  for (std::size_t i = 0; i < size; i++) {
+    data[i] = _ram.readByteUnchecked(address + i);
+  }
+}
+
+template <typename Platform>
+template <bool CHECKED>
+void BasicVM<Platform>::executeCyclesLoop(std::error_code &ec) {
+  std::uint16_t target_cycles = _target_cycles.load();
+  std::uint16_t cycle = 0;
+  // the flag is only polled: a relaxed load is a plain load, even on ARM
+  for (; cycle < target_cycles && _running.load(std::memory_order_relaxed);
+       cycle++) {
+    if (cycle >= _next_input_cycle) {
+      if (_fault != Fault::NONE) {
+        break;
+      }
+      applyInput(cycle);
+    }
+    if constexpr (!CHECKED) {
+      stepUnchecked();
+    } else {
+      step();
+    }
+
+    if constexpr (Platform::DISPLAY_WAIT) {
+      // DXYN waits for the vblank
+      if (_vblank_wait) {
+        _vblank_wait = false;
+        cycle++;
+        _frame_activity.skipped_cycles = target_cycles - cycle;
+        break;
+      }
+    }
+  }
+  _executed_instructions += cycle;
+  if (_fault != Fault::NONE) {
+    ec = takeFault();
+  }
+}
+
+template <typename Platform>
+void BasicVM<Platform>::seed(std::uint32_t seed) { _gen.seed(seed); }
+
+template <typename Platform>
+void BasicVM<Platform>::setKey(std::uint8_t key, bool pressed) {
+  _keyPressed[key & 0xF] = pressed;
+}
+
+template <typename Platform>
+bool BasicVM<Platform>::isRunning() const { return _running.load(); }
+
+template <typename Platform>
+bool BasicVM<Platform>::isVerified() const { return _verified; }
+
+template <typename Platform>
+std::uint64_t BasicVM<Platform>::executedInstructions() const {
+  return _executed_instructions;
+}
+
+template <typename Platform>
+const typename BasicVM<Platform>::Display &BasicVM<Platform>::display() const {
+  return _display;
+}
+
+template <typename Platform>
+const Memory::Registers &BasicVM<Platform>::registers() const {
+  return _registers;
+}
+
+template <typename Platform>
+void BasicVM<Platform>::initializeMemory(std::error_code &ec) {
+  _registers.clear();
+  _ram.clear();
+
+  // load fontset
+  _ram.loadData(FONTSET_LOW_RES.data(), FONT_SIZE_LOW_RES, 0, ec);
+  _ram.loadData(FONTSET_HIGH_RES.data(), FONT_SIZE_HIGH_RES, FONT_SIZE_LOW_RES,
+                ec);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::step() {
+  if (_registers.pc + 1u >= Platform::MEMORY_SIZE) {
+    // the fetch address is the faulting pc
     _registers.pc += 2;
-    if (ec) {
-      _running.store(false);
-      return;
+    raiseFault(Fault::OUT_OF_RANGE);
+    return;
+  }
+  Opcode opcode(_ram.readWordUnchecked(_registers.pc));
+  // instructions are 2 bytes long
+  _registers.pc += 2;
+
+  executeOpcode(opcode);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::stepUnchecked() {
+  Opcode opcode(_ram.readWordUnchecked(_registers.pc));
+  _registers.pc += 2;
+
+  // the opcodes accessing the RAM or the stack are executed unchecked here,
+  // the others cannot fail (the verifier rejects unknown opcodes)
+  switch (opcode.category) {
+    case 0x0:
+      if (opcode.Y == 0xE && opcode.N == 0xE) {
+        // RET: 00EE
+        _registers.pc = _registers.popFromStackUnchecked();
+      } else {
+        executeCategory0(opcode);
+      }
+      break;
+    case 0x1:
+      executeCategory1(opcode);
+      break;
+    case 0x2:
+      // CALL: 2NNN
+      _registers.pushToStackUnchecked(_registers.pc);
+      _registers.pc = opcode.NNN;
+      break;
+    case 0x3:
+      executeCategory3(opcode);
+      break;
+    case 0x4:
+      executeCategory4(opcode);
+      break;
+    case 0x5:
+      executeCategory5(opcode);
+      break;
+    case 0x6:
+      executeCategory6(opcode);
+      break;
+    case 0x7:
+      executeCategory7(opcode);
+      break;
+    case 0x8:
+      executeCategory8(opcode);
+      break;
+    case 0x9:
+      executeCategory9(opcode);
+      break;
+    case 0xA:
+      executeCategoryA(opcode);
+      break;
+    case 0xB:
+      executeCategoryB(opcode);
+      break;
+    case 0xC:
+      executeCategoryC(opcode);
+      break;
+    case 0xD: {
+      // DISP: DXYN / DXY0
+      std::uint8_t sprite_height = opcode.N == 0x0 ? 16 : opcode.N;
+      std::uint8_t sprite_width = opcode.N == 0x0 ? 16 : 8;
+      std::array<std::uint8_t, 32> sprite_data;
+      for (std::uint8_t i = 0; i < sprite_height * (sprite_width / 8); i++) {
+        sprite_data[i] = _ram.readByteUnchecked(_registers.I + i);
+      }
+      SuperChip8::System::Graphics::Sprite sprite(sprite_height, sprite_width,
+                                                  sprite_data.data());
+      _registers.V[0xF] =
+          _display.template addSprite<Platform::CLIP_SPRITES>(
+              sprite, _registers.V[opcode.X], _registers.V[opcode.Y]);
+      _vblank_wait = Platform::DISPLAY_WAIT;
+      _frame_activity.draws++;
+      break;
     }
+    case 0xE:
+      executeCategoryE(opcode);
+      break;
+    case 0xF:
+      switch (opcode.NN) {
+        case 0x33:
+          // BCD: FX33
+          _ram.writeByteUnchecked(_registers.I, _registers.V[opcode.X] / 100);
+          _ram.writeByteUnchecked(_registers.I + 1,
+                                  (_registers.V[opcode.X] / 10) % 10);
+          _ram.writeByteUnchecked(_registers.I + 2,
+                                  _registers.V[opcode.X] % 10);
+          break;
+        case 0x55:
+          // STORE_REG: FX55
+          for (std::uint8_t i = 0; i <= opcode.X; i++) {
+            _ram.writeByteUnchecked(_registers.I + i, _registers.V[i]);
+          }
+          break;
+        case 0x65:
+          // LD_REG: FX65
+          for (std::uint8_t i = 0; i <= opcode.X; i++) {
+            _registers.V[i] = _ram.readByteUnchecked(_registers.I + i);
+          }
+          break;
+        default:
+          executeCategoryF(opcode);
+          break;
+      }
+      break;
+  }
+}
 
-    executeOpcode(opcode, ec);
-    if (ec) {
-      _running.store(false);
-      return;
+template <typename Platform>
+template <typename DebugPolicy, bool CHECKED>
+void BasicVM<Platform>::run(std::error_code &ec) {
+  // started by turnOn() once the program is loaded
+  while (_running.load() && _program_loaded.load()) {
+    std::uint16_t cycle = _cycle.load();
+    if (cycle == 0) {
+      // the new frame reschedules the key changes, not the fault
+      if (_fault != Fault::NONE) {
+        break;
+      }
+      _frame_activity = {};
+      beginInputFrame();
+    }
+    if (cycle >= _next_input_cycle) {
+      if (_fault != Fault::NONE) {
+        break;
+      }
+      applyInput(cycle);
+    }
+
+    if constexpr (DebugPolicy::ENABLED) {
+      if (!_debugger->template beforeStep<Platform>(
+              _ram, _registers, _display.selectedPlanes())) {
+        _running.store(false);
+        return;
+      }
+    }
+
+    if constexpr (!CHECKED) {
+      stepUnchecked();
+    } else {
+      step();
     }
 
     _cycle++;
+    if constexpr (Platform::DISPLAY_WAIT) {
+      // DXYN waits for the vblank
+      if (_vblank_wait) {
+        _vblank_wait = false;
+        _frame_activity.skipped_cycles = _target_cycles - _cycle;
+        _cycle = _target_cycles.load();
+      }
+    }
     if (_cycle >= _target_cycles && _running.load()) {
-      std::mutex m;
-      std::unique_lock lk(m);
+      if (_fault != Fault::NONE) {
+        break;
+      }
+      endCpuFrame();
+      std::unique_lock lock(_cpu_sleep_mutex);
       _cpu_sleep_cv.wait(
-          lk, [this] { return !_running.load() || _cycle.load() == 0; });
+          lock, [this] { return !_running.load() || _cycle.load() == 0; });
     }
   }
+
+  if (_fault != Fault::NONE) {
+    ec = takeFault();
+    if constexpr (DebugPolicy::ENABLED) {
+      _debugger->onFault(ec, _ram, _registers);
+    }
+    // only once ec is stored: the draw loop then returns it
+    stopOnFault(ec);
+  }
 }
 
-void VM::executeOpcode(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeOpcode(const Opcode &opcode) {
   switch (opcode.category) {
     case 0x0:
-      executeCategory0(opcode, ec);
+      executeCategory0(opcode);
       break;
     case 0x1:
-      executeCategory1(opcode, ec);
+      executeCategory1(opcode);
       break;
     case 0x2:
-      executeCategory2(opcode, ec);
+      executeCategory2(opcode);
       break;
     case 0x3:
-      executeCategory3(opcode, ec);
+      executeCategory3(opcode);
       break;
     case 0x4:
-      executeCategory4(opcode, ec);
+      executeCategory4(opcode);
       break;
     case 0x5:
-      executeCategory5(opcode, ec);
+      executeCategory5(opcode);
       break;
     case 0x6:
-      executeCategory6(opcode, ec);
+      executeCategory6(opcode);
       break;
     case 0x7:
-      executeCategory7(opcode, ec);
+      executeCategory7(opcode);
       break;
     case 0x8:
-      executeCategory8(opcode, ec);
+      executeCategory8(opcode);
       break;
     case 0x9:
-      executeCategory9(opcode, ec);
+      executeCategory9(opcode);
       break;
     case 0xA:
-      executeCategoryA(opcode, ec);
+      executeCategoryA(opcode);
       break;
     case 0xB:
-      executeCategoryB(opcode, ec);
+      executeCategoryB(opcode);
       break;
     case 0xC:
-      executeCategoryC(opcode, ec);
+      executeCategoryC(opcode);
       break;
     case 0xD:
-      executeCategoryD(opcode, ec);
+      executeCategoryD(opcode);
       break;
     case 0xE:
-      executeCategoryE(opcode, ec);
+      executeCategoryE(opcode);
       break;
     case 0xF:
-      executeCategoryF(opcode, ec);
+      executeCategoryF(opcode);
       break;
     default:
-      ec = Error::UNKNOWN_OPCODE;
-      std::cerr << "Unknown opcode: " << std::hex << opcode.raw << std::endl;
+      raiseUnknownOpcode(opcode);
       break;
   }
 }
 
-void VM::executeCategory0(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategory0(const Opcode &opcode) {
   switch (opcode.Y) {
     case 0xC:
       // SCROLL_DOWN: 00CN: Scroll the display N pixels down
       _display.scrollDown(opcode.N);
       break;
+    case 0xD:
+      if constexpr (Platform::XO_CHIP) {
+        // SCROLL_UP: 00DN: Scroll the display N pixels up
+        _display.scrollUp(opcode.N);
+      } else {
+        raiseUnknownOpcode(opcode);
+      }
+      break;
     case 0xE: {
       switch (opcode.N) {
         case 0x0:
@@ -200,12 +878,15 @@ void VM::executeCategory0(const Opcode &opcode, std::error_code &ec) {
           break;
         case 0xE:
           // RET: 00EE: Return from a subroutine
-          _registers.pc = _registers.popFromStack(ec);
+          if (_registers.sp == 0) {
+            raiseFault(Fault::STACK_UNDERFLOW);
+            _registers.pc = 0;
+            break;
+          }
+          _registers.pc = _registers.popFromStackUnchecked();
           break;
         default:
-          ec = Error::UNKNOWN_OPCODE;
-          std::cerr << "Unknown opcode: " << std::setw(4) << std::setfill('0')
-                    << std::hex << opcode.raw << std::endl;
+          raiseUnknownOpcode(opcode);
           break;
       }
       break;
@@ -227,72 +908,101 @@ void VM::executeCategory0(const Opcode &opcode, std::error_code &ec) {
         case 0xE:
           // LOW: 00FE: Set the screen resolution to 64x32
           _display.setResolution(
-              SuperChip8::System::Graphics::Display::Resolution::LOW_RES);
+              Display::Resolution::LOW_RES);
           break;
         case 0xF:
           // HIGH: 00FF: Set the screen resolution to 128x64
           _display.setResolution(
-              SuperChip8::System::Graphics::Display::Resolution::HIGH_RES);
+              Display::Resolution::HIGH_RES);
           break;
         default:
-          ec = Error::UNKNOWN_OPCODE;
-          std::cerr << "Unknown opcode: " << std::setw(4) << std::setfill('0')
-                    << std::hex << opcode.raw << std::endl;
+          raiseUnknownOpcode(opcode);
           break;
       }
       break;
     }
     default:
-      ec = Error::UNKNOWN_OPCODE;
-      std::cerr << "Unknown opcode: " << std::setw(4) << std::setfill('0')
-                << std::hex << opcode.raw << std::endl;
+      raiseUnknownOpcode(opcode);
       break;
   }
 }
 
-void VM::executeCategory1(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategory1(const Opcode &opcode) {
   // JMP: 1NNN: Jump to address NNN
   _registers.pc = opcode.NNN;
 }
 
-void VM::executeCategory2(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategory2(const Opcode &opcode) {
   // CALL: 2NNN: Call subroutine at NNN
-  _registers.pushToStack(_registers.pc, ec);
+  if (_registers.sp >= Memory::STACK_SIZE) {
+    raiseFault(Fault::STACK_OVERFLOW);
+  } else {
+    _registers.pushToStackUnchecked(_registers.pc);
+  }
   _registers.pc = opcode.NNN;
 }
 
-void VM::executeCategory3(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategory3(const Opcode &opcode) {
   // SKIP_EQ: 3XNN: Skip the next instruction if VX == NN
   if (_registers.V[opcode.X] == opcode.NN) {
-    _registers.pc += 2;
+    skipInstruction();
   }
 }
 
-void VM::executeCategory4(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategory4(const Opcode &opcode) {
   // SKIP_NEQ: 4XNN: Skip the next instruction if VX != NN
   if (_registers.V[opcode.X] != opcode.NN) {
-    _registers.pc += 2;
+    skipInstruction();
   }
 }
 
-void VM::executeCategory5(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategory5(const Opcode &opcode) {
+  if constexpr (Platform::XO_CHIP) {
+    switch (opcode.N) {
+      case 0x2:
+        // SAVE_RANGE: 5XY2: Store VX to VY (in that order) in memory starting
+        // at I
+        for (int i = 0; i <= std::abs(opcode.Y - opcode.X); i++) {
+          std::uint8_t reg = opcode.X <= opcode.Y ? opcode.X + i : opcode.X - i;
+          writeByte(_registers.I + i, _registers.V[reg]);
+        }
+        return;
+      case 0x3:
+        // LD_RANGE: 5XY3: Load VX to VY (in that order) from memory starting
+        // at I
+        for (int i = 0; i <= std::abs(opcode.Y - opcode.X); i++) {
+          std::uint8_t reg = opcode.X <= opcode.Y ? opcode.X + i : opcode.X - i;
+          _registers.V[reg] = readByte(_registers.I + i);
+        }
+        return;
+    }
+  }
+
   // SKIP_EQ_REG: 5XY0: Skip the next instruction if VX == VY
   if (_registers.V[opcode.X] == _registers.V[opcode.Y]) {
-    _registers.pc += 2;
+    skipInstruction();
   }
 }
 
-void VM::executeCategory6(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategory6(const Opcode &opcode) {
   // SET: 6XNN: Set VX to NN
   _registers.V[opcode.X] = opcode.NN;
 }
 
-void VM::executeCategory7(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategory7(const Opcode &opcode) {
   // ADD: 7XNN: Add NN to VX
   _registers.V[opcode.X] += opcode.NN;
 }
 
-void VM::executeCategory8(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategory8(const Opcode &opcode) {
   switch (opcode.N) {
     case 0x0:
       // SET: 8XY0: VX = VY
@@ -301,14 +1011,23 @@ void VM::executeCategory8(const Opcode &opcode, std::error_code &ec) {
     case 0x1:
       // OR: 8XY1: VX |= VY
       _registers.V[opcode.X] |= _registers.V[opcode.Y];
+      if constexpr (Platform::LOGIC_RESETS_VF) {
+        _registers.V[0xF] = 0;
+      }
       break;
     case 0x2:
       // AND: 8XY2: VX &= VY
       _registers.V[opcode.X] &= _registers.V[opcode.Y];
+      if constexpr (Platform::LOGIC_RESETS_VF) {
+        _registers.V[0xF] = 0;
+      }
       break;
     case 0x3:
       // XOR: 8XY3: VX ^= VY
       _registers.V[opcode.X] ^= _registers.V[opcode.Y];
+      if constexpr (Platform::LOGIC_RESETS_VF) {
+        _registers.V[0xF] = 0;
+      }
       break;
     case 0x4: {
       // ADD_REG: 8XY4: VX = VX + VY, VF is set to 1 if overflow;
@@ -329,6 +1048,10 @@ void VM::executeCategory8(const Opcode &opcode, std::error_code &ec) {
     }
     case 0x6: {
       // SHR: 8XY6: VX >>= 1, VF is set to the least significant bit of VX
+      // (shift quirk: VX = VY >> 1)
+      if constexpr (Platform::SHIFT_USES_VY) {
+        _registers.V[opcode.X] = _registers.V[opcode.Y];
+      }
       std::uint8_t lsb = _registers.V[opcode.X] & 0x1;
       _registers.V[opcode.X] >>= 1;
       _registers.V[0xF] = lsb;
@@ -344,46 +1067,58 @@ void VM::executeCategory8(const Opcode &opcode, std::error_code &ec) {
     }
     case 0xE: {
       // SHL: 8XYE: VX <<= 1, VF is set to the most significant bit of VX
+      // (shift quirk: VX = VY << 1)
+      if constexpr (Platform::SHIFT_USES_VY) {
+        _registers.V[opcode.X] = _registers.V[opcode.Y];
+      }
       std::uint8_t msb = (_registers.V[opcode.X] & 0x80) >> 7;
       _registers.V[opcode.X] <<= 1;
       _registers.V[0xF] = msb;
       break;
     }
     default:
-      ec = Error::UNKNOWN_OPCODE;
-      std::cerr << "Unknown opcode: " << std::setw(4) << std::setfill('0')
-                << std::hex << opcode.raw << std::endl;
+      raiseUnknownOpcode(opcode);
       break;
   }
 }
 
-void VM::executeCategory9(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategory9(const Opcode &opcode) {
   // SKIP_NEQ_REG: 9XY0: Skip the next instruction if VX != VY
   if (_registers.V[opcode.X] != _registers.V[opcode.Y]) {
-    _registers.pc += 2;
+    skipInstruction();
   }
 }
 
-void VM::executeCategoryA(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategoryA(const Opcode &opcode) {
   // SET_I: ANNN: Set I to NNN
   _registers.I = opcode.NNN;
 }
 
-void VM::executeCategoryB(const Opcode &opcode, std::error_code &ec) {
-  // JMP_V0: BNNN: Jump to address NNN + VX
-  _registers.pc = opcode.NNN + _registers.V[opcode.X];
+template <typename Platform>
+void BasicVM<Platform>::executeCategoryB(const Opcode &opcode) {
+  if constexpr (Platform::JUMP_USES_VX) {
+    // JMP_VX: BXNN: Jump to address XNN + VX
+    _registers.pc = opcode.NNN + _registers.V[opcode.X];
+  } else {
+    // JMP_V0: BNNN: Jump to address NNN + V0
+    _registers.pc = opcode.NNN + _registers.V[0x0];
+  }
 }
 
-void VM::executeCategoryC(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategoryC(const Opcode &opcode) {
   // RAND: CXNN: Set VX to a random number AND NN
   _registers.V[opcode.X] = _dist(_gen) & opcode.NN;
 }
 
-void VM::executeCategoryD(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategoryD(const Opcode &opcode) {
   std::uint8_t x = _registers.V[opcode.X];
   std::uint8_t y = _registers.V[opcode.Y];
-  const std::uint8_t *sprite_data = _ram.getBytePointer(_registers.I, ec);
-  if (ec) {
+  if (_registers.I >= Platform::MEMORY_SIZE) {
+    raiseFault(Fault::OUT_OF_RANGE);
     return;
   }
   // DISP: DXYN: Draw a sprite at (VX, VY) with width 8 and height N
@@ -396,72 +1131,143 @@ void VM::executeCategoryD(const Opcode &opcode, std::error_code &ec) {
     sprite_width = 16;
   }
 
-  // check if all the sprite data is readable (ie: in RAM bounds)
-  if (!_ram.isSizeReadable(_registers.I, sprite_height * sprite_width)) {
-    ec = Error::OUT_OF_RANGE;
+  // XO-CHIP: a sprite is drawn on each selected plane, their data follow
+  // each other in memory
+  std::uint8_t planes = 0x1;
+  if constexpr (Platform::PLANES > 1) {
+    planes = _display.selectedPlanes();
+  }
+  std::uint16_t sprite_size = sprite_height * (sprite_width / 8);
+
+  // check if all the sprite data is readable (ie: in RAM bounds), in bytes
+  if (!_ram.isSizeReadable(_registers.I,
+                           sprite_size * std::popcount(planes))) {
+    raiseFault(Fault::OUT_OF_RANGE);
     return;
   }
 
-  SuperChip8::System::Graphics::Sprite sprite(sprite_height, sprite_width,
-                                              sprite_data);
   // indicates if a collision occurred
-  _registers.V[0xF] = _display.addSprite(sprite, x, y);
+  bool collision = false;
+  std::uint16_t address = _registers.I;
+  for (std::uint8_t plane = 0; plane < Platform::PLANES; plane++) {
+    if (!(planes & (1 << plane))) {
+      continue;
+    }
+
+    // copying the sprite (at most 16 rows of 2 bytes), as it can span
+    // several RAM pages
+    std::array<std::uint8_t, 32> sprite_data;
+    readData(address, sprite_data.data(), sprite_size);
+    if (_fault != Fault::NONE) {
+      return;
+    }
+
+    SuperChip8::System::Graphics::Sprite sprite(sprite_height, sprite_width,
+                                                sprite_data.data());
+    collision = _display.template addSprite<Platform::CLIP_SPRITES>(
+                    sprite, x, y, plane) ||
+                collision;
+    address += sprite_size;
+  }
+  _registers.V[0xF] = collision;
+  _vblank_wait = Platform::DISPLAY_WAIT;
+  _frame_activity.draws++;
 }
 
-void VM::executeCategoryE(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategoryE(const Opcode &opcode) {
   switch (opcode.NN) {
     case 0x9E:
       // SKIP_KEY: EX9E: Skip next instruction if the key with the value of
       // VX is pressed
       if (_keyPressed[_registers.V[opcode.X]]) {
-        _registers.pc += 2;
+        skipInstruction();
       }
       break;
     case 0xA1:
       // SKIP_NKEY: EXA1: Skip next instruction if the key with the value
       // of VX is not pressed
       if (!_keyPressed[_registers.V[opcode.X]]) {
-        _registers.pc += 2;
+        skipInstruction();
       }
       break;
     default:
-      ec = Error::UNKNOWN_OPCODE;
-      std::cerr << "Unknown opcode: " << std::setw(4) << std::setfill('0')
-                << std::hex << opcode.raw << std::endl;
+      raiseUnknownOpcode(opcode);
       break;
   }
 }
 
-void VM::executeCategoryF(const Opcode &opcode, std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::executeCategoryF(const Opcode &opcode) {
+  if constexpr (Platform::XO_CHIP) {
+    switch (opcode.NN) {
+      case 0x00:
+        if (opcode.X != 0x0) {
+          break;
+        }
+        // SET_I_LONG: F000 NNNN: Set I to NNNN, the next word
+        _registers.I = readWord(_registers.pc);
+        _registers.pc += 2;
+        return;
+      case 0x01:
+        // PLANE: FN01: Select the planes N drawn to
+        _display.selectPlanes(opcode.X);
+        return;
+      case 0x02:
+        if (opcode.X != 0x0) {
+          break;
+        }
+        // AUDIO: F002: Load the audio pattern buffer from memory at I
+        readData(_registers.I, _audio_pattern.data(),
+                 System::Audio::AUDIO_PATTERN_SIZE);
+        publishAudioPattern();
+        return;
+      case 0x3A:
+        // PITCH: FX3A: Set the audio pattern playback pitch to VX
+        _pitch = _registers.V[opcode.X];
+        publishAudioPattern();
+        return;
+    }
+  }
+
   switch (opcode.NN) {
     case 0x07:
       // GET_DELAY: FX07: Set VX to the value of the delay timer
-      _registers.V[opcode.X] = _registers.delay_timer;
+      _registers.V[opcode.X] =
+          _registers.delay_timer.load(std::memory_order_relaxed);
+      if (_registers.V[opcode.X] > 0) {
+        _frame_activity.delay_polls++;
+      }
       break;
     case 0x0A: {
       // WAIT_KEY: FX0A: Wait for a key press, store the value of the key in VX
-      bool key_pressed = false;
-      while (!key_pressed && _running.load()) {
+      // the instruction is executed again until a key is pressed and released,
+      // so the CPU keeps its cycle budget instead of spinning
+      if (_key_awaiting_release < 0) {
         for (std::uint8_t i = 0; i < Memory::REGISTERS; i++) {
           if (_keyPressed[i]) {
-            while (_keyPressed[i] && _running.load()) {
-              // wait for the key to be released
-            }
-            _registers.V[opcode.X] = i;
-            key_pressed = true;
+            _key_awaiting_release = i;
             break;
           }
         }
+      } else if (!_keyPressed[_key_awaiting_release]) {
+        _registers.V[opcode.X] = _key_awaiting_release;
+        _key_awaiting_release = -1;
+        break;
       }
+      _registers.pc -= 2;
+      _frame_activity.key_waits++;
       break;
     }
     case 0x15:
       // SET_DELAY: FX15: Set the delay timer to VX
-      _registers.delay_timer = _registers.V[opcode.X];
+      _registers.delay_timer.store(_registers.V[opcode.X],
+                                   std::memory_order_relaxed);
       break;
     case 0x18:
       // SET_SOUND: FX18: Set the sound timer to VX
-      _registers.sound_timer = _registers.V[opcode.X];
+      _registers.sound_timer.store(_registers.V[opcode.X],
+                                   std::memory_order_relaxed);
       break;
     case 0x1E:
       // ADD_I: FX1E: I = I + VX
@@ -481,20 +1287,26 @@ void VM::executeCategoryF(const Opcode &opcode, std::error_code &ec) {
     case 0x33:
       // BCD: FX33: Store BCD representation of VX in memory locations I, I+1,
       // I+2
-      _ram.writeByte(_registers.I, _registers.V[opcode.X] / 100, ec);
-      _ram.writeByte(_registers.I + 1, (_registers.V[opcode.X] / 10) % 10, ec);
-      _ram.writeByte(_registers.I + 2, _registers.V[opcode.X] % 10, ec);
+      writeByte(_registers.I, _registers.V[opcode.X] / 100);
+      writeByte(_registers.I + 1, (_registers.V[opcode.X] / 10) % 10);
+      writeByte(_registers.I + 2, _registers.V[opcode.X] % 10);
       break;
     case 0x55:
       // STORE_REG: FX55: Store V0 to VX in memory starting at I
       for (std::uint8_t i = 0; i <= opcode.X; i++) {
-        _ram.writeByte(_registers.I + i, _registers.V[i], ec);
+        writeByte(_registers.I + i, _registers.V[i]);
+      }
+      if constexpr (Platform::LOAD_STORE_INCREMENTS_I) {
+        _registers.I += opcode.X + 1;
       }
       break;
     case 0x65:
       // LD_REG: FX65: Load V0 to VX from memory starting at I
       for (std::uint8_t i = 0; i <= opcode.X; i++) {
-        _registers.V[i] = _ram.readByte(_registers.I + i, ec);
+        _registers.V[i] = readByte(_registers.I + i);
+      }
+      if constexpr (Platform::LOAD_STORE_INCREMENTS_I) {
+        _registers.I += opcode.X + 1;
       }
       break;
     case 0x75:
@@ -510,47 +1322,261 @@ void VM::executeCategoryF(const Opcode &opcode, std::error_code &ec) {
       }
       break;
     default:
-      ec = Error::UNKNOWN_OPCODE;
-      std::cerr << "Unknown opcode: " << std::hex << opcode.raw << std::endl;
+      raiseUnknownOpcode(opcode);
       break;
   }
 }
 
-void VM::handleVBlankInterrupt() {
-  std::error_code ec;
+template <typename Platform>
+void BasicVM<Platform>::handleVBlankInterrupt() {
+  // the last poll of the frame, before the CPU frame applying it starts
+  pollInput();
+  _vblank_time = std::chrono::steady_clock::now();
+  _vblank_count++;
+
+  if (_run_ahead_frames > 0) {
+    runAheadFrame();
+    return;
+  }
+  if (_single_thread) {
+    if (_running.load()) {
+      runCpuFrame();
+    }
+    return;
+  }
+
   _cycle = 0;
-  _cpu_sleep_cv.notify_one();
-  updateTimers(ec);
-  processInput();
+  wakeCpu();
+  // the timers are frozen while the debugger waits for a command
+  if (!_debugger || !_debugger->isPaused()) {
+    updateTimers();
+  }
+}
+
+template <typename Platform>
+void BasicVM<Platform>::runAheadFrame() {
+  if (!_running.load()) {
+    return;
+  }
+
+  // back to the real state, the previous frame presented a run-ahead one
+  if (_run_ahead_state) {
+    loadState(*_run_ahead_state);
+  }
+
+  // real frame
+  runCpuFrame();
+  // the run-ahead frames replay the input of the real one
+  _next_input_cycle = NO_INPUT;
+  if (!_running.load()) {
+    // the program exited, nothing to run ahead of
+    return;
+  }
+
+  // running ahead with the same input, the last frame is the one presented
+  std::error_code ec;
+  _run_ahead_state = std::make_unique<State>(saveState());
+  _muted = true;
+  for (std::uint8_t frame = 0; frame < _run_ahead_frames && _running.load();
+       frame++) {
+    executeCycles(ec);
+    if (ec) {
+      // the real frame raises the fault when it gets there, the speculative
+      // state is dropped with the next loadState()
+      break;
+    }
+    updateTimers();
+  }
+  _muted = false;
+}
+
+template <typename Platform>
+void BasicVM<Platform>::runCpuFrame() {
+  _frame_activity = {};
+  beginInputFrame();
+  executeCycles(_cpu_error);
+  if (_cpu_error) {
+    stopOnFault(_cpu_error);
+    return;
+  }
+  endCpuFrame();
+  updateTimers();
+}
+
+template <typename Platform>
+void BasicVM<Platform>::endCpuFrame() {
+  if (!_auto_cycles) {
+    return;
+  }
+  std::uint16_t target_cycles = _target_cycles.load();
+  std::uint16_t tuned_cycles =
+      _cycle_tuner.endFrame(_frame_activity, target_cycles);
+  if (tuned_cycles != target_cycles) {
+    System::Log::write(CYCLES_TUNED, target_cycles, tuned_cycles);
+    _target_cycles = tuned_cycles;
+  }
 }
 
-void VM::updateTimers(std::error_code &ec) {
+template <typename Platform>
+void BasicVM<Platform>::updateTimers() {
   if (_registers.delay_timer > 0) {
     --_registers.delay_timer;
   }
-
   if (_registers.sound_timer > 0) {
     --_registers.sound_timer;
-    if (_registers.sound_timer == 0) {
-      _audioDevice.stopSound(SoundType::BEEP, ec);
-    } else {
-      _audioDevice.playSound(SoundType::BEEP, ec);
+  }
+
+  // the audio thread is only told about the changes of the sound, stamped
+  // with the emulated time of this vblank (the timers resolution)
+  if (_muted || !_audioDevice.isOpen()) {
+    return;
+  }
+  _audio_time += System::Audio::SAMPLES_PER_FRAME;
+
+  using System::Audio::AudioEvent;
+  if (_audio_pattern_changed.exchange(false)) {
+    AudioEvent event{_audio_time, AudioEvent::Type::PATTERN};
+    {
+      std::lock_guard lock(_audio_pattern_mutex);
+      event.pitch = _published_pitch;
+      event.pattern = _published_audio_pattern;
     }
+    _audioDevice.pushEvent(event);
+  }
+  bool tone = _registers.sound_timer > 0;
+  if (tone != _tone) {
+    _audioDevice.pushEvent({_audio_time, tone ? AudioEvent::Type::TONE_ON
+                                              : AudioEvent::Type::TONE_OFF});
+    _tone = tone;
   }
 }
 
-void VM::processInput() {
+template <typename Platform>
+void BasicVM<Platform>::publishAudioPattern() {
+  {
+    std::lock_guard lock(_audio_pattern_mutex);
+    _published_audio_pattern = _audio_pattern;
+    _published_pitch = _pitch;
+  }
+  _audio_pattern_changed.store(true);
+}
+
+template <typename Platform>
+void BasicVM<Platform>::pollInput() {
+  using namespace std::chrono;
+  constexpr duration<double> FRAME_TIME(1.0 / System::Graphics::TARGET_FPS);
+  double elapsed = (steady_clock::now() - _vblank_time) / FRAME_TIME;
+  std::uint16_t position =
+      static_cast<std::uint16_t>(std::clamp(elapsed * 65536, 0.0, 65535.0));
+  std::uint64_t frame = _vblank_count.load();
+
+  // keys pressed since the last poll, even if already released
+  std::uint16_t tapped = 0;
+  while (auto key = _keyboard.nextKeyPressed()) {
+    std::int8_t index = keypad_map[static_cast<std::size_t>(*key)];
+    if (index >= 0) {
+      tapped |= 1 << index;
+    }
+  }
+
+  auto queue = [&](std::uint8_t key, bool pressed) {
+    // a full queue drops the change, it is polled again next time
+    if (_input_events.push({frame, position, key, pressed})) {
+      _polled_keys[key] = pressed;
+    }
+  };
   for (std::uint8_t i = 0; i < KEY_MAPPED_COUNT; i++) {
-    _keyPressed[i] = _keyboard.isKeyDown(key_map.at(i));
+    bool down = _keyboard.isKeyDown(key_map[i]);
+    bool tap = tapped & (1 << i);
+    if (_polled_keys[i] && tap) {
+      // released and pressed again
+      queue(i, false);
+    }
+    if (!_polled_keys[i] && (down || tap)) {
+      queue(i, true);
+    }
+    if (_polled_keys[i] && !down) {
+      queue(i, false);
+    }
   }
 }
 
-void VM::drawLoop() {
+template <typename Platform>
+void BasicVM<Platform>::beginInputFrame() {
+  _input_frame = _vblank_count.load();
+  _input_latched = 0;
+  scheduleInput();
+}
+
+template <typename Platform>
+void BasicVM<Platform>::applyInput(std::uint32_t cycle) {
+  while (_next_input_cycle <= cycle) {
+    const InputEvent *event = _input_events.front();
+    if (!event) {
+      // the check was forced by a fault (see raiseFault()), not by a key
+      _next_input_cycle = NO_INPUT;
+      return;
+    }
+    _keyPressed[event->key] = event->pressed;
+    if (event->pressed) {
+      _input_latched |= 1 << event->key;
+    }
+    _input_events.pop();
+    scheduleInput();
+  }
+}
+
+template <typename Platform>
+void BasicVM<Platform>::scheduleInput() {
+  _next_input_cycle = NO_INPUT;
+  const InputEvent *event = _input_events.front();
+  if (!event || event->frame >= _input_frame) {
+    // polled during this frame, applied during the next one
+    return;
+  }
+  if (!event->pressed && (_input_latched & (1 << event->key))) {
+    // a key pressed during the frame stays down until its end, so that
+    // short presses are seen by the program
+    return;
+  }
+  if (event->frame + 1 < _input_frame) {
+    // late (ie: the CPU missed a frame)
+    _next_input_cycle = 0;
+    return;
+  }
+  _next_input_cycle = (event->position * _target_cycles.load()) >> 16;
+}
+
+template <typename Platform>
+void BasicVM<Platform>::drawLoop() {
+  bool first_frame = true;
   while (!_display.windowShouldClose() && _running.load()) {
     _display.drawFrame();
+    if (first_frame) {
+      System::Log::write(FIRST_FRAME, millisecondsSince(_turn_on_time));
+    }
+    first_frame = false;
+    if (_spectator_server || _frame_export || _recorder) {
+      _display.packFrontBuffer(_published_frame);
+    }
+    if (_spectator_server) {
+      _spectator_server->publish(_published_frame);
+    }
+    if (_frame_export) {
+      _frame_export->publish(_published_frame);
+    }
+    if (_recorder) {
+      _recorder->push(_published_frame);
+    }
   }
   _running.store(false);
-  _cpu_sleep_cv.notify_one();
+  wakeCpu();
 }
 
+template class BasicVM<SuperChip>;
+template class BasicVM<SuperChipModern>;
+template class BasicVM<SuperChipLegacy>;
+template class BasicVM<Chip8>;
+template class BasicVM<XOChip>;
+
 }  // namespace SuperChip8::Emulator
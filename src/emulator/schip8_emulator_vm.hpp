@@ -1,15 +1,27 @@
 #ifndef SUPERCHIP8_EMULATOR_VM_HPP
 #define SUPERCHIP8_EMULATOR_VM_HPP
 
+#include "schip8_emulator_cycletuner.hpp"
+#include "schip8_emulator_debug_debugger.hpp"
 #include "schip8_emulator_memory_ram.hpp"
 #include "schip8_emulator_memory_registers.hpp"
 #include "schip8_emulator_opcode.hpp"
+#include "schip8_emulator_platform.hpp"
+#include "schip8_spscring.hpp"
 #include "schip8_system_audio_audiodevice.hpp"
+#include "schip8_system_capture_recorder.hpp"
 #include "schip8_system_graphics_display.hpp"
 #include "schip8_system_input_keyboard.hpp"
+#include "schip8_system_stream_sharedframe.hpp"
+#include "schip8_system_stream_spectatorserver.hpp"
+#include "schip8_system_terminal_console.hpp"
 
 #include <atomic>
+#include <chrono>
 #include <condition_variable>
+#include <filesystem>
+#include <memory>
+#include <mutex>
 #include <random>
 #include <system_error>
 #include <thread>
@@ -18,25 +30,60 @@ namespace SuperChip8::Emulator {
 
 /// @brief SuperChip-8 Virtual Machine, responsible for running the emulator
 /// (CPU and external devices)
-class VM {
+///
+/// @details The memory size, the number of display planes, the XO-CHIP
+/// instructions and the quirks are set at compile time by the platform (see
+/// schip8_emulator_platform.hpp): the VM is instantiated once per platform in
+/// schip8_emulator_vm.cpp, and the opcode handlers carry no quirk check.
+/// @tparam Platform SuperChip (see VM), SuperChipModern, SuperChipLegacy,
+/// Chip8 or XOChip (see XOVM)
+template <typename Platform>
+class BasicVM {
  public:
+  using RAM = Memory::BasicRAM<Platform::MEMORY_SIZE>;
+  using Display = System::Graphics::BasicDisplay<Platform::PLANES>;
+
+  /// @brief Snapshot of the machine state, see saveState()
+  struct State {
+    RAM ram;
+    Memory::Registers registers;
+    typename Display::BackBuffer back_buffer;
+    std::mt19937 gen;
+    std::array<bool, 16> keyPressed;
+    std::int8_t key_awaiting_release;
+    System::Audio::AudioPattern audio_pattern;
+    std::uint8_t pitch;
+    bool running;
+  };
+
   /// @param target_cycles Target CPU cycles per frame
-  VM(std::uint16_t target_cycles);
+  BasicVM(std::uint16_t target_cycles);
 
   /// @brief Initialize the VM, load the program and start running
   ///
   /// @details This function initializes the memory, loads the fontset, loads
   /// the program, initializes the audio device, creates the display window, and
-  /// starts the CPU thread.
+  /// starts the CPU thread. The program is loaded (and verified) and the audio
+  /// device opened on their own threads, while the window is created: the CPU
+  /// thread starts once the three are done.
   /// @param program_path Path to the program to load
   /// @param ec error_code
   void turnOn(const std::string &program_path, std::error_code &ec);
 
   /// @brief Turn off the VM and clean up resources
   /// @details This function stops the CPU thread, closes the audio device, and
-  /// closes the display window.
+  /// closes the display window. It joins threads and takes locks: it must not
+  /// be called from a signal handler (see stop()).
   void turnOff();
 
+  /// @brief Ask a running VM to stop
+  ///
+  /// @details The draw loop returns at the end of its frame, turnOn() then
+  /// returns and the caller turns the VM off. A request made while turnOn() is
+  /// starting the VM stops it before its first frame. Only stores atomics: it
+  /// is async-signal-safe.
+  void stop();
+
   /// @brief Load a program into memory
   /// @param program_path Path to the program to load
   /// @param ec error_code
@@ -46,62 +93,412 @@ class VM {
   /// - Error::OUT_OF_RANGE | If the program is too large to fit in memory
   void loadProgram(const std::string &program_path, std::error_code &ec);
 
+  /// @brief Initialize the VM without any device (no window, no audio) and
+  /// load the program
+  ///
+  /// @details The VM is then driven by the caller through runFrame(), which
+  /// makes it suitable for tests and batch runs.
+  /// @param program_path Path to the program to load
+  /// @param ec error_code
+  void boot(const std::string &program_path, std::error_code &ec);
+
+  /// @brief Run one frame synchronously: the target CPU cycles followed by the
+  /// vblank (timers and buffer swap)
+  /// @param ec error_code, set if an instruction failed (the VM is then
+  /// stopped)
+  void runFrame(std::error_code &ec);
+
+  /// @brief Seed the random number generator (CXNN), for reproducible runs
+  /// @param seed The seed to use
+  void seed(std::uint32_t seed);
+
+  /// @brief Set the state of a keypad key, used when no keyboard is polled
+  /// @param key The keypad key (0x0 to 0xF)
+  /// @param pressed `true` if the key is down
+  void setKey(std::uint8_t key, bool pressed);
+
+  /// @return `true` while the program has not exited or failed
+  bool isRunning() const;
+
+  /// @return the number of instructions executed through runFrame()
+  std::uint64_t executedInstructions() const;
+
+  /// @return `true` if the loaded program is proven to stay in bounds (see
+  /// Analysis::verify()), it then runs without bounds checks
+  bool isVerified() const;
+
+  const Display &display() const;
+  const Memory::Registers &registers() const;
+
+  /// @brief Fork the VM into a new headless VM, driven through runFrame()
+  ///
+  /// @details The child starts from the exact same state (registers, RAM,
+  /// framebuffer, keys and random generator state). The RAM pages (256 bytes)
+  /// and the back buffer rows are shared copy-on-write between the parent and
+  /// the child, so a fork only costs the pages it later writes to. Must not be
+  /// called while the VM is executing instructions (ie: between two
+  /// runFrame() calls).
+  /// @return the child VM
+  std::unique_ptr<BasicVM> fork() const;
+
+  /// @brief Snapshot the machine state (registers, RAM, back buffer, keys and
+  /// random generator)
+  ///
+  /// @details The RAM pages and back buffer rows are shared copy-on-write with
+  /// the VM, so a snapshot costs a few pointer copies. Same constraint as
+  /// fork(): not while the VM is executing instructions.
+  /// @return the snapshot
+  State saveState() const;
+
+  /// @brief Restore a snapshot taken by saveState()
+  /// @param state The snapshot to restore
+  void loadState(const State &state);
+
+  /// @brief Set the run-ahead depth, before turnOn()
+  ///
+  /// @details With a depth of N, each frame the VM emulates the real frame,
+  /// saves its state, runs N more frames with the same input (muted) and
+  /// presents the last one, then restores the real state before the next
+  /// frame. The lag frames of the game are hidden from the player. Run-ahead
+  /// runs the CPU on the display thread, between frame draws, instead of the
+  /// CPU thread.
+  /// @param frames The number of frames to run ahead (0 to disable)
+  void setRunAhead(std::uint8_t frames);
+
+  /// @brief Run the CPU on the display thread, before turnOn()
+  ///
+  /// @details Each vblank then runs the CPU frame, the timers, the input and
+  /// the draw in order on a single thread: no CPU thread to wake up, and no
+  /// back buffer lock. The CPU runs exactly the target cycles per frame, as
+  /// headless (deterministic timing). Ignored with a debugger.
+  /// @param single_thread `true` to run on a single thread
+  void setSingleThread(bool single_thread);
+
+  /// @brief Tune the target cycles per frame to the program, before turnOn()
+  ///
+  /// @details The target cycles given to the constructor are the starting
+  /// point, unless the store has a value for the ROM: the CPU then moves them
+  /// from the activity of each frame (see CycleTuner), and turnOff() stores
+  /// the result. Ignored with a debugger.
+  /// @param store The cycle store (see defaultCycleStorePath()), empty to tune
+  /// without storing
+  void setAutoCycles(const std::filesystem::path &store);
+
+  /// @brief Set the upscaling filter of the window, before turnOn()
+  /// @param filter The filter (see schip8_system_graphics_filter.hpp)
+  void setFilter(System::Graphics::Filter filter);
+
+  /// @brief Wait for the monitor refresh to present the frames, before
+  /// turnOn() (see Display::setVSync())
+  /// @param vsync `true` to enable the vsync
+  void setVSync(bool vsync);
+
+  /// @brief Skip the drawing of the frames while the host cannot keep up,
+  /// before turnOn() (see Display::setFrameSkip())
+  ///
+  /// @details The CPU and the timers keep running 60 frames per second, only
+  /// the drawing and the presenting are skipped.
+  /// @param max_skip The most frames skipped in a row (0 to disable)
+  void setFrameSkip(std::uint8_t max_skip);
+
+  /// @brief Print the histogram of the frame intervals (to stderr) on
+  /// turnOff(), before turnOn()
+  /// @param frame_stats `true` to print it
+  void setFrameStats(bool frame_stats);
+
+  /// @brief Attach an interactive debugger, before turnOn()
+  ///
+  /// @details The CPU thread then runs the instrumented loop (see
+  /// Debug::Debugger), the normal loop has no debugger check. Run-ahead is
+  /// disabled while debugging.
+  /// @param debugger The debugger
+  void attachDebugger(std::unique_ptr<Debug::Debugger> debugger);
+
+  /// @brief Attach a spectator server, before turnOn()
+  ///
+  /// @details The front buffer is published to it after each frame draw.
+  /// @param spectator_server The listening server
+  void attachSpectatorServer(
+      std::unique_ptr<System::Stream::SpectatorServer> spectator_server);
+
+  /// @brief Attach a shared-memory frame export, before turnOn()
+  ///
+  /// @details The front buffer is written to it after each frame draw.
+  /// @param frame_export The open export
+  void attachFrameExport(
+      std::unique_ptr<System::Stream::SharedFrameWriter> frame_export);
+
+  /// @brief Attach a gameplay recorder, before turnOn()
+  ///
+  /// @details The front buffer is queued to it after each frame draw, the
+  /// video is finished by turnOff().
+  /// @param recorder The open recorder
+  void attachRecorder(std::unique_ptr<System::Capture::Recorder> recorder);
+
+  /// @brief Attach a terminal console, in place of the window, before
+  /// turnOn()
+  ///
+  /// @details The frames are drawn and the keys read in the terminal, and the
+  /// audio device is not opened (ie: a display-less server, over SSH).
+  /// @param console The console, opened by turnOn()
+  void attachConsole(std::unique_ptr<System::Terminal::Console> console);
+
  private:
+  /// @brief Fork constructor, see fork()
+  BasicVM(const BasicVM &parent);
+
   /// @brief Main CPU loop
+  /// @tparam DebugPolicy Debug::NoDebugger, or Debug::Debugger for the
+  /// instrumented loop
+  /// @tparam CHECKED `false` to run a verified program without bounds checks
+  template <typename DebugPolicy, bool CHECKED>
   void run(std::error_code &ec);
 
+  /// @brief Fetch, decode and execute a single instruction, a failure is
+  /// raised as a fault (see raiseFault())
+  void step();
+
+  /// @brief Fetch, decode and execute a single instruction of a verified
+  /// program: the RAM and stack accesses are not checked, and no instruction
+  /// can fail
+  void stepUnchecked();
+
+  /// @brief Skip the next instruction (XO-CHIP: F000 NNNN is 4 bytes long)
+  void skipInstruction();
+
+  /// @brief Execute the target cycles of a frame, a fault is returned in ec
+  /// (see stopOnFault())
+  void executeCycles(std::error_code &ec);
+  template <bool CHECKED>
+  void executeCyclesLoop(std::error_code &ec);
+
+  /// @brief Vblank handler in run-ahead mode, emulates the real frame then
+  /// runs ahead
+  void runAheadFrame();
+
+  /// @brief Zero the memory and registers and load the fontset
+  void initializeMemory(std::error_code &ec);
+
   /// @brief Draw loop
   void drawLoop();
 
-  void executeOpcode(const Opcode &opcode, std::error_code &ec);
-
-  void executeCategory0(const Opcode &opcode, std::error_code &ec);
-  void executeCategory1(const Opcode &opcode, std::error_code &ec);
-  void executeCategory2(const Opcode &opcode, std::error_code &ec);
-  void executeCategory3(const Opcode &opcode, std::error_code &ec);
-  void executeCategory4(const Opcode &opcode, std::error_code &ec);
-  void executeCategory5(const Opcode &opcode, std::error_code &ec);
-  void executeCategory6(const Opcode &opcode, std::error_code &ec);
-  void executeCategory7(const Opcode &opcode, std::error_code &ec);
-  void executeCategory8(const Opcode &opcode, std::error_code &ec);
-  void executeCategory9(const Opcode &opcode, std::error_code &ec);
-  void executeCategoryA(const Opcode &opcode, std::error_code &ec);
-  void executeCategoryB(const Opcode &opcode, std::error_code &ec);
-  void executeCategoryC(const Opcode &opcode, std::error_code &ec);
-  void executeCategoryD(const Opcode &opcode, std::error_code &ec);
-  void executeCategoryE(const Opcode &opcode, std::error_code &ec);
-  void executeCategoryF(const Opcode &opcode, std::error_code &ec);
-
-  Memory::RAM _ram;
+  void executeOpcode(const Opcode &opcode);
+
+  void executeCategory0(const Opcode &opcode);
+  void executeCategory1(const Opcode &opcode);
+  void executeCategory2(const Opcode &opcode);
+  void executeCategory3(const Opcode &opcode);
+  void executeCategory4(const Opcode &opcode);
+  void executeCategory5(const Opcode &opcode);
+  void executeCategory6(const Opcode &opcode);
+  void executeCategory7(const Opcode &opcode);
+  void executeCategory8(const Opcode &opcode);
+  void executeCategory9(const Opcode &opcode);
+  void executeCategoryA(const Opcode &opcode);
+  void executeCategoryB(const Opcode &opcode);
+  void executeCategoryC(const Opcode &opcode);
+  void executeCategoryD(const Opcode &opcode);
+  void executeCategoryE(const Opcode &opcode);
+  void executeCategoryF(const Opcode &opcode);
+
+  RAM _ram;
   Memory::Registers _registers;
   System::Audio::AudioDevice _audioDevice;
-  System::Graphics::Display _display;
+  Display _display;
   System::Input::Keyboard _keyboard;
 
   // Random number generator
-  std::random_device _rd;
   std::mt19937 _gen;
   std::uniform_int_distribution<std::uint16_t> _dist;
 
   // vm state
   std::atomic<bool> _running = false;
+  // stop() was called, the VM does not start again
+  std::atomic<bool> _stop_requested = false;
   std::atomic<bool> _program_loaded = false;
+  // the program is proven to stay in bounds
+  bool _verified = false;
+  // a DXYN is waiting for the vblank (Platform::DISPLAY_WAIT)
+  bool _vblank_wait = false;
+
+  /// @brief Failure of an instruction, kept until the CPU loop takes it
+  enum class Fault : std::uint8_t {
+    NONE,
+    OUT_OF_RANGE,
+    STACK_OVERFLOW,
+    STACK_UNDERFLOW,
+    UNKNOWN_OPCODE
+  };
+  // first fault raised since the last takeFault()
+  Fault _fault = Fault::NONE;
+  // address of the instruction that raised _fault
+  std::uint16_t _fault_pc = 0;
+
+  /** Deferred faults
+   *
+   * The opcode handlers take no error_code: a failing instruction raises a
+   * fault and returns, and the CPU loop checks it between two instructions.
+   * Raising a fault also sets _next_input_cycle to 0, so the check rides on
+   * the input cycle comparison the loop already makes before each
+   * instruction, and the instructions that do not fail test nothing more.
+   * The loop checks it again once at the end of a frame. The unchecked path
+   * of a verified program makes the same checks, which cost nothing per
+   * instruction: a fault the verifier missed is still reported, and
+   * applyInput() never takes it for a key change.
+   */
+  /// @brief Raise a fault (the first one is kept), stopping the CPU before
+  /// the next instruction
+  /// @param fault The fault
+  void raiseFault(Fault fault);
+  /// @brief Log an unknown opcode and raise its fault
+  /// @param opcode The opcode, fetched at pc - 2
+  void raiseUnknownOpcode(const Opcode &opcode);
+  /// @brief Take the raised fault
+  /// @return the error of the fault
+  std::error_code takeFault();
+  /// @brief Log a fault and stop the VM, once its error is stored where the
+  /// draw loop reads it
+  /// @param ec The error of the fault
+  void stopOnFault(const std::error_code &ec);
+
+  /// @brief Wake the CPU thread up after a change of _cycle or _running
+  ///
+  /// @details The change is made before taking _cpu_sleep_mutex, so that it
+  /// cannot fall between the check of the sleeping thread and its wait (a
+  /// lost wakeup, that would leave it asleep until the next vblank, or
+  /// forever once the VM is stopped).
+  void wakeCpu();
+
+  // Checked memory accesses of the opcode handlers, an access out of the
+  // RAM raises Fault::OUT_OF_RANGE (and reads 0)
+  std::uint8_t readByte(std::uint16_t address);
+  std::uint16_t readWord(std::uint16_t address);
+  void writeByte(std::uint16_t address, std::uint8_t value);
+  void readData(std::uint16_t address, std::uint8_t *data, std::size_t size);
+
+  /// @brief Key press or release, stamped with its position in the frame it
+  /// was polled in
+  struct InputEvent {
+    // vblanks counted when polled
+    std::uint64_t frame;
+    // position in the frame, in 1/65536th of a frame
+    std::uint16_t position;
+    std::uint8_t key;
+    bool pressed;
+  };
+  static constexpr std::size_t INPUT_EVENT_CAPACITY = 64;
+  // _next_input_cycle when no key change is due in the frame
+  static constexpr std::uint32_t NO_INPUT = UINT32_MAX;
 
   // For Vblank [executed between each frame] (ie: 60Hz)
   void handleVBlankInterrupt();
-  void updateTimers(std::error_code &ec);
-  void processInput();
+  /// @brief Run a CPU frame and the timers on the display thread (run-ahead
+  /// and single thread modes), the error is kept in _cpu_error
+  void runCpuFrame();
+  void updateTimers();
+  /// @brief End a CPU frame: tune the target cycles from its activity (CPU
+  /// thread)
+  void endCpuFrame();
+
+  /// @brief Poll the keyboard and queue the key changes (display thread)
+  void pollInput();
+  /// @brief Start a CPU frame: the key changes polled during the previous
+  /// frame are applied at the same position in this one
+  void beginInputFrame();
+  /// @brief Apply the queued key changes due at a cycle of the frame
+  /// @param cycle The cycle about to be executed
+  void applyInput(std::uint32_t cycle);
+  /// @brief Set _next_input_cycle from the oldest queued key change
+  void scheduleInput();
 
-  // array used to store which keys are pressed
+  // array used to store which keys are pressed (CPU thread)
   std::array<bool, 16> _keyPressed = {false};
 
+  // INPUT [polled by the display thread, applied by the CPU thread]
+  SpscRing<InputEvent, INPUT_EVENT_CAPACITY> _input_events;
+  std::atomic<std::uint64_t> _vblank_count = 0;
+  // display thread: last vblank, keys reported down
+  std::chrono::steady_clock::time_point _vblank_time;
+  std::array<bool, 16> _polled_keys = {false};
+  // CPU thread: frame being executed, cycle of the next key change, keys
+  // pressed during the frame (held until its end)
+  std::uint64_t _input_frame = 0;
+  std::uint32_t _next_input_cycle = NO_INPUT;
+  std::uint16_t _input_latched = 0;
+  // key pressed during a WAIT_KEY (FX0A), waiting to be released (-1 if none)
+  std::int8_t _key_awaiting_release = -1;
+
+  // audio pattern and pitch, set by F002 and FX3A on XO-CHIP (CPU thread)
+  System::Audio::AudioPattern _audio_pattern =
+      System::Audio::DEFAULT_AUDIO_PATTERN;
+  std::uint8_t _pitch = System::Audio::DEFAULT_PITCH;
+  /// @brief Hand a change of _audio_pattern or _pitch over to updateTimers(),
+  /// which runs on the display thread while the CPU thread runs
+  void publishAudioPattern();
+  // copy of the pattern and the pitch taken by updateTimers(), under
+  // _audio_pattern_mutex (F002 and FX3A are rare: the lock is uncontended)
+  std::mutex _audio_pattern_mutex;
+  System::Audio::AudioPattern _published_audio_pattern =
+      System::Audio::DEFAULT_AUDIO_PATTERN;
+  std::uint8_t _published_pitch = System::Audio::DEFAULT_PITCH;
+  // the copy changed since the last audio event, set after it and cleared
+  // before reading it: a change is at worst sent twice, never lost
+  std::atomic<bool> _audio_pattern_changed = false;
+  // emulated time of the next vblank, in samples (see AudioEvent)
+  std::uint64_t _audio_time = 0;
+  // the sound timer was running at the last vblank
+  bool _tone = false;
+
   // for CPU cycles
   std::atomic<std::uint16_t> _cycle = 0;
   std::atomic<std::uint16_t> _target_cycles;
+  // instructions executed by runFrame() since boot()
+  std::uint64_t _executed_instructions = 0;
+
+  // automatic cycles per frame, see setAutoCycles()
+  bool _auto_cycles = false;
+  std::filesystem::path _cycle_store;
+  CycleTuner _cycle_tuner;
+  // counted by the CPU during the current frame
+  FrameActivity _frame_activity;
+  // FNV-1a hash of the loaded program
+  std::uint64_t _rom_hash = 0;
+
+  // the CPU runs in the vblank handler, see setSingleThread()
+  bool _single_thread = false;
+
+  // run-ahead
+  std::uint8_t _run_ahead_frames = 0;
+  // real state, to restore before the next frame
+  std::unique_ptr<State> _run_ahead_state;
+  // the frames run ahead are not heard
+  bool _muted = false;
+  // error raised by the CPU when it runs on the display thread
+  std::error_code _cpu_error;
+
+  // startup time breakdown (logged)
+  std::chrono::steady_clock::time_point _turn_on_time;
+  // frame interval histogram, see setFrameStats()
+  bool _frame_stats = false;
+
+  // interactive debugger, if attached
+  std::unique_ptr<Debug::Debugger> _debugger;
+  // frame outputs, if attached, and the frame published to them
+  std::unique_ptr<System::Stream::SpectatorServer> _spectator_server;
+  std::unique_ptr<System::Stream::SharedFrameWriter> _frame_export;
+  std::unique_ptr<System::Capture::Recorder> _recorder;
+  // terminal drawn to and read from instead of the window, if attached
+  std::unique_ptr<System::Terminal::Console> _console;
+  System::Graphics::Frame _published_frame;
   std::jthread _cpu_thread;
+  // the CPU thread sleeps between two frames, see wakeCpu()
+  std::mutex _cpu_sleep_mutex;
   std::condition_variable _cpu_sleep_cv;
 };
 
+using VM = BasicVM<SuperChip>;
+using XOVM = BasicVM<XOChip>;
+
 }  // namespace SuperChip8::Emulator
 
 #endif  // SUPERCHIP8_EMULATOR_VM_HPP
\ No newline at end of file
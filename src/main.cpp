@@ -1,21 +1,180 @@
 #include "schip8_emulator_vm.hpp"
+#include "schip8_system_log_logger.hpp"
 
 #include <csignal>
 #include <cxxopts.hpp>
+#include <functional>
 #include <iostream>
+#include <mutex>
+#include <pthread.h>
 #include <raylib.h>
+#include <thread>
 
-// here to be able to properly close the VM on signal
-SuperChip8::Emulator::VM *g_vm = nullptr;
+// SIGINT and SIGTERM are blocked in every thread, and taken by the signal
+// thread (see handleSignals()): a signal never interrupts a thread the VM
+// then joins or destroys
+std::mutex g_signal_mutex;
+// here to be able to stop the VM on signal, set while a VM is running
+// (main() then turns the VM off)
+std::function<void()> g_stop;
+// a signal came before the VM was started
+bool g_stop_requested = false;
+// here to break into the debugger on SIGINT
+SuperChip8::Emulator::Debug::Debugger *g_debugger = nullptr;
+
+/// @brief Signal thread, stops the VM (or breaks into the debugger)
+/// @param signals The signals blocked in the other threads
+void handleSignals(sigset_t signals) {
+  while (true) {
+    int signal = 0;
+    if (sigwait(&signals, &signal) != 0) {
+      continue;
+    }
+    std::lock_guard lock(g_signal_mutex);
+    if (signal == SIGINT && g_debugger) {
+      g_debugger->pause();
+    } else if (g_stop) {
+      g_stop();
+    } else {
+      g_stop_requested = true;
+    }
+  }
+}
+
+/// @brief Run the ROM until the window is closed
+/// @tparam Machine The VM of the platform (see BasicVM)
+template <typename Machine>
+int run(const cxxopts::ParseResult &result) {
+  Machine vm(result["cpu"].as<std::uint16_t>());
+  vm.setRunAhead(result["run-ahead"].as<std::uint8_t>());
+  vm.setSingleThread(result.count("single-thread"));
+  if (result.count("auto-cycles")) {
+    vm.setAutoCycles(SuperChip8::Emulator::defaultCycleStorePath());
+  }
+  SuperChip8::System::Graphics::Filter filter;
+  if (!SuperChip8::System::Graphics::parseFilter(
+          result["filter"].as<std::string>(), filter)) {
+    std::cerr << "Error: unknown filter " << result["filter"].as<std::string>()
+              << " (nearest, scale2x, epx, scale3x, scanlines)" << std::endl;
+    return 1;
+  }
+  vm.setFilter(filter);
+  vm.setVSync(result.count("vsync"));
+  vm.setFrameSkip(result["frame-skip"].as<std::uint8_t>());
+  vm.setFrameStats(result.count("frame-stats"));
+  if (result.count("spectate")) {
+    auto server = std::make_unique<SuperChip8::System::Stream::SpectatorServer>(
+        result["keyframe-interval"].as<std::uint32_t>());
+    std::error_code ec;
+    server->listen(result["spectate"].as<std::string>(), ec);
+    if (ec) {
+      std::cerr << "Error: " << ec.message() << std::endl;
+      return 1;
+    }
+    vm.attachSpectatorServer(std::move(server));
+  }
+  if (result.count("export-shm")) {
+    auto frame_export =
+        std::make_unique<SuperChip8::System::Stream::SharedFrameWriter>();
+    std::error_code ec;
+    frame_export->open(result["export-shm"].as<std::string>(), ec);
+    if (ec) {
+      std::cerr << "Error: " << ec.message() << std::endl;
+      return 1;
+    }
+    vm.attachFrameExport(std::move(frame_export));
+  }
+  if (result.count("capture")) {
+    auto recorder = std::make_unique<SuperChip8::System::Capture::Recorder>();
+    std::error_code ec;
+    recorder->open(result["capture"].as<std::string>(),
+                   result["capture-scale"].as<std::uint8_t>(), ec);
+    if (ec) {
+      std::cerr << "Error: " << ec.message() << std::endl;
+      return 1;
+    }
+    vm.attachRecorder(std::move(recorder));
+  }
+  if (result.count("terminal")) {
+    std::string glyphs = result["terminal"].as<std::string>();
+    if (glyphs != "half" && glyphs != "braille") {
+      std::cerr << "Error: unknown terminal glyphs " << glyphs
+                << " (half, braille)" << std::endl;
+      return 1;
+    }
+    vm.attachConsole(std::make_unique<SuperChip8::System::Terminal::Console>(
+        glyphs == "braille"
+            ? SuperChip8::System::Terminal::Console::Glyphs::BRAILLE
+            : SuperChip8::System::Terminal::Console::Glyphs::HALF_BLOCKS));
+  }
+  if (result.count("debug")) {
+    auto debugger = std::make_unique<SuperChip8::Emulator::Debug::Debugger>();
+    {
+      std::lock_guard lock(g_signal_mutex);
+      g_debugger = debugger.get();
+    }
+    vm.attachDebugger(std::move(debugger));
+  }
+  {
+    std::lock_guard lock(g_signal_mutex);
+    g_stop = [&vm]() { vm.stop(); };
+    if (g_stop_requested) {
+      vm.stop();
+    }
+  }
+  std::error_code ec;
+  vm.turnOn(result["rom"].as<std::string>(), ec);
+  // a stopped VM, or a failed one, is turned off here (joins the threads,
+  // finishes the video)
+  vm.turnOff();
+  {
+    std::lock_guard lock(g_signal_mutex);
+    g_stop = nullptr;
+    g_debugger = nullptr;
+  }
+  if (ec) {
+    std::cerr << "Error: " << ec.message() << std::endl;
+    return 1;
+  }
+
+  return 0;
+}
 
 int main(int argc, char *argv[]) {
+  // before any thread is started, they inherit the mask
+  sigset_t signals;
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGINT);
+  sigaddset(&signals, SIGTERM);
+  pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+  std::thread(handleSignals, signals).detach();
+
   cxxopts::Options options("SuperChip8", "SuperChip8 Emulator");
 
   // clang-format off
   options.add_options()
   ("h,help", "Print help")
   ("r,rom", "Path to the ROM file", cxxopts::value<std::string>())
-  ("c, cpu", "CPU cycles per frame - [Slow 5] | [Normal 10] | [Fast 100]", cxxopts::value<std::uint16_t>()->default_value("10"));
+  ("c, cpu", "CPU cycles per frame - [Slow 5] | [Normal 10] | [Fast 100]", cxxopts::value<std::uint16_t>()->default_value("10"))
+  ("auto-cycles", "Tune the CPU cycles per frame to the ROM, starting from -c or the value stored at the last launch")
+  ("run-ahead", "Frames to run ahead to hide the input lag of the ROM - [Off 0] | [Usual 1-2]", cxxopts::value<std::uint8_t>()->default_value("0"))
+  ("single-thread", "Run the CPU, the timers, the input and the draw in order on a single thread")
+  ("d,debug", "Start the interactive debugger (commands on stdin, see help)")
+  ("p,platform", "Platform and quirks - [schip] | [schip-modern] | [schip-legacy] | [chip8] | [xo-chip] (default: xo-chip for .xo8 files, schip otherwise)", cxxopts::value<std::string>())
+  ("x,xo-chip", "Run the ROM as an XO-CHIP program, same as -p xo-chip")
+  ("v,verbose", "Log the startup time breakdown, the capture statistics and the tuned cycles, same as --log-level info")
+  ("spectate", "Stream the frames to spectators (see SuperChip8_viewer) - [unix:<path>] | [tcp:[<host>:]<port>]", cxxopts::value<std::string>())
+  ("keyframe-interval", "Frames between two keyframes of the spectator stream", cxxopts::value<std::uint32_t>()->default_value("60"))
+  ("export-shm", "Export the frames in a shared-memory object (see SuperChip8_shmreader), ie: /schip8", cxxopts::value<std::string>())
+  ("capture", "Record the gameplay to a video file - [<file>.y4m] | [<file>.gif]", cxxopts::value<std::string>())
+  ("capture-scale", "Integer scale of the recorded video (1: 128x64) - [1-16]", cxxopts::value<std::uint8_t>()->default_value("1"))
+  ("f,filter", "Upscaling filter of the window - [nearest] | [scale2x] | [epx] | [scale3x] | [scanlines]", cxxopts::value<std::string>()->default_value("nearest"))
+  ("vsync", "Wait for the monitor refresh to present the frames (paced by the monitor at 60 Hz)")
+  ("frame-skip", "Most frames in a row skipped (emulated, not drawn) while the host cannot keep up - [Off 0] | [Usual 2-4]", cxxopts::value<std::uint8_t>()->default_value("0"))
+  ("frame-stats", "Print the histogram of the frame intervals (p50, p90, p99) on exit")
+  ("t,terminal", "Draw in the terminal instead of a window, Escape quits - [half] | [braille]", cxxopts::value<std::string>())
+  ("log", "Append the log to a file instead of stderr", cxxopts::value<std::string>())
+  ("log-level", "Lowest level logged - [debug] | [info] | [warning] | [error] | [off]", cxxopts::value<std::string>()->default_value("warning"));
   // clang-format on
 
   // arg parsing
@@ -30,30 +189,62 @@ int main(int argc, char *argv[]) {
     return 1;
   }
 
-  // signal handling
-  std::signal(SIGINT, [](int) {
-    if (g_vm) {
-      g_vm->turnOff();
-    }
-    exit(0);
-  });
-  std::signal(SIGTERM, [](int) {
-    if (g_vm) {
-      g_vm->turnOff();
-    }
-    exit(0);
-  });
+  if (result.count("terminal") && result.count("debug")) {
+    std::cerr << "Error: the debugger and the terminal both need stdin"
+              << std::endl;
+    return 1;
+  }
 
-  SuperChip8::Emulator::VM vm(result["cpu"].as<std::uint16_t>());
-  g_vm = &vm;
-  std::error_code ec;
-  vm.turnOn(result["rom"].as<std::string>(), ec);
-  if (ec) {
-    std::cerr << "Error: " << ec.message() << std::endl;
+  SuperChip8::System::Log::Logger &logger =
+      SuperChip8::System::Log::Logger::instance();
+  SuperChip8::System::Log::Level log_level;
+  if (!SuperChip8::System::Log::parseLevel(
+          result["log-level"].as<std::string>(), log_level)) {
+    std::cerr << "Error: unknown log level "
+              << result["log-level"].as<std::string>()
+              << " (debug, info, warning, error, off)" << std::endl;
     return 1;
   }
+  if (result.count("verbose") && !result.count("log-level")) {
+    log_level = SuperChip8::System::Log::Level::INFO;
+  }
+  if (result.count("terminal") && !result.count("log")) {
+    // stderr is the terminal drawn in: a record would stay over the frames
+    // (only the cells that change are redrawn)
+    if (result.count("log-level") || result.count("verbose")) {
+      std::cerr << "Error: the terminal needs --log <file> to log"
+                << std::endl;
+      return 1;
+    }
+    log_level = SuperChip8::System::Log::Level::OFF;
+  }
+  logger.setLevel(log_level);
+  if (result.count("log")) {
+    std::error_code ec;
+    logger.open(result["log"].as<std::string>(), ec);
+    if (ec) {
+      std::cerr << "Error: " << ec.message() << std::endl;
+      return 1;
+    }
+  }
 
-  vm.turnOff();
+  std::string platform(SuperChip8::Emulator::defaultPlatform(
+      result["rom"].as<std::string>()));
+  if (result.count("platform")) {
+    platform = result["platform"].as<std::string>();
+  }
+  if (result.count("xo-chip")) {
+    platform = SuperChip8::Emulator::XOChip::NAME;
+  }
 
-  return 0;
+  // the interpreter of the platform is picked once, here
+  int status = 1;
+  if (!SuperChip8::Emulator::visitPlatform(platform, [&](auto tag) {
+        status = run<SuperChip8::Emulator::BasicVM<decltype(tag)>>(result);
+      })) {
+    std::cerr << "Error: unknown platform " << platform << " ("
+              << SuperChip8::Emulator::PLATFORM_NAMES << ")" << std::endl;
+    return 1;
+  }
+  return status;
 }
\ No newline at end of file
@@ -0,0 +1,144 @@
+#ifndef SUPERCHIP8_COWPAGES_HPP
+#define SUPERCHIP8_COWPAGES_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+
+namespace SuperChip8 {
+
+/// @brief Fixed number of pages shared between copies, copy-on-write
+///
+/// @details Copying a CowPages only copies the page pointers: both copies
+/// share every page until one of them writes to it, and only that page is then
+/// duplicated. Used to fork the machine state (RAM pages, framebuffer rows) at
+/// almost no cost.
+///
+/// Until it is first copied, a CowPages keeps its pages in one flat block,
+/// accessed without any sharing check (ie: the RAM of a VM that is never
+/// forked). The first copy moves the pages of its source out of the block.
+///
+/// Each copy must be used by one thread at a time, and a copy must not be
+/// made while its source is written or copied on another thread. The copies sharing a page may then live
+/// on different threads: a page is written in place only once no other copy
+/// holds it, and the use_count() read that tells it is a relaxed load, so an
+/// acquire fence orders the last accesses of the other copies (released when
+/// they dropped the page) before the write.
+/// @tparam Page The page type (ie: std::array<std::uint8_t, 256>)
+/// @tparam COUNT The number of pages
+template <typename Page, std::size_t COUNT>
+class CowPages {
+ public:
+  /// @brief Allocate COUNT value-initialized (zeroed) pages, in a flat block
+  CowPages() : _flat(std::make_unique<std::array<Page, COUNT>>()) {}
+
+  /// @brief Share every page of another copy (moved out of its flat block
+  /// first)
+  CowPages(const CowPages &other) : _pages(other.unflatten()) {}
+
+  CowPages &operator=(const CowPages &other) {
+    if (this != &other) {
+      _pages = other.unflatten();
+      _flat.reset();
+    }
+    return *this;
+  }
+
+  CowPages(CowPages &&other) = default;
+  CowPages &operator=(CowPages &&other) = default;
+
+  /// @brief Read access to a page
+  /// @param index The page index
+  const Page &read(std::size_t index) const {
+    return _flat ? (*_flat)[index] : *_pages[index];
+  }
+
+  /// @brief Write access to a page, duplicated first if it is shared
+  /// @param index The page index
+  Page &write(std::size_t index) {
+    if (_flat) {
+      return (*_flat)[index];
+    }
+    std::shared_ptr<Page> &page = _pages[index];
+    if (page.use_count() > 1) {
+      page = std::make_shared<Page>(*page);
+    } else {
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *page;
+  }
+
+  /// @brief Write access to a page whose content is about to be entirely
+  /// replaced: a shared page is not copied, a new zeroed one is used instead
+  /// @param index The page index
+  Page &overwrite(std::size_t index) {
+    if (_flat) {
+      return (*_flat)[index];
+    }
+    std::shared_ptr<Page> &page = _pages[index];
+    if (page.use_count() > 1) {
+      page = std::make_shared<Page>();
+    } else {
+      std::atomic_thread_fence(std::memory_order_acquire);
+    }
+    return *page;
+  }
+
+  /// @brief Zero every page: the flat block in one pass, or the pages one by
+  /// one as with overwrite()
+  void clear() {
+    if (_flat) {
+      _flat->fill(Page{});
+      return;
+    }
+    for (std::size_t index = 0; index < COUNT; index++) {
+      overwrite(index) = Page{};
+    }
+  }
+
+  /// @brief Make a page share the content of another one (ie: to move rows
+  /// without copying them)
+  /// @param destination The page index to replace
+  /// @param source The page index to share
+  void share(std::size_t destination, std::size_t source) {
+    if (_flat) {
+      (*_flat)[destination] = (*_flat)[source];
+      return;
+    }
+    _pages[destination] = _pages[source];
+  }
+
+  /// @return the number of pages shared with another copy
+  std::size_t sharedPages() const {
+    if (_flat) {
+      return 0;
+    }
+    std::size_t shared = 0;
+    for (const std::shared_ptr<Page> &page : _pages) {
+      shared += page.use_count() > 1;
+    }
+    return shared;
+  }
+
+ private:
+  /// @brief Move the pages out of the flat block, to be shared
+  /// @return the pages
+  const std::array<std::shared_ptr<Page>, COUNT> &unflatten() const {
+    if (_flat) {
+      for (std::size_t index = 0; index < COUNT; index++) {
+        _pages[index] = std::make_shared<Page>((*_flat)[index]);
+      }
+      _flat.reset();
+    }
+    return _pages;
+  }
+
+  // the pages until the first copy (then null)
+  mutable std::unique_ptr<std::array<Page, COUNT>> _flat;
+  mutable std::array<std::shared_ptr<Page>, COUNT> _pages;
+};
+
+}  // namespace SuperChip8
+
+#endif  // SUPERCHIP8_COWPAGES_HPP
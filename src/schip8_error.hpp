@@ -7,15 +7,22 @@ namespace SuperChip8 {
 
 enum class Error {
   FAILED_TO_OPEN_AUDIO_DEVICE,
-  FAILED_TO_LOAD_SOUND,
-  SOUND_NOT_FOUND,
   WINDOW_CREATION_ERROR,
   BUFFER_OVERFLOW,
   OUT_OF_RANGE,
   STACK_OVERFLOW,
   STACK_UNDERFLOW,
   FILE_NOT_FOUND,
-  UNKNOWN_OPCODE
+  UNKNOWN_OPCODE,
+  INVALID_INPUT_SCRIPT,
+  INVALID_STREAM_ADDRESS,
+  STREAM_SOCKET_ERROR,
+  SHARED_MEMORY_ERROR,
+  INVALID_CAPTURE_FORMAT,
+  CAPTURE_FILE_ERROR,
+  TERMINAL_ERROR,
+  CYCLE_STORE_ERROR,
+  LOG_FILE_ERROR
 };
 
 class ErrorCategory : public std::error_category {
@@ -25,10 +32,6 @@ class ErrorCategory : public std::error_category {
     switch (static_cast<Error>(condition)) {
       case Error::FAILED_TO_OPEN_AUDIO_DEVICE:
         return "Failed to open audio device";
-      case Error::FAILED_TO_LOAD_SOUND:
-        return "Failed to load sound";
-      case Error::SOUND_NOT_FOUND:
-        return "Sound not found";
       case Error::WINDOW_CREATION_ERROR:
         return "Window creation error";
       case Error::BUFFER_OVERFLOW:
@@ -43,6 +46,24 @@ class ErrorCategory : public std::error_category {
         return "File not found";
       case Error::UNKNOWN_OPCODE:
         return "Unknown opcode";
+      case Error::INVALID_INPUT_SCRIPT:
+        return "Invalid input script";
+      case Error::INVALID_STREAM_ADDRESS:
+        return "Invalid stream address";
+      case Error::STREAM_SOCKET_ERROR:
+        return "Stream socket error";
+      case Error::SHARED_MEMORY_ERROR:
+        return "Shared memory error";
+      case Error::INVALID_CAPTURE_FORMAT:
+        return "Invalid capture format";
+      case Error::CAPTURE_FILE_ERROR:
+        return "Capture file error";
+      case Error::TERMINAL_ERROR:
+        return "Terminal error";
+      case Error::CYCLE_STORE_ERROR:
+        return "Cycle store error";
+      case Error::LOG_FILE_ERROR:
+        return "Log file error";
       default:
         return "Unknown error";
     }
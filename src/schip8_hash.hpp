@@ -0,0 +1,36 @@
+#ifndef SUPERCHIP8_HASH_HPP
+#define SUPERCHIP8_HASH_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+namespace SuperChip8 {
+
+// 64 bits FNV-1a constants
+constexpr std::uint64_t FNV_OFFSET_BASIS = 0xcbf29ce484222325;
+constexpr std::uint64_t FNV_PRIME = 0x100000001b3;
+
+/// @brief Feed a byte to a 64 bits FNV-1a hash
+/// @param hash The current hash (FNV_OFFSET_BASIS to start a new one)
+/// @param byte The byte to add
+/// @return the updated hash
+constexpr std::uint64_t fnv1a(std::uint64_t hash, std::uint8_t byte) {
+  return (hash ^ byte) * FNV_PRIME;
+}
+
+/// @brief Feed a buffer to a 64 bits FNV-1a hash
+/// @param hash The current hash (FNV_OFFSET_BASIS to start a new one)
+/// @param data Pointer to the data
+/// @param size Size of the data (in bytes)
+/// @return the updated hash
+constexpr std::uint64_t fnv1a(std::uint64_t hash, const std::uint8_t *data,
+                              std::size_t size) {
+  for (std::size_t i = 0; i < size; i++) {
+    hash = fnv1a(hash, data[i]);
+  }
+  return hash;
+}
+
+}  // namespace SuperChip8
+
+#endif  // SUPERCHIP8_HASH_HPP
@@ -0,0 +1,78 @@
+#ifndef SUPERCHIP8_SPSCRING_HPP
+#define SUPERCHIP8_SPSCRING_HPP
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+
+namespace SuperChip8 {
+
+/// @brief Lock-free single-producer single-consumer ring buffer
+///
+/// @details One thread pushes, another one pops: neither ever blocks nor
+/// allocates, which makes it usable from a real-time thread (ie: the audio
+/// callback). The head and tail indices only grow, and live on separate cache
+/// lines so that the producer and the consumer do not share one.
+/// @tparam T The item type
+/// @tparam CAPACITY The number of items, a power of two
+template <typename T, std::size_t CAPACITY>
+class SpscRing {
+  static_assert((CAPACITY & (CAPACITY - 1)) == 0,
+                "CAPACITY must be a power of two");
+
+ public:
+  /// @brief Push an item (producer thread)
+  /// @param item The item to push
+  /// @return `false` if the ring is full (the item is dropped)
+  bool push(const T &item) {
+    std::size_t head = _head.load(std::memory_order_relaxed);
+    if (head - _tail.load(std::memory_order_acquire) == CAPACITY) {
+      return false;
+    }
+    _items[head & (CAPACITY - 1)] = item;
+    _head.store(head + 1, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Oldest item, left in the ring (consumer thread)
+  /// @return the item, `nullptr` if the ring is empty
+  const T *front() const {
+    std::size_t tail = _tail.load(std::memory_order_relaxed);
+    if (tail == _head.load(std::memory_order_acquire)) {
+      return nullptr;
+    }
+    return &_items[tail & (CAPACITY - 1)];
+  }
+
+  /// @brief Drop the oldest item (consumer thread), the ring must not be
+  /// empty (see front())
+  void pop() {
+    _tail.store(_tail.load(std::memory_order_relaxed) + 1,
+                std::memory_order_release);
+  }
+
+  /// @brief Pop the oldest item (consumer thread)
+  /// @param item Set to the oldest item
+  /// @return `false` if the ring is empty
+  bool pop(T &item) {
+    const T *oldest = front();
+    if (!oldest) {
+      return false;
+    }
+    item = *oldest;
+    pop();
+    return true;
+  }
+
+ private:
+  // producer and consumer indices, on their own cache lines
+  static constexpr std::size_t CACHE_LINE_SIZE = 64;
+
+  std::array<T, CAPACITY> _items;
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _head = 0;
+  alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> _tail = 0;
+};
+
+}  // namespace SuperChip8
+
+#endif  // SUPERCHIP8_SPSCRING_HPP
@@ -1,42 +1,138 @@
+#include <cmath>
 #include <raylib.h>
 
 #include "schip8_error.hpp"
 #include "schip8_system_audio_audiodevice.hpp"
+#include "schip8_system_log_logger.hpp"
 
 namespace SuperChip8::System::Audio {
 
+namespace {
+
+Log::Message<Log::Level::INFO> DEVICE_OPENED{
+    "audio", "opened", {"sample_rate", "buffer_samples"}};
+Log::Message<Log::Level::ERROR> DEVICE_FAILED{"audio", "open_failed"};
+Log::Message<Log::Level::WARNING> EVENT_DROPPED{
+    "audio", "event_dropped", {"time"}};
+// counted by the audio thread, logged by the emulation thread
+Log::Message<Log::Level::DEBUG> CLOCK_RESYNC{
+    "audio", "resync", {"drift_samples", "resyncs"}};
+
+// pattern samples per second at a given pitch (XO-CHIP FX3A)
+double patternRate(std::uint8_t pitch) {
+  return 4000.0 * std::pow(2.0, (pitch - DEFAULT_PITCH) / 48.0);
+}
+
+}  // namespace
+
+std::atomic<AudioDevice *> AudioDevice::s_device = nullptr;
+
 void AudioDevice::open(std::error_code &ec) {
   InitAudioDevice();
   if (!IsAudioDeviceReady()) {
     ec = Error::FAILED_TO_OPEN_AUDIO_DEVICE;
+    Log::write(DEVICE_FAILED);
+    return;
   }
+
+  // one frame per buffer: an event is late by at most one block
+  _phase_step = patternRate(DEFAULT_PITCH) / SAMPLE_RATE;
+  SetAudioStreamBufferSizeDefault(SAMPLES_PER_FRAME);
+  _stream = LoadAudioStream(SAMPLE_RATE, 16, 1);
+  s_device.store(this);
+  SetAudioStreamCallback(_stream, &AudioDevice::streamCallback);
+  PlayAudioStream(_stream);
+  _open.store(true);
+  Log::write(DEVICE_OPENED, SAMPLE_RATE, SAMPLES_PER_FRAME);
 }
-void AudioDevice::close() { CloseAudioDevice(); }
 
-void AudioDevice::registerSound(SoundType type, const std::string &filename,
-                                std::error_code &ec) {
-  Sound sound = LoadSound(filename.c_str());
-  if (sound.frameCount == 0) {
-    ec = Error::FAILED_TO_LOAD_SOUND;
+void AudioDevice::close() {
+  if (!_open.exchange(false)) {
     return;
   }
-  _sounds[type] = sound;
+  StopAudioStream(_stream);
+  UnloadAudioStream(_stream);
+  s_device.store(nullptr);
+  CloseAudioDevice();
+  logResyncs();
 }
 
-void AudioDevice::playSound(SoundType type, std::error_code &ec) {
-  if (!_sounds.contains(type)) {
-    ec = Error::SOUND_NOT_FOUND;
-    return;
+bool AudioDevice::isOpen() const { return _open.load(); }
+
+void AudioDevice::pushEvent(const AudioEvent &event) {
+  if (!_events.push(event)) {
+    Log::write(EVENT_DROPPED, event.time);
   }
-  PlaySound(_sounds[type]);
+  logResyncs();
 }
 
-void AudioDevice::stopSound(SoundType type, std::error_code &ec) {
-  if (!_sounds.contains(type)) {
-    ec = Error::SOUND_NOT_FOUND;
-    return;
+void AudioDevice::logResyncs() {
+  if (std::uint32_t resyncs =
+          _resyncs.exchange(0, std::memory_order_acquire)) {
+    Log::write(CLOCK_RESYNC,
+               _resync_drift.load(std::memory_order_relaxed), resyncs);
+  }
+}
+
+void AudioDevice::streamCallback(void *buffer, unsigned int frames) {
+  AudioDevice *device = s_device.load();
+  if (device) {
+    device->render(static_cast<std::int16_t *>(buffer), frames);
+  }
+}
+
+void AudioDevice::render(std::int16_t *samples, unsigned int count) {
+  for (unsigned int i = 0; i < count; i++) {
+    // applying the events due at this sample
+    while (const AudioEvent *event = _events.front()) {
+      std::int64_t due = static_cast<std::int64_t>(event->time) + _offset;
+      if (!_anchored || due > _clock + MAX_DRIFT || due < _clock - MAX_DRIFT) {
+        if (_anchored) {
+          _resync_drift.store(due - _clock, std::memory_order_relaxed);
+          _resyncs.fetch_add(1, std::memory_order_release);
+        }
+        // one frame of latency, so that the next events are not late
+        _offset = _clock + SAMPLES_PER_FRAME -
+                  static_cast<std::int64_t>(event->time);
+        _anchored = true;
+        due = _clock + SAMPLES_PER_FRAME;
+      }
+      if (due > _clock) {
+        break;
+      }
+      apply(*event);
+      _events.pop();
+    }
+
+    if (_tone) {
+      std::uint32_t bit = static_cast<std::uint32_t>(_phase);
+      bool high = _pattern[bit / 8] & (0x80 >> (bit % 8));
+      samples[i] = high ? AMPLITUDE : -AMPLITUDE;
+      _phase += _phase_step;
+      if (_phase >= AUDIO_PATTERN_SIZE * 8) {
+        _phase -= AUDIO_PATTERN_SIZE * 8;
+      }
+    } else {
+      samples[i] = 0;
+    }
+    _clock++;
+  }
+}
+
+void AudioDevice::apply(const AudioEvent &event) {
+  switch (event.type) {
+    case AudioEvent::Type::TONE_ON:
+      _tone = true;
+      _phase = 0;
+      break;
+    case AudioEvent::Type::TONE_OFF:
+      _tone = false;
+      break;
+    case AudioEvent::Type::PATTERN:
+      _pattern = event.pattern;
+      _phase_step = patternRate(event.pitch) / SAMPLE_RATE;
+      break;
   }
-  StopSound(_sounds[type]);
 }
 
 }  // namespace SuperChip8::System::Audio
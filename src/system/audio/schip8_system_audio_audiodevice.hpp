@@ -1,28 +1,128 @@
 #ifndef SUPERCHIP8_SYSTEM_AUDIO_AUDIODEVICE_HPP
 #define SUPERCHIP8_SYSTEM_AUDIO_AUDIODEVICE_HPP
 
-#include <map>
+#include "schip8_spscring.hpp"
+
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <raylib.h>
 #include <system_error>
 
-#include "schip8_system_audio_soundtype.hpp"
-
 namespace SuperChip8::System::Audio {
 
+// output stream: mono, 16 bits
+constexpr std::uint32_t SAMPLE_RATE = 48000;
+// the timers tick at 60 Hz
+constexpr std::uint32_t SAMPLES_PER_FRAME = SAMPLE_RATE / 60;
+
+// audio pattern buffer (XO-CHIP F002): 128 1-bit samples, looped
+constexpr std::uint8_t AUDIO_PATTERN_SIZE = 16;
+using AudioPattern = std::array<std::uint8_t, AUDIO_PATTERN_SIZE>;
+
+// pattern played by CHIP-8 / SCHIP (and XO-CHIP until F002): a 500 Hz square
+// wave at the default pitch
+constexpr AudioPattern DEFAULT_AUDIO_PATTERN = {
+    0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0,
+    0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0, 0xF0};
+
+// pattern playback pitch (XO-CHIP FX3A), 64 plays 4000 samples per second
+constexpr std::uint8_t DEFAULT_PITCH = 64;
+
+/// @brief Change of the sound, stamped with the emulated time
+struct AudioEvent {
+  enum class Type : std::uint8_t {
+    // the sound timer became non zero
+    TONE_ON,
+    // the sound timer reached zero
+    TONE_OFF,
+    // new pattern and pitch (F002 / FX3A)
+    PATTERN
+  };
+
+  // emulated time, in samples (SAMPLES_PER_FRAME per emulated frame)
+  std::uint64_t time;
+  Type type;
+  std::uint8_t pitch = DEFAULT_PITCH;
+  AudioPattern pattern = DEFAULT_AUDIO_PATTERN;
+};
+
+/// @brief Audio engine, synthesizes the sound in the audio stream callback
+///
+/// @details The emulation pushes AudioEvent's to a lock-free ring buffer
+/// (pushEvent()), only when the sound changes. The audio thread renders the
+/// pattern (a 1-bit sample loop) while the tone is on, and applies each event
+/// at the sample its emulated time maps to: the edges are as far apart in
+/// the output as they are in the emulation.
+///
+/// The emulated time is anchored to the playback clock on the first event,
+/// one frame ahead (the latency of the stream). It is anchored again when it
+/// drifts by more than MAX_DRIFT samples (ie: emulation paused or running
+/// faster than real time).
 class AudioDevice {
  public:
+  /// @brief Open the audio device and start the stream
+  /// @param ec Error::FAILED_TO_OPEN_AUDIO_DEVICE
   void open(std::error_code &ec);
+
+  /// @brief Stop the stream and close the audio device
   void close();
 
-  void registerSound(SoundType type, const std::string &filename,
-                     std::error_code &ec);
-  void playSound(SoundType type, std::error_code &ec);
-  void stopSound(SoundType type, std::error_code &ec);
+  /// @return `true` while the stream is playing (see open())
+  bool isOpen() const;
+
+  /// @brief Queue a sound change (single producer: the emulation thread)
+  ///
+  /// @details The event is dropped if the ring is full (the audio thread is
+  /// stalled).
+  /// @param event The sound change
+  void pushEvent(const AudioEvent &event);
 
  private:
-  std::map<SoundType, Sound> _sounds;
+  // events the ring can hold (many seconds of sound changes)
+  static constexpr std::size_t EVENT_CAPACITY = 256;
+  // emulated time drift (in samples) before the clocks are anchored again
+  static constexpr std::int64_t MAX_DRIFT = 4 * SAMPLES_PER_FRAME;
+  // square wave amplitude
+  static constexpr std::int16_t AMPLITUDE = 4000;
+
+  /// @brief raylib stream callback, renders the samples of the open device
+  static void streamCallback(void *buffer, unsigned int frames);
+
+  /// @brief Render the next samples (audio thread)
+  void render(std::int16_t *samples, unsigned int count);
+
+  /// @brief Apply a sound change (audio thread)
+  void apply(const AudioEvent &event);
+
+  /// @brief Log the clock resyncs of the audio thread (emulation thread)
+  void logResyncs();
+
+  // device rendered by streamCallback(), raylib passes no user data
+  static std::atomic<AudioDevice *> s_device;
+
+  AudioStream _stream;
+  std::atomic<bool> _open = false;
+  SpscRing<AudioEvent, EVENT_CAPACITY> _events;
+  // resyncs since the last logged, and the drift of the last one: the audio
+  // thread never logs (a thread's first record takes a lock and allocates)
+  std::atomic<std::uint32_t> _resyncs = 0;
+  std::atomic<std::int64_t> _resync_drift = 0;
+
+  // AUDIO THREAD STATE
+  // samples rendered since open()
+  std::int64_t _clock = 0;
+  // playback clock - emulated time
+  std::int64_t _offset = 0;
+  bool _anchored = false;
+  bool _tone = false;
+  AudioPattern _pattern = DEFAULT_AUDIO_PATTERN;
+  // position in the pattern (in samples of the pattern) and its increment per
+  // output sample
+  double _phase = 0;
+  double _phase_step = 0;
 };
 
 }  // namespace SuperChip8::System::Audio
 
-#endif  // SUPERCHIP8_SYSTEM_AUDIO_AUDIODEVICE_HPP
\ No newline at end of file
+#endif  // SUPERCHIP8_SYSTEM_AUDIO_AUDIODEVICE_HPP
@@ -1,6 +0,0 @@
-#ifndef SUPERCHIP8_SYSTEM_AUDIO_SOUNDTYPE_HPP
-#define SUPERCHIP8_SYSTEM_AUDIO_SOUNDTYPE_HPP
-
-enum class SoundType { BEEP };
-
-#endif  // SUPERCHIP8_SYSTEM_AUDIO_SOUNDTYPE_HPP
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include "schip8_system_capture_recorder.hpp"
+#include "schip8_error.hpp"
+
+namespace SuperChip8::System::Capture {
+
+Recorder::~Recorder() {
+  std::error_code ec;
+  close(ec);
+}
+
+void Recorder::open(const std::string &path, std::uint8_t scale,
+                    std::error_code &ec) {
+  _writer = VideoWriter::create(path, scale, ec);
+  if (ec) {
+    return;
+  }
+  _thread = std::jthread(&Recorder::encode, this);
+}
+
+void Recorder::push(const Graphics::Frame &frame, bool wait) {
+  {
+    std::unique_lock lock(_mutex);
+    if (wait) {
+      _room_cv.wait(lock, [&]() { return _queue.size() < CAPTURE_QUEUE_SIZE; });
+    } else if (_queue.size() == CAPTURE_QUEUE_SIZE) {
+      _dropped_frames++;
+      return;
+    }
+    _queue.push_back(frame);
+  }
+  _frame_cv.notify_one();
+}
+
+void Recorder::close(std::error_code &ec) {
+  if (!_writer) {
+    return;
+  }
+  _thread.request_stop();
+  if (_thread.joinable()) {
+    _thread.join();
+  }
+  _writer->finish();
+  if (_writer->failed()) {
+    ec = Error::CAPTURE_FILE_ERROR;
+  }
+  _writer.reset();
+}
+
+std::uint64_t Recorder::encodedFrames() const {
+  std::lock_guard lock(_mutex);
+  return _encoded_frames;
+}
+
+std::uint64_t Recorder::droppedFrames() const {
+  std::lock_guard lock(_mutex);
+  return _dropped_frames;
+}
+
+void Recorder::encode(std::stop_token stop_token) {
+  Graphics::Frame frame;
+  while (true) {
+    {
+      std::unique_lock lock(_mutex);
+      // once stopped, returns true until the queue is drained
+      if (!_frame_cv.wait(lock, stop_token,
+                          [&]() { return !_queue.empty(); })) {
+        return;
+      }
+      frame = _queue.front();
+      _queue.pop_front();
+    }
+    _room_cv.notify_one();
+
+    _writer->writeFrame(frame);
+    std::lock_guard lock(_mutex);
+    _encoded_frames++;
+  }
+}
+
+}  // namespace SuperChip8::System::Capture
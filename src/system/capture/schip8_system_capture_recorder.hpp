@@ -0,0 +1,78 @@
+#ifndef SUPERCHIP8_SYSTEM_CAPTURE_RECORDER_HPP
+#define SUPERCHIP8_SYSTEM_CAPTURE_RECORDER_HPP
+
+#include "schip8_system_capture_videowriter.hpp"
+#include "schip8_system_graphics_display.hpp"
+
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+
+namespace SuperChip8::System::Capture {
+
+// frames waiting to be encoded (2 seconds)
+constexpr std::size_t CAPTURE_QUEUE_SIZE = 120;
+
+/// @brief Gameplay recorder, encodes the published frames to a video file
+/// (see schip8_system_capture_videowriter.hpp)
+///
+/// @details push() only copies the frame into a bounded queue: the encoder
+/// thread scales, encodes and writes it. When the queue is full, the frame is
+/// dropped (real time, the display never waits for the encoder) or push()
+/// waits for the encoder (headless, every frame is encoded, as fast as they
+/// are produced).
+class Recorder {
+ public:
+  Recorder() = default;
+
+  /// @brief Close the video, see close()
+  ~Recorder();
+
+  Recorder(const Recorder &) = delete;
+  Recorder &operator=(const Recorder &) = delete;
+
+  /// @brief Create the video file and start the encoder thread
+  /// @param path Path of the video file, its extension gives its format
+  /// @param scale Integer scale of the video
+  /// @param ec Error::INVALID_CAPTURE_FORMAT, Error::CAPTURE_FILE_ERROR
+  void open(const std::string &path, std::uint8_t scale, std::error_code &ec);
+
+  /// @brief Queue a frame (from a single thread, ie: after the vblank)
+  /// @param frame The frame to record
+  /// @param wait Wait for room in the queue instead of dropping the frame
+  void push(const Graphics::Frame &frame, bool wait = false);
+
+  /// @brief Encode the queued frames, then finish the video
+  /// @param ec Error::CAPTURE_FILE_ERROR, if writing the video failed
+  void close(std::error_code &ec);
+
+  /// @return the frames encoded so far
+  std::uint64_t encodedFrames() const;
+
+  /// @return the frames dropped because the queue was full
+  std::uint64_t droppedFrames() const;
+
+ private:
+  /// @brief Encoder loop, until stopped and the queue is empty
+  void encode(std::stop_token stop_token);
+
+  std::unique_ptr<VideoWriter> _writer;
+
+  mutable std::mutex _mutex;
+  std::condition_variable_any _frame_cv;
+  std::condition_variable _room_cv;
+  std::deque<Graphics::Frame> _queue;
+  std::uint64_t _encoded_frames = 0;
+  std::uint64_t _dropped_frames = 0;
+
+  std::jthread _thread;
+};
+
+}  // namespace SuperChip8::System::Capture
+
+#endif  // SUPERCHIP8_SYSTEM_CAPTURE_RECORDER_HPP
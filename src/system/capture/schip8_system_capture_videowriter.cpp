@@ -0,0 +1,243 @@
+#include "schip8_system_capture_videowriter.hpp"
+#include "schip8_error.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <filesystem>
+
+namespace SuperChip8::System::Capture {
+
+namespace {
+
+// GIF frames shorter than 2/100th of a second are slowed down by viewers
+constexpr std::uint32_t GIF_MIN_PENDING_FRAMES = 2;
+// longest GIF delay (65535/100th of a second), in frames
+constexpr std::uint32_t GIF_MAX_PENDING_FRAMES =
+    65535 / 100 * Graphics::TARGET_FPS;
+// 2 colors, but the LZW minimum code size is 2 bits
+constexpr std::uint8_t GIF_MIN_CODE_SIZE = 2;
+constexpr std::uint16_t GIF_CLEAR_CODE = 1 << GIF_MIN_CODE_SIZE;
+constexpr std::uint16_t GIF_END_CODE = GIF_CLEAR_CODE + 1;
+constexpr std::uint16_t GIF_MAX_CODE = 4095;
+constexpr std::size_t GIF_SUB_BLOCK_SIZE = 255;
+
+void writeU16(std::ofstream &file, std::uint16_t value) {
+  file.put(static_cast<char>(value & 0xFF));
+  file.put(static_cast<char>(value >> 8));
+}
+
+/// @brief Pack variable length LZW codes, least significant bit first, into
+/// GIF data sub-blocks
+class CodeWriter {
+ public:
+  explicit CodeWriter(std::ofstream &file) : _file(file) {}
+
+  void write(std::uint16_t code, std::uint8_t size) {
+    _bits |= static_cast<std::uint32_t>(code) << _bit_count;
+    _bit_count += size;
+    while (_bit_count >= 8) {
+      pushByte(_bits & 0xFF);
+      _bits >>= 8;
+      _bit_count -= 8;
+    }
+  }
+
+  /// @brief Write the remaining bits and the block terminator
+  void finish() {
+    if (_bit_count > 0) {
+      pushByte(_bits & 0xFF);
+    }
+    flushBlock();
+    _file.put(0);
+  }
+
+ private:
+  void pushByte(std::uint8_t byte) {
+    _block[_block_size++] = byte;
+    if (_block_size == GIF_SUB_BLOCK_SIZE) {
+      flushBlock();
+    }
+  }
+
+  void flushBlock() {
+    if (_block_size > 0) {
+      _file.put(static_cast<char>(_block_size));
+      _file.write(reinterpret_cast<const char *>(_block.data()), _block_size);
+      _block_size = 0;
+    }
+  }
+
+  std::ofstream &_file;
+  std::uint32_t _bits = 0;
+  std::uint8_t _bit_count = 0;
+  std::array<std::uint8_t, GIF_SUB_BLOCK_SIZE> _block;
+  std::size_t _block_size = 0;
+};
+
+}  // namespace
+
+std::unique_ptr<VideoWriter> VideoWriter::create(const std::string &path,
+                                                 std::uint8_t scale,
+                                                 std::error_code &ec) {
+  std::string extension = std::filesystem::path(path).extension().string();
+  std::transform(extension.begin(), extension.end(), extension.begin(),
+                 [](unsigned char c) { return std::tolower(c); });
+  if ((extension != ".y4m" && extension != ".gif") || scale == 0 ||
+      scale > MAX_CAPTURE_SCALE) {
+    ec = Error::INVALID_CAPTURE_FORMAT;
+    return nullptr;
+  }
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  if (!file.is_open()) {
+    ec = Error::CAPTURE_FILE_ERROR;
+    return nullptr;
+  }
+  if (extension == ".gif") {
+    return std::make_unique<GIFWriter>(std::move(file), scale);
+  }
+  return std::make_unique<Y4MWriter>(std::move(file), scale);
+}
+
+VideoWriter::VideoWriter(std::ofstream file, std::uint8_t scale)
+    : _file(std::move(file)),
+      _width(Graphics::HIGH_RES_VIRTUAL_SCREEN_WIDTH * scale),
+      _height(Graphics::HIGH_RES_VIRTUAL_SCREEN_HEIGHT * scale),
+      _pixels(static_cast<std::size_t>(_width) * _height) {}
+
+bool VideoWriter::failed() const { return _file.fail(); }
+
+void VideoWriter::scaleFrame(const Graphics::Frame &frame) {
+  auto pixel = _pixels.begin();
+  for (std::uint16_t y = 0; y < _height; y++) {
+    const std::uint8_t *row =
+        &frame.pixels[y * frame.height / _height * Graphics::FRAME_ROW_BYTES];
+    for (std::uint16_t x = 0; x < _width; x++) {
+      std::uint16_t frame_x = x * frame.width / _width;
+      *pixel++ = (row[frame_x / 8] >> (7 - frame_x % 8)) & 1;
+    }
+  }
+}
+
+Y4MWriter::Y4MWriter(std::ofstream file, std::uint8_t scale)
+    : VideoWriter(std::move(file), scale) {
+  _file << "YUV4MPEG2 W" << _width << " H" << _height << " F"
+        << +Graphics::TARGET_FPS << ":1 Ip A1:1 Cmono\n";
+}
+
+void Y4MWriter::writeFrame(const Graphics::Frame &frame) {
+  scaleFrame(frame);
+  for (std::uint8_t &pixel : _pixels) {
+    pixel = pixel ? 0xFF : 0x00;
+  }
+  _file << "FRAME\n";
+  _file.write(reinterpret_cast<const char *>(_pixels.data()), _pixels.size());
+}
+
+void Y4MWriter::finish() { _file.close(); }
+
+GIFWriter::GIFWriter(std::ofstream file, std::uint8_t scale)
+    : VideoWriter(std::move(file), scale), _codes(GIF_MAX_CODE + 1) {
+  // header and logical screen, with a global color table of 2 colors
+  _file << "GIF89a";
+  writeU16(_file, _width);
+  writeU16(_file, _height);
+  _file.put(static_cast<char>(0x80));
+  _file.put(0);
+  _file.put(0);
+  const std::uint8_t palette[] = {0x00, 0x00, 0x00, 0xFF, 0xFF, 0xFF};
+  _file.write(reinterpret_cast<const char *>(palette), sizeof(palette));
+  // loop forever
+  _file << "\x21\xFF\x0BNETSCAPE2.0\x03\x01";
+  writeU16(_file, 0);
+  _file.put(0);
+}
+
+void GIFWriter::writeFrame(const Graphics::Frame &frame) {
+  scaleFrame(frame);
+  if (_pending_frames == 0) {
+    _pending = _pixels;
+    _pending_frames = 1;
+  } else if (_pixels == _pending) {
+    if (++_pending_frames == GIF_MAX_PENDING_FRAMES) {
+      writePending();
+    }
+  } else if (_pending_frames < GIF_MIN_PENDING_FRAMES) {
+    // too short to be shown, replaced by the new picture
+    _pending.swap(_pixels);
+    _pending_frames++;
+  } else {
+    writePending();
+    _pending.swap(_pixels);
+    _pending_frames = 1;
+  }
+}
+
+void GIFWriter::finish() {
+  if (_pending_frames > 0) {
+    writePending();
+  }
+  _file.put(0x3B);
+  _file.close();
+}
+
+void GIFWriter::writePending() {
+  // the delay is the rounded end time minus the time already written, so the
+  // rounding errors do not add up
+  _written_frames += _pending_frames;
+  std::uint64_t end_centiseconds =
+      (_written_frames * 100 + Graphics::TARGET_FPS / 2) / Graphics::TARGET_FPS;
+  std::uint16_t delay = end_centiseconds - _written_centiseconds;
+  _written_centiseconds = end_centiseconds;
+  _pending_frames = 0;
+
+  // graphic control extension
+  _file << "\x21\xF9\x04";
+  _file.put(0);
+  writeU16(_file, delay);
+  _file.put(0);
+  _file.put(0);
+  // image descriptor, the whole screen
+  _file.put(0x2C);
+  writeU16(_file, 0);
+  writeU16(_file, 0);
+  writeU16(_file, _width);
+  writeU16(_file, _height);
+  _file.put(0);
+  writeImageData();
+}
+
+void GIFWriter::writeImageData() {
+  _file.put(GIF_MIN_CODE_SIZE);
+  CodeWriter writer(_file);
+  std::fill(_codes.begin(), _codes.end(), std::array<std::uint16_t, 4>{});
+  std::uint8_t code_size = GIF_MIN_CODE_SIZE + 1;
+  std::uint16_t last_code = GIF_END_CODE;
+  writer.write(GIF_CLEAR_CODE, code_size);
+
+  // longest known string of pixels so far, as a code
+  std::uint16_t code = _pending[0];
+  for (auto pixel = _pending.begin() + 1; pixel != _pending.end(); ++pixel) {
+    if (_codes[code][*pixel]) {
+      code = _codes[code][*pixel];
+      continue;
+    }
+    writer.write(code, code_size);
+    _codes[code][*pixel] = ++last_code;
+    if (last_code >= (1u << code_size)) {
+      code_size++;
+    }
+    if (last_code == GIF_MAX_CODE) {
+      writer.write(GIF_CLEAR_CODE, code_size);
+      std::fill(_codes.begin(), _codes.end(), std::array<std::uint16_t, 4>{});
+      code_size = GIF_MIN_CODE_SIZE + 1;
+      last_code = GIF_END_CODE;
+    }
+    code = *pixel;
+  }
+  writer.write(code, code_size);
+  writer.write(GIF_END_CODE, code_size);
+  writer.finish();
+}
+
+}  // namespace SuperChip8::System::Capture
@@ -0,0 +1,107 @@
+#ifndef SUPERCHIP8_SYSTEM_CAPTURE_VIDEOWRITER_HPP
+#define SUPERCHIP8_SYSTEM_CAPTURE_VIDEOWRITER_HPP
+
+#include "schip8_system_graphics_display.hpp"
+
+#include <array>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <vector>
+
+namespace SuperChip8::System::Capture {
+
+/** Video formats
+ *
+ * - `.y4m`: YUV4MPEG2, 8 bits grayscale (Cmono) at 60 frames per second, one
+ *   uncompressed picture per frame (ie: `ffmpeg -i capture.y4m capture.mp4`)
+ * - `.gif`: animated GIF, looping. GIF delays are in 1/100th of a second, and
+ *   viewers slow down the delays under 2/100th: a picture lasting a single
+ *   frame is merged into the next one, the identical frames are merged, and
+ *   the delays are rounded so that the total duration stays exact.
+ *
+ * The video is 128x64 pixels (high resolution) times the scale: the
+ * resolution of a ROM can change at run time, the low resolution frames are
+ * pixel doubled (no pixel is lost).
+ */
+
+constexpr std::uint8_t MAX_CAPTURE_SCALE = 16;
+
+/// @brief Video file encoder, converts and scales the frames
+class VideoWriter {
+ public:
+  /// @brief Open a video writer, its format given by the file extension
+  /// @param path Path of the video file
+  /// @param scale Integer scale of the video (1: 128x64), up to
+  /// MAX_CAPTURE_SCALE
+  /// @param ec Error::INVALID_CAPTURE_FORMAT, Error::CAPTURE_FILE_ERROR
+  /// @return the writer, `nullptr` on error
+  static std::unique_ptr<VideoWriter> create(const std::string &path,
+                                             std::uint8_t scale,
+                                             std::error_code &ec);
+
+  virtual ~VideoWriter() = default;
+
+  /// @brief Encode a frame (1/60th of a second)
+  /// @param frame The frame
+  virtual void writeFrame(const Graphics::Frame &frame) = 0;
+
+  /// @brief Flush the last frames and close the file
+  virtual void finish() = 0;
+
+  /// @return `true` if writing to the file failed
+  bool failed() const;
+
+ protected:
+  VideoWriter(std::ofstream file, std::uint8_t scale);
+
+  /// @brief Scale a frame to the video size, one byte per pixel (0 or 1)
+  void scaleFrame(const Graphics::Frame &frame);
+
+  std::ofstream _file;
+  std::uint16_t _width;
+  std::uint16_t _height;
+  // last frame scaled by scaleFrame()
+  std::vector<std::uint8_t> _pixels;
+};
+
+/// @brief YUV4MPEG2 grayscale writer
+class Y4MWriter : public VideoWriter {
+ public:
+  Y4MWriter(std::ofstream file, std::uint8_t scale);
+
+  void writeFrame(const Graphics::Frame &frame) override;
+  void finish() override;
+};
+
+/// @brief Animated GIF writer
+class GIFWriter : public VideoWriter {
+ public:
+  GIFWriter(std::ofstream file, std::uint8_t scale);
+
+  void writeFrame(const Graphics::Frame &frame) override;
+  void finish() override;
+
+ private:
+  /// @brief Write the pending picture, lasting _pending_frames frames
+  void writePending();
+
+  /// @brief LZW compress the pending picture into image data sub-blocks
+  void writeImageData();
+
+  // picture waiting for its delay (known once it changes)
+  std::vector<std::uint8_t> _pending;
+  std::uint32_t _pending_frames = 0;
+  // frames and centiseconds written, to keep the delays from drifting
+  std::uint64_t _written_frames = 0;
+  std::uint64_t _written_centiseconds = 0;
+
+  // LZW code tree: the code of a code followed by a pixel (0: none)
+  std::vector<std::array<std::uint16_t, 4>> _codes;
+};
+
+}  // namespace SuperChip8::System::Capture
+
+#endif  // SUPERCHIP8_SYSTEM_CAPTURE_VIDEOWRITER_HPP
@@ -1,39 +1,228 @@
 #include "schip8_system_graphics_display.hpp"
 #include "schip8_error.hpp"
+#include "schip8_hash.hpp"
+#include "schip8_system_log_logger.hpp"
+#include "schip8_system_terminal_console.hpp"
 
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
 #include <iostream>
 #include <raylib.h>
+#include <thread>
 
 namespace SuperChip8::System::Graphics {
 
-Display::Display(interrupt_handler_t interrupt_handler)
+namespace {
+
+// colors indexed by the plane bits of a pixel
+constexpr Color PALETTE[] = {BLACK, WHITE, ORANGE, MAROON};
+
+constexpr std::uint32_t rgba(Color color) {
+  return color.r | color.g << 8 | color.b << 16 |
+         static_cast<std::uint32_t>(color.a) << 24;
+}
+
+// PALETTE as texture pixels
+constexpr Upscaler::Palette TEXTURE_PALETTE = {
+    rgba(PALETTE[0]), rgba(PALETTE[1]), rgba(PALETTE[2]), rgba(PALETTE[3])};
+
+Log::Message<Log::Level::INFO> WINDOW_CREATED{
+    "display", "window_created", {"width", "height"}};
+Log::Message<Log::Level::ERROR> WINDOW_FAILED{"display", "window_failed"};
+Log::Message<Log::Level::ERROR> CONSOLE_FAILED{
+    "display", "console_failed", {"error"}};
+Log::Message<Log::Level::DEBUG> TEXTURE_CREATED{
+    "display", "texture_created", {"width", "height"}};
+Log::Message<Log::Level::INFO> VSYNC{
+    "display", "vsync", {"refresh_hz", "paced"}};
+Log::Message<Log::Level::WARNING> FRAME_LATE{
+    "display", "frame_late", {"late_ms"}};
+
+/// @brief The screen texture of an id (the header holds no raylib type)
+Texture2D screenTexture(unsigned int id, int width, int height) {
+  return {id, width, height, 1, PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+}
+
+}  // namespace
+
+std::uint64_t hashFrame(const Frame &frame) {
+  std::uint64_t hash = FNV_OFFSET_BASIS;
+  hash = fnv1a(hash, frame.width);
+  hash = fnv1a(hash, frame.height);
+  return fnv1a(hash, frame.pixels.data(), frame.height * FRAME_ROW_BYTES);
+}
+
+template <std::uint8_t PLANES>
+BasicDisplay<PLANES>::BasicDisplay(interrupt_handler_t interrupt_handler)
     : _interrupt_handler(interrupt_handler) {
-  _virtual_front_screen.fill(
-      std::array<bool, HIGH_RES_VIRTUAL_SCREEN_WIDTH>{false});
-  _virtual_back_screen.fill(
-      std::array<bool, HIGH_RES_VIRTUAL_SCREEN_WIDTH>{false});
+  for (auto &plane : _virtual_front_screen) {
+    plane.fill(Row{false});
+  }
+}
+
+template <std::uint8_t PLANES>
+BasicDisplay<PLANES>::BasicDisplay(const BasicDisplay &other,
+                                   interrupt_handler_t interrupt_handler)
+    : _current_back_resolution(other._current_back_resolution),
+      _virtual_back_screen(other._virtual_back_screen),
+      _virtual_back_screen_height(other._virtual_back_screen_height),
+      _virtual_back_screen_width(other._virtual_back_screen_width),
+      _selected_planes(other._selected_planes),
+      _current_front_resolution(other._current_front_resolution),
+      _next_front_resolution(other._next_front_resolution),
+      _virtual_front_screen(other._virtual_front_screen),
+      _virtual_front_screen_height(other._virtual_front_screen_height),
+      _virtual_front_screen_width(other._virtual_front_screen_width),
+      _interrupt_handler(interrupt_handler) {}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::setInputHandler(input_handler_t input_handler) {
+  _input_handler = input_handler;
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::setSingleThreaded(bool single_threaded) {
+  _virtual_back_screen_mutex.enabled = !single_threaded;
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::setFilter(Filter filter) {
+  _upscaler = Upscaler(filter);
 }
 
-void Display::createWindow(const std::string &title, std::error_code &ec) {
-  SetConfigFlags(FLAG_WINDOW_RESIZABLE);
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::setVSync(bool vsync) {
+  _vsync = vsync;
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::setFrameSkip(std::uint8_t max_skip) {
+  _pacer.setMaxSkip(max_skip);
+}
+
+template <std::uint8_t PLANES>
+const FramePacer &BasicDisplay<PLANES>::framePacer() const {
+  return _pacer;
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::setConsole(Terminal::Console *console) {
+  _console = console;
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::createWindow(const std::string &title,
+                                        std::error_code &ec) {
+  if (_console) {
+    _console->open(ec);
+    if (ec) {
+      Log::write(CONSOLE_FAILED, ec);
+    }
+    return;
+  }
+  unsigned int flags = FLAG_WINDOW_RESIZABLE;
+  if (_vsync) {
+    flags |= FLAG_VSYNC_HINT;
+  }
+  SetConfigFlags(flags);
   InitWindow(LOW_RES_VIRTUAL_SCREEN_WIDTH * _pixel_size,
              LOW_RES_VIRTUAL_SCREEN_HEIGHT * _pixel_size, title.c_str());
   if (!IsWindowReady()) {
     ec = Error::WINDOW_CREATION_ERROR;
+    Log::write(WINDOW_FAILED);
+    return;
+  }
+  Log::write(WINDOW_CREATED, GetScreenWidth(), GetScreenHeight());
+
+  if (_vsync) {
+    // at another refresh rate (ie: 144 Hz), the deadlines keep pacing the
+    // frames and the vsync only removes the tearing
+    int refresh_rate = GetMonitorRefreshRate(GetCurrentMonitor());
+    bool paced = std::abs(refresh_rate - TARGET_FPS) <= 1;
+    _pacer.setVSync(paced);
+    Log::write(VSYNC, refresh_rate, paced);
+  }
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::closeWindow() {
+  if (_console) {
+    _console->close();
+    return;
   }
+  if (!IsWindowReady()) {
+    // the window failed to open, or is already closed
+    return;
+  }
+  if (_texture_id) {
+    UnloadTexture(screenTexture(_texture_id, _texture_width, _texture_height));
+    _texture_id = 0;
+  }
+  CloseWindow();
+}
+
+template <std::uint8_t PLANES>
+bool BasicDisplay<PLANES>::windowShouldClose() {
+  if (_console) {
+    return _console->closeRequested();
+  }
+  return WindowShouldClose();
 }
 
-void Display::closeWindow() { CloseWindow(); }
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::clear() {
+  std::lock_guard lock(_virtual_back_screen_mutex);
+  for (int plane = 0; plane < PLANES; plane++) {
+    if (!(_selected_planes & (1 << plane))) {
+      continue;
+    }
+    _virtual_back_screen[plane].clear();
+  }
+}
 
-bool Display::windowShouldClose() { return WindowShouldClose(); }
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::selectPlanes(std::uint8_t planes) {
+  std::lock_guard lock(_virtual_back_screen_mutex);
+  _selected_planes = planes & ((1 << PLANES) - 1);
+}
 
-void Display::clear() {
+template <std::uint8_t PLANES>
+std::uint8_t BasicDisplay<PLANES>::selectedPlanes() const {
   std::lock_guard lock(_virtual_back_screen_mutex);
-  _virtual_back_screen.fill(
-      std::array<bool, HIGH_RES_VIRTUAL_SCREEN_WIDTH>{false});
+  return _selected_planes;
 }
 
-void Display::computeNewPixelSize() {
+template <std::uint8_t PLANES>
+std::uint8_t BasicDisplay<PLANES>::backPixel(int x, int y) const {
+  std::uint8_t color = 0;
+  for (int plane = 0; plane < PLANES; plane++) {
+    color |= _virtual_back_screen[plane].read(y)[x] << plane;
+  }
+  return color;
+}
+
+template <std::uint8_t PLANES>
+double BasicDisplay<PLANES>::currentTime() const {
+  if (_console) {
+    return std::chrono::duration<double>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+  }
+  return GetTime();
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::wait(double seconds) const {
+  if (_console) {
+    std::this_thread::sleep_for(std::chrono::duration<double>(seconds));
+    return;
+  }
+  WaitTime(seconds);
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::computeNewPixelSize() {
   // calculating max width for pixels
   std::uint32_t max_width = GetScreenWidth() / _virtual_front_screen_width;
 
@@ -50,7 +239,8 @@ void Display::computeNewPixelSize() {
       (GetScreenHeight() - (_virtual_front_screen_height * _pixel_size)) / 2;
 }
 
-void Display::setResolution(Resolution resolution) {
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::setResolution(Resolution resolution) {
   std::lock_guard lock(_virtual_back_screen_mutex);
   switch (resolution) {
     case Resolution::LOW_RES:
@@ -66,29 +256,100 @@ void Display::setResolution(Resolution resolution) {
   }
 }
 
-void Display::drawFrame() {
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::drawFrame() {
+  if (_pacer.shouldSkip(currentTime())) {
+    // behind: the frame is emulated without being drawn, the events are
+    // still polled (EndDrawing() polls them otherwise)
+    _pacer.frameSkipped();
+    if (_console) {
+      _console->pollInput();
+    } else {
+      PollInputEvents();
+    }
+  } else {
+    if (_console) {
+      Frame frame;
+      packFrontBuffer(frame);
+      _console->render(frame);
+    } else {
+      drawWindowFrame();
+    }
+    if (double late = _pacer.framePresented(currentTime()); late > 0) {
+      // missed (more than the frames that may be skipped): the emulation
+      // slows down
+      Log::write(FRAME_LATE, late * 1000);
+    }
+  }
+
+  // running VBlank interrupt function
+  // updating timers and input polling
+  _interrupt_handler();
+  // and swapping buffers
+  swapBuffers();
+
+  // sleeping until the deadline of the next frame, polling the input
+  // meanwhile, then spinning (a sleep may overshoot by a scheduler tick)
+  double deadline = _pacer.deadline();
+  double sleep_end = deadline - PACING_SPIN_TIME;
+  for (double current_time = currentTime(); current_time < sleep_end;
+       current_time = currentTime()) {
+    wait(std::min(sleep_end - current_time, INPUT_POLL_INTERVAL));
+    if (_input_handler) {
+      if (_console) {
+        _console->pollInput();
+      } else {
+        PollInputEvents();
+      }
+      _input_handler();
+    }
+  }
+  while (currentTime() < deadline) {
+    std::this_thread::yield();
+  }
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::drawWindowFrame() {
   if (IsWindowResized() ||
       _current_front_resolution != _next_front_resolution) {
     computeNewPixelSize();
     _current_front_resolution = _next_front_resolution;
   }
 
+  // palette indices of the front buffer, filtered into the texture
+  _front_indices.resize(_virtual_front_screen_width *
+                        _virtual_front_screen_height);
+  auto index = _front_indices.begin();
+  for (int y = 0; y < _virtual_front_screen_height; y++) {
+    for (int x = 0; x < _virtual_front_screen_width; x++) {
+      std::uint8_t color = 0;
+      for (int plane = 0; plane < PLANES; plane++) {
+        color |= _virtual_front_screen[plane][y][x] << plane;
+      }
+      *index++ = color;
+    }
+  }
+  _upscaler.apply(_front_indices.data(), _virtual_front_screen_width,
+                  _virtual_front_screen_height, TEXTURE_PALETTE);
+  uploadTexture();
+
+  Texture2D texture =
+      screenTexture(_texture_id, _texture_width, _texture_height);
+  float width = static_cast<float>(_virtual_front_screen_width * _pixel_size);
+  float height = static_cast<float>(_virtual_front_screen_height * _pixel_size);
+
   // clang-format off
   BeginDrawing();
     ClearBackground(BLACK);
 
-    // draw pixels
-    // pixel y is the line, from top to bottom
-    for (int y = 0; y < _virtual_front_screen_height; y++) {
-        // pixel x is the column, from left to right
-        for (int x = 0; x < _virtual_front_screen_width; x++) {
-            if (_virtual_front_screen[y][x]) {
-              DrawRectangle(x * _pixel_size + _horizontal_offset,
-                            y * _pixel_size + _vertical_offset,
-                            _pixel_size, _pixel_size, WHITE);
-            }
-        }
-    }
+    // the texture is stretched with nearest sampling (raylib's default)
+    DrawTexturePro(texture,
+                   {0, 0, static_cast<float>(_texture_width),
+                    static_cast<float>(_texture_height)},
+                   {static_cast<float>(_horizontal_offset),
+                    static_cast<float>(_vertical_offset), width, height},
+                   {0, 0}, 0, WHITE);
 
     // draw screen bounds
     DrawRectangleLines(_horizontal_offset, _vertical_offset,
@@ -96,29 +357,111 @@ void Display::drawFrame() {
                        _virtual_front_screen_height * _pixel_size, GRAY);
   EndDrawing();
   // clang-format on
+}
 
-  // running VBlank interrupt function
-  // updating timers and input polling
-  _interrupt_handler();
-  // and swapping buffers
-  {
-    std::lock_guard lock(_virtual_back_screen_mutex);
-    _virtual_front_screen = _virtual_back_screen;
-    _virtual_front_screen_height = _virtual_back_screen_height;
-    _virtual_front_screen_width = _virtual_back_screen_width;
-    _next_front_resolution = _current_back_resolution;
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::uploadTexture() {
+  if (_texture_id && _texture_width == _upscaler.width() &&
+      _texture_height == _upscaler.height()) {
+    UpdateTexture(screenTexture(_texture_id, _texture_width, _texture_height),
+                  _upscaler.pixels());
+    return;
   }
 
-  // limiting the frame rate to the target FPS
-  double current_time = GetTime();
-  double wait_time = _target_frame_time - (current_time - _previous_time);
-  if (wait_time > 0) {
-    WaitTime((float)wait_time);
+  if (_texture_id) {
+    UnloadTexture(screenTexture(_texture_id, _texture_width, _texture_height));
   }
-  _previous_time = GetTime();
+  Image image{const_cast<std::uint32_t *>(_upscaler.pixels()),
+              _upscaler.width(), _upscaler.height(), 1,
+              PIXELFORMAT_UNCOMPRESSED_R8G8B8A8};
+  Texture2D texture = LoadTextureFromImage(image);
+  _texture_id = texture.id;
+  _texture_width = texture.width;
+  _texture_height = texture.height;
+  Log::write(TEXTURE_CREATED, _texture_width, _texture_height);
 }
 
-bool Display::addSprite(const Sprite &sprite, std::uint8_t x, std::uint8_t y) {
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::swapBuffers() {
+  std::lock_guard lock(_virtual_back_screen_mutex);
+  for (int plane = 0; plane < PLANES; plane++) {
+    for (int y = 0; y < HIGH_RES_VIRTUAL_SCREEN_HEIGHT; y++) {
+      _virtual_front_screen[plane][y] = _virtual_back_screen[plane].read(y);
+    }
+  }
+  _virtual_front_screen_height = _virtual_back_screen_height;
+  _virtual_front_screen_width = _virtual_back_screen_width;
+  _next_front_resolution = _current_back_resolution;
+}
+
+template <std::uint8_t PLANES>
+typename BasicDisplay<PLANES>::BackBuffer
+BasicDisplay<PLANES>::saveBackBuffer() const {
+  std::lock_guard lock(_virtual_back_screen_mutex);
+  return {_current_back_resolution, _virtual_back_screen,
+          _virtual_back_screen_height, _virtual_back_screen_width,
+          _selected_planes};
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::restoreBackBuffer(const BackBuffer &back_buffer) {
+  std::lock_guard lock(_virtual_back_screen_mutex);
+  _current_back_resolution = back_buffer.resolution;
+  _virtual_back_screen = back_buffer.screen;
+  _virtual_back_screen_height = back_buffer.height;
+  _virtual_back_screen_width = back_buffer.width;
+  _selected_planes = back_buffer.selected_planes;
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::packFrontBuffer(Frame &frame) const {
+  frame.width = _virtual_front_screen_width;
+  frame.height = _virtual_front_screen_height;
+  frame.pixels.fill(0);
+  for (int y = 0; y < _virtual_front_screen_height; y++) {
+    std::uint8_t *row = &frame.pixels[y * FRAME_ROW_BYTES];
+    for (int x = 0; x < _virtual_front_screen_width; x++) {
+      bool set = false;
+      for (int plane = 0; plane < PLANES; plane++) {
+        set = set || _virtual_front_screen[plane][y][x];
+      }
+      row[x / 8] |= set << (7 - x % 8);
+    }
+  }
+}
+
+template <std::uint8_t PLANES>
+std::uint64_t BasicDisplay<PLANES>::hashBackBuffer() const {
+  std::lock_guard lock(_virtual_back_screen_mutex);
+  std::uint64_t hash = FNV_OFFSET_BASIS;
+  hash = fnv1a(hash, _virtual_back_screen_width);
+  hash = fnv1a(hash, _virtual_back_screen_height);
+  for (int y = 0; y < _virtual_back_screen_height; y++) {
+    for (int x = 0; x < _virtual_back_screen_width; x++) {
+      hash = fnv1a(hash, backPixel(x, y));
+    }
+  }
+  return hash;
+}
+
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::writeBackBufferPBM(std::ostream &out) const {
+  std::lock_guard lock(_virtual_back_screen_mutex);
+  out << "P1\n"
+      << static_cast<int>(_virtual_back_screen_width) << " "
+      << static_cast<int>(_virtual_back_screen_height) << "\n";
+  for (int y = 0; y < _virtual_back_screen_height; y++) {
+    for (int x = 0; x < _virtual_back_screen_width; x++) {
+      out << (backPixel(x, y) ? '1' : '0');
+    }
+    out << "\n";
+  }
+}
+
+template <std::uint8_t PLANES>
+template <bool CLIP>
+bool BasicDisplay<PLANES>::addSprite(const Sprite &sprite, std::uint8_t x,
+                                     std::uint8_t y, std::uint8_t plane) {
   std::lock_guard lock(_virtual_back_screen_mutex);
   // sprite data
   const std::uint8_t *data = sprite.getData();
@@ -128,81 +471,159 @@ bool Display::addSprite(const Sprite &sprite, std::uint8_t x, std::uint8_t y) {
   // collision flag
   bool collision = false;
 
+  // visible part of the sprite
+  int rows = sprite_height;
+  int columns = sprite_width;
+  if constexpr (CLIP) {
+    // the position wraps around the screen, the sprite is clipped
+    rows = std::min(rows, _virtual_back_screen_height -
+                              y % _virtual_back_screen_height);
+    columns = std::min(columns, _virtual_back_screen_width -
+                                    x % _virtual_back_screen_width);
+  }
+
   // drawing sprite
   std::uint8_t data_row = 0;
-  for (int row = 0; row < sprite_height; row++) {
+  for (int row = 0; row < rows; row++) {
     std::uint8_t sprite_byte = data[data_row];
     std::uint16_t sprite_word;
     if (sprite_width == 16) {
       sprite_word = (sprite_byte << 8) | data[data_row + 1];
       data_row++;
     }
-    for (int column = 0; column < sprite_width; column++) {
+    data_row++;
+
+    // an empty sprite line leaves the screen line untouched (and unshared)
+    if ((sprite_width == 8 ? sprite_byte : sprite_word) == 0) {
+      continue;
+    }
+
+    // wrapping around the screen
+    int wrap_y = (y + row) % _virtual_back_screen_height;
+    Row &screen_row = _virtual_back_screen[plane].write(wrap_y);
+
+    for (int column = 0; column < columns; column++) {
       // getting the bit to draw
       bool bit = sprite_width == 8 ? (sprite_byte & (0x80 >> column))
                                    : (sprite_word & (0x8000 >> column));
 
       // wrapping around the screen
       int wrap_x = (x + column) % _virtual_back_screen_width;
-      int wrap_y = (y + row) % _virtual_back_screen_height;
 
       // checking for collision
-      collision = collision || (_virtual_back_screen[wrap_y][wrap_x] && bit);
+      collision = collision || (screen_row[wrap_x] && bit);
 
       // the sprite's line is XoRed with the screen's pixels
-      _virtual_back_screen[wrap_y][wrap_x] ^= bit;
+      screen_row[wrap_x] ^= bit;
     }
-    data_row++;
   }
 
   return collision;
 }
 
-void Display::scrollDown(std::uint8_t n) {
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::scrollDown(std::uint8_t n) {
   std::lock_guard lock(_virtual_back_screen_mutex);
 
-  // shifting lines
-  for (int i = _virtual_back_screen_height - 1; i >= n; i--) {
-    _virtual_back_screen[i] = _virtual_back_screen[i - n];
-  }
+  for (int plane = 0; plane < PLANES; plane++) {
+    if (!(_selected_planes & (1 << plane))) {
+      continue;
+    }
+    Plane &screen = _virtual_back_screen[plane];
+
+    // shifting lines (sharing them, no copy)
+    for (int i = _virtual_back_screen_height - 1; i >= n; i--) {
+      screen.share(i, i - n);
+    }
 
-  // clearing lines that were scrolled
-  for (int i = 0; i < n; i++) {
-    _virtual_back_screen[i].fill(false);
+    // clearing lines that were scrolled
+    for (int i = 0; i < n && i < _virtual_back_screen_height; i++) {
+      screen.overwrite(i).fill(false);
+    }
   }
 }
 
-void Display::scrollRight(std::uint8_t n) {
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::scrollUp(std::uint8_t n) {
   std::lock_guard lock(_virtual_back_screen_mutex);
 
-  for (int i = 0; i < _virtual_back_screen_height; i++) {
-    // shifting pixels to the right
-    for (int j = _virtual_back_screen_width - 1; j >= n; j--) {
-      _virtual_back_screen[i][j] = _virtual_back_screen[i][j - n];
+  for (int plane = 0; plane < PLANES; plane++) {
+    if (!(_selected_planes & (1 << plane))) {
+      continue;
+    }
+    Plane &screen = _virtual_back_screen[plane];
+
+    // shifting lines (sharing them, no copy)
+    for (int i = 0; i + n < _virtual_back_screen_height; i++) {
+      screen.share(i, i + n);
     }
 
-    // clearing pixels that were shifted
-    for (int j = 0; j < n; j++) {
-      _virtual_back_screen[i][j] = false;
+    // clearing lines that were scrolled
+    for (int i = std::max(0, _virtual_back_screen_height - n);
+         i < _virtual_back_screen_height; i++) {
+      screen.overwrite(i).fill(false);
     }
   }
 }
 
-void Display::scrollLeft(std::uint8_t n) {
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::scrollRight(std::uint8_t n) {
   std::lock_guard lock(_virtual_back_screen_mutex);
 
-  for (int i = 0; i < _virtual_back_screen_height; i++) {
-    // shifting pixels to the left
-    for (int j = 0; j < _virtual_back_screen_width - n; j++) {
-      _virtual_back_screen[i][j] = _virtual_back_screen[i][j + n];
+  for (int plane = 0; plane < PLANES; plane++) {
+    if (!(_selected_planes & (1 << plane))) {
+      continue;
     }
+    for (int i = 0; i < _virtual_back_screen_height; i++) {
+      Row &row = _virtual_back_screen[plane].write(i);
+
+      // shifting pixels to the right
+      for (int j = _virtual_back_screen_width - 1; j >= n; j--) {
+        row[j] = row[j - n];
+      }
+
+      // clearing pixels that were shifted
+      for (int j = 0; j < n; j++) {
+        row[j] = false;
+      }
+    }
+  }
+}
 
-    // clearing pixels that were shifted
-    for (int j = _virtual_back_screen_width - n; j < _virtual_back_screen_width;
-         j++) {
-      _virtual_back_screen[i][j] = false;
+template <std::uint8_t PLANES>
+void BasicDisplay<PLANES>::scrollLeft(std::uint8_t n) {
+  std::lock_guard lock(_virtual_back_screen_mutex);
+
+  for (int plane = 0; plane < PLANES; plane++) {
+    if (!(_selected_planes & (1 << plane))) {
+      continue;
+    }
+    for (int i = 0; i < _virtual_back_screen_height; i++) {
+      Row &row = _virtual_back_screen[plane].write(i);
+
+      // shifting pixels to the left
+      for (int j = 0; j < _virtual_back_screen_width - n; j++) {
+        row[j] = row[j + n];
+      }
+
+      // clearing pixels that were shifted
+      for (int j = _virtual_back_screen_width - n;
+           j < _virtual_back_screen_width; j++) {
+        row[j] = false;
+      }
     }
   }
 }
 
+template class BasicDisplay<1>;
+template class BasicDisplay<2>;
+template bool BasicDisplay<1>::addSprite<false>(const Sprite &, std::uint8_t,
+                                                std::uint8_t, std::uint8_t);
+template bool BasicDisplay<1>::addSprite<true>(const Sprite &, std::uint8_t,
+                                               std::uint8_t, std::uint8_t);
+template bool BasicDisplay<2>::addSprite<false>(const Sprite &, std::uint8_t,
+                                                std::uint8_t, std::uint8_t);
+template bool BasicDisplay<2>::addSprite<true>(const Sprite &, std::uint8_t,
+                                               std::uint8_t, std::uint8_t);
+
 }  // namespace SuperChip8::System::Graphics
@@ -1,13 +1,21 @@
 #ifndef SUPERCHIP8_SYSTEM_GRAPHICS_DISPLAY_HPP
 #define SUPERCHIP8_SYSTEM_GRAPHICS_DISPLAY_HPP
 
+#include "schip8_cowpages.hpp"
+#include "schip8_system_graphics_filter.hpp"
+#include "schip8_system_graphics_framepacer.hpp"
 #include "schip8_system_graphics_sprite.hpp"
 
 #include <array>
-#include <atomic>
 #include <functional>
 #include <mutex>
+#include <ostream>
 #include <system_error>
+#include <vector>
+
+namespace SuperChip8::System::Terminal {
+class Console;
+}  // namespace SuperChip8::System::Terminal
 
 namespace SuperChip8::System::Graphics {
 
@@ -18,6 +26,27 @@ constexpr std::uint8_t HIGH_RES_VIRTUAL_SCREEN_WIDTH = 128;
 constexpr std::uint8_t HIGH_RES_VIRTUAL_SCREEN_HEIGHT = 64;
 
 constexpr std::uint8_t TARGET_FPS = 60;
+// input poll period while waiting for the next frame (in seconds)
+constexpr double INPUT_POLL_INTERVAL = 0.002;
+
+/// @brief A frame packed at 1 bit per pixel
+///
+/// @details Rows are FRAME_ROW_BYTES long whatever the resolution, the most
+/// significant bit of a byte being the leftmost pixel. Only the first `width`
+/// pixels of the first `height` rows are meaningful.
+constexpr std::uint8_t FRAME_ROW_BYTES = HIGH_RES_VIRTUAL_SCREEN_WIDTH / 8;
+
+struct Frame {
+  std::uint8_t width = LOW_RES_VIRTUAL_SCREEN_WIDTH;
+  std::uint8_t height = LOW_RES_VIRTUAL_SCREEN_HEIGHT;
+  std::array<std::uint8_t, FRAME_ROW_BYTES * HIGH_RES_VIRTUAL_SCREEN_HEIGHT>
+      pixels = {0};
+};
+
+/// @brief Hash the visible part of a frame (FNV-1a), including its resolution
+/// @param frame The frame to hash
+/// @return the 64 bits hash
+std::uint64_t hashFrame(const Frame &frame);
 
 /** Screen coordinates
  *
@@ -42,50 +71,143 @@ constexpr std::uint8_t TARGET_FPS = 60;
 /// handling the display window. It also calls the interrupt handler between
 /// frame draws (vblank), as it implements a timer mechanism to limit the frame
 /// rate.
-class Display {
+///
+/// Each buffer has PLANES 1-bit planes: the color of a pixel is the palette
+/// entry indexed by its plane bits. The drawing operations (clear, scroll)
+/// apply to the selected planes (see selectPlanes()). Instantiated for 1
+/// plane (CHIP-8/SCHIP, see Display) and 2 planes (XO-CHIP), in
+/// schip8_system_graphics_display.cpp.
+/// @tparam PLANES The number of planes (1 or 2)
+template <std::uint8_t PLANES>
+class BasicDisplay {
  public:
   using interrupt_handler_t = std::function<void()>;
+  using input_handler_t = std::function<void()>;
   enum class Resolution { LOW_RES, HIGH_RES };
+  using Row = std::array<bool, HIGH_RES_VIRTUAL_SCREEN_WIDTH>;
+  using Plane = CowPages<Row, HIGH_RES_VIRTUAL_SCREEN_HEIGHT>;
+
+  /// @brief Snapshot of the back buffer, its rows are shared copy-on-write
+  /// with the display it was taken from
+  struct BackBuffer {
+    Resolution resolution;
+    std::array<Plane, PLANES> screen;
+    std::uint8_t height;
+    std::uint8_t width;
+    std::uint8_t selected_planes;
+  };
 
   /// @param interrupt_handler The function to call between frame draws (vblank)
-  Display(interrupt_handler_t interrupt_handler);
+  BasicDisplay(interrupt_handler_t interrupt_handler);
+
+  /// @brief Copy the buffers of another display (ie: to fork a VM)
+  ///
+  /// @details The back buffer rows are shared copy-on-write with `other`,
+  /// which must not be drawn to during the copy.
+  /// @param other The display to copy
+  /// @param interrupt_handler The function to call between frame draws (vblank)
+  BasicDisplay(const BasicDisplay &other,
+               interrupt_handler_t interrupt_handler);
+
+  /// @brief Set the function called after each input poll
+  ///
+  /// @details While drawFrame() waits for the next frame, the input events
+  /// are polled every INPUT_POLL_INTERVAL, so that the key changes are known
+  /// within the frame (instead of once per frame).
+  /// @param input_handler The function to call after each poll
+  void setInputHandler(input_handler_t input_handler);
+
+  /// @brief Skip the back buffer lock, when the same thread draws to the
+  /// back buffer and presents the frames (ie: the CPU runs in the vblank
+  /// handler)
+  /// @param single_threaded `true` to skip the lock
+  void setSingleThreaded(bool single_threaded);
+
+  /// @brief Set the upscaling filter of the window, before createWindow()
+  /// @param filter The filter (see schip8_system_graphics_filter.hpp)
+  void setFilter(Filter filter);
+
+  /// @brief Wait for the monitor refresh to swap the frames, before
+  /// createWindow()
+  ///
+  /// @details The frames are then presented without tearing. At a refresh
+  /// rate of TARGET_FPS, the swap paces the frames (see FramePacer), the
+  /// software wait only wakes up before the refresh. Ignored in a terminal.
+  /// @param vsync `true` to enable the vsync
+  void setVSync(bool vsync);
+
+  /// @brief Skip the drawing of the frames while the display is behind its
+  /// deadlines (ie: a slow host or renderer), before the first drawFrame()
+  ///
+  /// @details A skipped frame is neither drawn nor presented, but its vblank
+  /// still runs the interrupt handler and swaps the buffers: the emulation
+  /// keeps 60 frames per second (see FramePacer).
+  /// @param max_skip The most frames skipped in a row (0 to disable)
+  void setFrameSkip(std::uint8_t max_skip);
+
+  /// @return the frame pacer, its deadlines and its interval histogram
+  const FramePacer &framePacer() const;
+
+  /// @brief Draw to a terminal instead of a window, before createWindow()
+  ///
+  /// @details The window functions then open, poll and close the console,
+  /// and the frame rate is kept without raylib.
+  /// @param console The console, owned by the caller
+  void setConsole(Terminal::Console *console);
 
   /// @brief create the display window
   /// @param title The window title
-  /// @param ec Error::WINDOW_CREATION_ERROR
+  /// @param ec Error::WINDOW_CREATION_ERROR, Error::TERMINAL_ERROR
   ///
-  /// - if the window could not be created
+  /// - if the window (or the console) could not be created
   void createWindow(const std::string &title, std::error_code &ec);
 
   /// @brief Check if the window should close
-  /// @return `true` if the window should close
+  /// @return `true` if the window (or the console) should close
   bool windowShouldClose();
 
-  /// @brief Close the display window and clean up resources
+  /// @brief Close the display window (or the console) and clean up resources
   void closeWindow();
 
-  /// @brief Clear the screen
+  /// @brief Clear the selected planes
   void clear();
 
+  /// @brief Select the planes drawn to (XO-CHIP FN01)
+  /// @param planes The plane mask (bit N: plane N)
+  void selectPlanes(std::uint8_t planes);
+
+  /// @return the selected planes mask
+  std::uint8_t selectedPlanes() const;
+
   /// @brief Draw the screen
   ///
-  /// @details This fuction checks if the window was resized, computes the new
-  /// pixel size, clears the screen, draws the pixels, draws the screen bounds,
-  /// and calls the interrupt handler. It then swaps the front and back buffers,
-  /// sleeps for the remaining time to reach the target frame rate, and updates
-  /// the previous time.
+  /// @details Unless the frame is skipped (see setFrameSkip()), this function
+  /// computes the pixel size again if the window was resized, filters the
+  /// front buffer into a texture (see setFilter()), draws it scaled to the
+  /// window with the screen bounds (or renders the front buffer in the
+  /// console, see setConsole()), and accounts for the presented frame (see
+  /// FramePacer). Drawn or skipped, the frame then calls the interrupt
+  /// handler, swaps the front and back buffers, and sleeps until the deadline
+  /// of the next frame (polling the input, see setInputHandler()), spinning
+  /// its last PACING_SPIN_TIME.
   void drawFrame();
 
   /// @brief Add a sprite to the screen at the specified position
   ///
   /// @details This function adds a sprite to the back buffer.
   /// It is important to note that unlike stated by Cowgod's documentation, the
-  /// sprite do in fact wrap around the screen (needed by some games).
+  /// sprite do in fact wrap around the screen (needed by some games), unless
+  /// CLIP is set (clipping quirk, see schip8_emulator_platform.hpp).
+  /// @tparam CLIP `true` to clip the sprite at the screen edges (its position
+  /// still wraps)
   /// @param sprite The sprite to add
   /// @param x The x position of the sprite
   /// @param y The y position of the sprite
+  /// @param plane The plane to draw to
   /// @return `true` if a collision occurred
-  bool addSprite(const Sprite &sprite, std::uint8_t x, std::uint8_t y);
+  template <bool CLIP = false>
+  bool addSprite(const Sprite &sprite, std::uint8_t x, std::uint8_t y,
+                 std::uint8_t plane = 0);
 
   /// @brief Scrolls the screen down by n lines
   ///
@@ -95,6 +217,13 @@ class Display {
   /// @param n the number of pixels to scroll down by
   void scrollDown(std::uint8_t n);
 
+  /// @brief Scrolls the screen up by n lines (XO-CHIP)
+  ///
+  /// @details The lines that are scrolled up are cleared. (ie: no wrapping).
+  /// It operates on the back buffer.
+  /// @param n the number of pixels to scroll up by
+  void scrollUp(std::uint8_t n);
+
   /// @brief Scrolls the screen right by n pixels
   ///
   /// @details This function scrolls the screen right by n pixels. The pixels
@@ -113,41 +242,121 @@ class Display {
 
   void setResolution(Resolution resolution);
 
+  /// @brief Copy the back buffer (and its resolution) to the front buffer
+  ///
+  /// @details Called by drawFrame() after the vblank, and directly by the VM
+  /// when it runs without a window.
+  void swapBuffers();
+
+  /// @brief Snapshot the back buffer (and its resolution)
+  /// @return the snapshot, sharing its rows with the back buffer
+  BackBuffer saveBackBuffer() const;
+
+  /// @brief Restore a back buffer snapshot
+  /// @param back_buffer The snapshot to restore
+  void restoreBackBuffer(const BackBuffer &back_buffer);
+
+  /// @brief Pack the front buffer (the last presented frame)
+  /// @details Must be called from the thread swapping the buffers. A pixel is
+  /// set if it is set in any plane.
+  /// @param frame The frame to fill
+  void packFrontBuffer(Frame &frame) const;
+
+  /// @brief Hash the visible part of the back buffer (FNV-1a, the palette
+  /// index of each pixel), including its resolution
+  /// @return the 64 bits hash
+  std::uint64_t hashBackBuffer() const;
+
+  /// @brief Write the visible part of the back buffer as a plain PBM (P1)
+  /// image, a pixel is black if it is set in any plane
+  /// @param out The stream to write to
+  void writeBackBufferPBM(std::ostream &out) const;
+
  private:
   /// @brief Compute the new pixel size based on the screen resolution and the
   /// window size
   void computeNewPixelSize();
 
-  // BACK BUFFER
+  /// @return the palette index of a back buffer pixel (its plane bits)
+  std::uint8_t backPixel(int x, int y) const;
+
+  /// @brief Draw the front buffer in the window (see drawFrame())
+  void drawWindowFrame();
+
+  /// @brief Upload the output of the upscaler to the screen texture,
+  /// (re)creating it if its size changed
+  void uploadTexture();
+
+  /// @return the current time in seconds, from raylib or the steady clock
+  double currentTime() const;
+
+  /// @brief Sleep, with raylib or the standard library
+  /// @param seconds The time to sleep
+  void wait(double seconds) const;
+
+  /// @brief Mutex that can be turned off, see setSingleThreaded()
+  class BackBufferMutex {
+   public:
+    void lock() {
+      if (enabled) {
+        _mutex.lock();
+      }
+    }
+    void unlock() {
+      if (enabled) {
+        _mutex.unlock();
+      }
+    }
+
+    bool enabled = true;
+
+   private:
+    std::mutex _mutex;
+  };
+
+  // BACK BUFFER [rows shared copy-on-write between forks]
   Resolution _current_back_resolution = Resolution::LOW_RES;
-  std::mutex _virtual_back_screen_mutex;
-  std::array<std::array<bool, HIGH_RES_VIRTUAL_SCREEN_WIDTH>,
-             HIGH_RES_VIRTUAL_SCREEN_HEIGHT>
-      _virtual_back_screen;
+  mutable BackBufferMutex _virtual_back_screen_mutex;
+  std::array<Plane, PLANES> _virtual_back_screen;
   std::uint8_t _virtual_back_screen_height = LOW_RES_VIRTUAL_SCREEN_HEIGHT;
   std::uint8_t _virtual_back_screen_width = LOW_RES_VIRTUAL_SCREEN_WIDTH;
+  // planes drawn to (bit N: plane N)
+  std::uint8_t _selected_planes = 0x1;
 
   // FRONT BUFFER
   Resolution _current_front_resolution = Resolution::LOW_RES;
   Resolution _next_front_resolution = Resolution::LOW_RES;
-  std::array<std::array<bool, HIGH_RES_VIRTUAL_SCREEN_WIDTH>,
-             HIGH_RES_VIRTUAL_SCREEN_HEIGHT>
+  std::array<std::array<Row, HIGH_RES_VIRTUAL_SCREEN_HEIGHT>, PLANES>
       _virtual_front_screen;
   std::uint8_t _virtual_front_screen_height = LOW_RES_VIRTUAL_SCREEN_HEIGHT;
   std::uint8_t _virtual_front_screen_width = LOW_RES_VIRTUAL_SCREEN_WIDTH;
 
+  // palette indices of the front buffer, filtered into the screen texture
+  // (one upload per frame)
+  std::vector<std::uint8_t> _front_indices;
+  Upscaler _upscaler;
+  unsigned int _texture_id = 0;
+  int _texture_width = 0;
+  int _texture_height = 0;
+
   std::uint32_t _pixel_size = 15;
   std::uint32_t _vertical_offset = 0;
   std::uint32_t _horizontal_offset = 0;
 
-  std::atomic<std::uint8_t> _target_fps = TARGET_FPS;
-  std::atomic<float> _target_frame_time = 1.0f / (float)_target_fps;
-  double _previous_time = 0;
+  bool _vsync = false;
+  FramePacer _pacer{1.0 / TARGET_FPS};
+
+  // terminal drawn to instead of the window, if set
+  Terminal::Console *_console = nullptr;
 
   // called when the display thread finishes drawing the screen (vblank)
   interrupt_handler_t _interrupt_handler;
+  // called after each input poll of the frame rate wait
+  input_handler_t _input_handler;
 };
 
+using Display = BasicDisplay<1>;
+
 }  // namespace SuperChip8::System::Graphics
 
 #endif  // SUPERCHIP8_SYSTEM_GRAPHICS_DISPLAY_HPP
\ No newline at end of file
@@ -0,0 +1,189 @@
+#include "schip8_system_graphics_filter.hpp"
+
+#include <algorithm>
+
+namespace SuperChip8::System::Graphics {
+
+namespace {
+
+// brightness kept each frame by a phosphor turned off (out of 256)
+constexpr std::uint32_t PHOSPHOR_DECAY = 160;
+// brightness of the dark line of each row (out of 256)
+constexpr std::uint32_t SCANLINE_BRIGHTNESS = 96;
+
+/// @brief Scale the RGB channels of a color, keeping its alpha
+std::uint32_t dim(std::uint32_t color, std::uint32_t brightness) {
+  std::uint32_t red_blue = ((color & 0x00FF00FF) * brightness >> 8) & 0x00FF00FF;
+  std::uint32_t green = ((color & 0x0000FF00) * brightness >> 8) & 0x0000FF00;
+  return (color & 0xFF000000) | red_blue | green;
+}
+
+}  // namespace
+
+bool parseFilter(std::string_view name, Filter &filter) {
+  if (name == "nearest") {
+    filter = Filter::NEAREST;
+  } else if (name == "scale2x" || name == "epx") {
+    filter = Filter::SCALE2X;
+  } else if (name == "scale3x") {
+    filter = Filter::SCALE3X;
+  } else if (name == "scanlines") {
+    filter = Filter::SCANLINES;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+std::uint8_t filterScale(Filter filter) {
+  switch (filter) {
+    case Filter::NEAREST:
+      return 1;
+    case Filter::SCALE2X:
+      return 2;
+    case Filter::SCALE3X:
+    case Filter::SCANLINES:
+      return 3;
+  }
+  return 1;
+}
+
+Upscaler::Upscaler(Filter filter) : _filter(filter) {}
+
+void Upscaler::apply(const std::uint8_t *indices, int width, int height,
+                     const Palette &palette) {
+  if (width != _width || height != _height) {
+    _width = width;
+    _height = height;
+    std::uint8_t scale = filterScale(_filter);
+    _pixels.resize(static_cast<std::size_t>(width) * scale * height * scale);
+    _phosphor.assign(static_cast<std::size_t>(width) * height, 0);
+    _phosphor_index.assign(static_cast<std::size_t>(width) * height, 0);
+  }
+
+  switch (_filter) {
+    case Filter::NEAREST:
+      nearest(indices, palette);
+      break;
+    case Filter::SCALE2X:
+      scale2x(indices, palette);
+      break;
+    case Filter::SCALE3X:
+      scale3x(indices, palette);
+      break;
+    case Filter::SCANLINES:
+      scanlines(indices, palette);
+      break;
+  }
+}
+
+Filter Upscaler::filter() const { return _filter; }
+
+const std::uint32_t *Upscaler::pixels() const { return _pixels.data(); }
+
+int Upscaler::width() const { return _width * filterScale(_filter); }
+
+int Upscaler::height() const { return _height * filterScale(_filter); }
+
+void Upscaler::nearest(const std::uint8_t *indices, const Palette &palette) {
+  std::size_t size = static_cast<std::size_t>(_width) * _height;
+  for (std::size_t i = 0; i < size; i++) {
+    _pixels[i] = palette[indices[i] & 3];
+  }
+}
+
+void Upscaler::scale2x(const std::uint8_t *indices, const Palette &palette) {
+  int out_width = _width * 2;
+  for (int y = 0; y < _height; y++) {
+    // the neighbors outside of the screen are the edge pixels
+    const std::uint8_t *up = indices + std::max(y - 1, 0) * _width;
+    const std::uint8_t *row = indices + y * _width;
+    const std::uint8_t *down = indices + std::min(y + 1, _height - 1) * _width;
+    std::uint32_t *out = &_pixels[static_cast<std::size_t>(y) * 2 * out_width];
+    for (int x = 0; x < _width; x++) {
+      int left = std::max(x - 1, 0);
+      int right = std::min(x + 1, _width - 1);
+      std::uint8_t B = up[x], D = row[left], E = row[x], F = row[right],
+                   H = down[x];
+      std::uint8_t E0 = E, E1 = E, E2 = E, E3 = E;
+      if (B != H && D != F) {
+        E0 = D == B ? D : E;
+        E1 = B == F ? F : E;
+        E2 = D == H ? D : E;
+        E3 = H == F ? F : E;
+      }
+      out[2 * x] = palette[E0 & 3];
+      out[2 * x + 1] = palette[E1 & 3];
+      out[out_width + 2 * x] = palette[E2 & 3];
+      out[out_width + 2 * x + 1] = palette[E3 & 3];
+    }
+  }
+}
+
+void Upscaler::scale3x(const std::uint8_t *indices, const Palette &palette) {
+  int out_width = _width * 3;
+  for (int y = 0; y < _height; y++) {
+    const std::uint8_t *up = indices + std::max(y - 1, 0) * _width;
+    const std::uint8_t *row = indices + y * _width;
+    const std::uint8_t *down = indices + std::min(y + 1, _height - 1) * _width;
+    std::uint32_t *out = &_pixels[static_cast<std::size_t>(y) * 3 * out_width];
+    for (int x = 0; x < _width; x++) {
+      int left = std::max(x - 1, 0);
+      int right = std::min(x + 1, _width - 1);
+      std::uint8_t A = up[left], B = up[x], C = up[right];
+      std::uint8_t D = row[left], E = row[x], F = row[right];
+      std::uint8_t G = down[left], H = down[x], I = down[right];
+      std::uint8_t E0 = E, E1 = E, E2 = E, E3 = E, E5 = E, E6 = E, E7 = E,
+                   E8 = E;
+      if (B != H && D != F) {
+        E0 = D == B ? D : E;
+        E1 = (D == B && E != C) || (B == F && E != A) ? B : E;
+        E2 = B == F ? F : E;
+        E3 = (D == B && E != G) || (D == H && E != A) ? D : E;
+        E5 = (B == F && E != I) || (H == F && E != C) ? F : E;
+        E6 = D == H ? D : E;
+        E7 = (D == H && E != I) || (H == F && E != G) ? H : E;
+        E8 = H == F ? F : E;
+      }
+      std::uint32_t *block = out + 3 * x;
+      block[0] = palette[E0 & 3];
+      block[1] = palette[E1 & 3];
+      block[2] = palette[E2 & 3];
+      block[out_width] = palette[E3 & 3];
+      block[out_width + 1] = palette[E & 3];
+      block[out_width + 2] = palette[E5 & 3];
+      block[2 * out_width] = palette[E6 & 3];
+      block[2 * out_width + 1] = palette[E7 & 3];
+      block[2 * out_width + 2] = palette[E8 & 3];
+    }
+  }
+}
+
+void Upscaler::scanlines(const std::uint8_t *indices, const Palette &palette) {
+  int out_width = _width * 3;
+  for (int y = 0; y < _height; y++) {
+    std::uint32_t *out = &_pixels[static_cast<std::size_t>(y) * 3 * out_width];
+    for (int x = 0; x < _width; x++) {
+      std::size_t i = static_cast<std::size_t>(y) * _width + x;
+      std::uint8_t index = indices[i] & 3;
+      std::uint32_t color;
+      if (index) {
+        _phosphor[i] = 255;
+        _phosphor_index[i] = index;
+        color = palette[index];
+      } else {
+        _phosphor[i] = _phosphor[i] * PHOSPHOR_DECAY >> 8;
+        color = _phosphor[i] ? dim(palette[_phosphor_index[i]], _phosphor[i])
+                             : palette[0];
+      }
+      std::uint32_t dark = dim(color, SCANLINE_BRIGHTNESS);
+      std::uint32_t *block = out + 3 * x;
+      block[0] = block[1] = block[2] = color;
+      block[out_width] = block[out_width + 1] = block[out_width + 2] = color;
+      block[2 * out_width] = block[2 * out_width + 1] =
+          block[2 * out_width + 2] = dark;
+    }
+  }
+}
+
+}  // namespace SuperChip8::System::Graphics
@@ -0,0 +1,87 @@
+#ifndef SUPERCHIP8_SYSTEM_GRAPHICS_FILTER_HPP
+#define SUPERCHIP8_SYSTEM_GRAPHICS_FILTER_HPP
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace SuperChip8::System::Graphics {
+
+/** Upscaling filters
+ *
+ * A filter turns the palette indices of the screen into an RGBA image a few
+ * times larger (its scale), uploaded as a single texture and stretched by an
+ * integer factor to the window with nearest sampling:
+ *
+ * | filter      | scale | output                                            |
+ * |-------------|-------|---------------------------------------------------|
+ * | `nearest`   | 1     | square pixels                                     |
+ * | `scale2x`   | 2     | Scale2x (same output as EPX), smoothed diagonals  |
+ * | `scale3x`   | 3     | Scale3x                                           |
+ * | `scanlines` | 3     | dark third line under each row, and phosphor      |
+ * |             |       | decay: a pixel turned off fades out over a few    |
+ * |             |       | frames (hides the flicker of XOR redraws)         |
+ *
+ * The output is at most 384x192 pixels: the filter itself stays in the tens
+ * of microseconds whatever the window size.
+ */
+
+enum class Filter { NEAREST, SCALE2X, SCALE3X, SCANLINES };
+
+/// @brief Parse a filter name (`epx` is `scale2x`)
+/// @param name The name, see the table above
+/// @param filter The filter, set if the name is known
+/// @return `false` if the name is unknown
+bool parseFilter(std::string_view name, Filter &filter);
+
+/// @return the scale of the output of a filter
+std::uint8_t filterScale(Filter filter);
+
+/// @brief Applies a filter to each frame, keeping its output (and the
+/// phosphor state of `scanlines`)
+class Upscaler {
+ public:
+  /// @brief RGBA colors (R in the low byte), indexed by palette index
+  using Palette = std::array<std::uint32_t, 4>;
+
+  explicit Upscaler(Filter filter = Filter::NEAREST);
+
+  /// @brief Filter a screen
+  /// @param indices Palette index of each pixel, row by row
+  /// @param width The screen width
+  /// @param height The screen height
+  /// @param palette The colors of the indices
+  void apply(const std::uint8_t *indices, int width, int height,
+             const Palette &palette);
+
+  Filter filter() const;
+
+  /// @return the output of the last apply(), RGBA, row by row
+  const std::uint32_t *pixels() const;
+
+  /// @return the output width, the screen width times the filter scale
+  int width() const;
+
+  /// @return the output height, the screen height times the filter scale
+  int height() const;
+
+ private:
+  void nearest(const std::uint8_t *indices, const Palette &palette);
+  void scale2x(const std::uint8_t *indices, const Palette &palette);
+  void scale3x(const std::uint8_t *indices, const Palette &palette);
+  void scanlines(const std::uint8_t *indices, const Palette &palette);
+
+  Filter _filter;
+  int _width = 0;
+  int _height = 0;
+  std::vector<std::uint32_t> _pixels;
+
+  // scanlines: brightness (0-255) and last lit index of each screen pixel
+  std::vector<std::uint8_t> _phosphor;
+  std::vector<std::uint8_t> _phosphor_index;
+};
+
+}  // namespace SuperChip8::System::Graphics
+
+#endif  // SUPERCHIP8_SYSTEM_GRAPHICS_FILTER_HPP
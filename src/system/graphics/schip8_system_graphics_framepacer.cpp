@@ -0,0 +1,106 @@
+#include "schip8_system_graphics_framepacer.hpp"
+
+#include <algorithm>
+#include <iomanip>
+
+namespace SuperChip8::System::Graphics {
+
+void FrameHistogram::add(double interval) {
+  double milliseconds = interval * 1000;
+  std::size_t bucket = std::min<std::size_t>(
+      static_cast<std::size_t>(std::max(milliseconds, 0.0) /
+                               FRAME_HISTOGRAM_BUCKET),
+      FRAME_HISTOGRAM_BUCKETS - 1);
+  _buckets[bucket]++;
+  _count++;
+  _total += milliseconds;
+  _max = std::max(_max, milliseconds);
+}
+
+double FrameHistogram::mean() const {
+  return _count > 0 ? _total / _count : 0;
+}
+
+double FrameHistogram::percentile(double fraction) const {
+  // rank of the interval, counted from 1
+  std::uint64_t rank = std::max<std::uint64_t>(
+      static_cast<std::uint64_t>(fraction * _count + 0.5), 1);
+  std::uint64_t seen = 0;
+  for (std::size_t bucket = 0; bucket + 1 < FRAME_HISTOGRAM_BUCKETS;
+       bucket++) {
+    seen += _buckets[bucket];
+    if (seen >= rank) {
+      return (bucket + 1) * FRAME_HISTOGRAM_BUCKET;
+    }
+  }
+  return _max;
+}
+
+void FrameHistogram::write(std::ostream &out) const {
+  std::ios::fmtflags flags = out.flags();
+  out << std::fixed << std::setprecision(2) << "frame intervals: " << _count
+      << ", mean " << mean() << " ms, p50 " << percentile(0.5) << " ms, p90 "
+      << percentile(0.9) << " ms, p99 " << percentile(0.99) << " ms, p99.9 "
+      << percentile(0.999) << " ms, max " << _max << " ms" << std::endl;
+  out << std::setprecision(1);
+  for (std::size_t bucket = 0; bucket < FRAME_HISTOGRAM_BUCKETS; bucket++) {
+    if (_buckets[bucket] == 0) {
+      continue;
+    }
+    bool last = bucket + 1 == FRAME_HISTOGRAM_BUCKETS;
+    out << (last ? "  >=" : "    ") << std::setw(5)
+        << bucket * FRAME_HISTOGRAM_BUCKET << " ms: " << _buckets[bucket]
+        << std::endl;
+  }
+  out.flags(flags);
+}
+
+FramePacer::FramePacer(double frame_time) : _frame_time(frame_time) {}
+
+void FramePacer::setVSync(bool vsync) { _vsync = vsync; }
+
+void FramePacer::setMaxSkip(std::uint8_t max_skip) { _max_skip = max_skip; }
+
+bool FramePacer::shouldSkip(double time) const {
+  return _skipped_in_row < _max_skip && _deadline > 0 &&
+         time > _deadline + _frame_time * FRAME_SKIP_TOLERANCE;
+}
+
+void FramePacer::frameSkipped() {
+  _skipped_in_row++;
+  _skipped_frames++;
+  _deadline += _frame_time;
+}
+
+double FramePacer::framePresented(double time) {
+  bool first = _deadline == 0;
+  double late = 0;
+  if (!first) {
+    _histogram.add(time - _previous_present);
+    late = std::max(time - _deadline, 0.0);
+  }
+  _previous_present = time;
+  _skipped_in_row = 0;
+
+  bool missed = late > _frame_time * (_max_skip + 1);
+  if (first) {
+    _deadline = time;
+  } else if (missed) {
+    // the emulation slows down instead of bursting frames: the next frame
+    // is due now, or max_skip frames skipped first
+    _missed_frames++;
+    _deadline = time - _frame_time * (_max_skip + 1);
+  } else if (_vsync && late > 0) {
+    // the swap waited for a refresh of a slower monitor
+    _deadline = time;
+  }
+  // a frame presented late keeps the grid, the next wait is shorter
+  _deadline += _frame_time;
+  return missed ? late : 0;
+}
+
+double FramePacer::deadline() const {
+  return _vsync ? _deadline - _frame_time * VSYNC_WAKE_EARLY : _deadline;
+}
+
+}  // namespace SuperChip8::System::Graphics
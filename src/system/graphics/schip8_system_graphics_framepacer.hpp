@@ -0,0 +1,140 @@
+#ifndef SUPERCHIP8_SYSTEM_GRAPHICS_FRAMEPACER_HPP
+#define SUPERCHIP8_SYSTEM_GRAPHICS_FRAMEPACER_HPP
+
+#include <array>
+#include <cstdint>
+#include <ostream>
+
+namespace SuperChip8::System::Graphics {
+
+/** Frame pacing
+ *
+ * The frames are presented on a grid of absolute deadlines, one frame time
+ * apart: a frame presented late only shortens the wait for the next one, so
+ * an oversleep never accumulates (the emulation keeps its 60 Hz on average).
+ * A frame missed by more than a whole frame time re-anchors the grid on its
+ * present instead of bursting frames to catch up.
+ *
+ * With frame skipping (see setMaxSkip()), a frame starting more than
+ * FRAME_SKIP_TOLERANCE of a frame behind its deadline is not drawn: the
+ * vblank (CPU, timers and input) still runs, and the grid moves on by a
+ * frame, so the emulation keeps its speed when drawing is what is slow. At
+ * most max_skip frames in a row are skipped, and the grid is then only
+ * re-anchored by a frame missed by more than max_skip + 1 frame times (the
+ * max_skip frames after it are still skipped: the emulation then runs
+ * max_skip + 1 frames per frame drawn).
+ *
+ * The display sleeps until PACING_SPIN_TIME before the deadline (polling the
+ * input), then spins until the deadline: the sleep of the host may overshoot
+ * by a scheduler tick, the spin does not.
+ *
+ * With a vsync at the target rate, the swap of the window already blocks
+ * until the refresh: the display wakes up VSYNC_WAKE_EARLY of a frame before
+ * the deadline, so that it never misses a refresh, and the grid follows a
+ * monitor slower than the target (ie: 59.94 Hz) instead of skipping a
+ * refresh now and then. A swap that does not block (a driver ignoring the
+ * vsync) still presents on the grid.
+ */
+
+// time spun (instead of slept) before a deadline, in seconds
+constexpr double PACING_SPIN_TIME = 0.0005;
+// fraction of a frame time the display wakes up early with a vsync
+constexpr double VSYNC_WAKE_EARLY = 0.25;
+// fraction of a frame time a frame may start late without being skipped
+constexpr double FRAME_SKIP_TOLERANCE = 0.25;
+
+// width of a histogram bucket, in milliseconds
+constexpr double FRAME_HISTOGRAM_BUCKET = 0.1;
+// buckets, the last one holds the longer intervals (100 ms and more)
+constexpr std::size_t FRAME_HISTOGRAM_BUCKETS = 1000;
+
+/// @brief Histogram of the intervals between presented frames
+class FrameHistogram {
+ public:
+  /// @brief Count an interval
+  /// @param interval The interval, in seconds
+  void add(double interval);
+
+  /// @return the intervals counted
+  std::uint64_t count() const { return _count; }
+
+  /// @return the mean interval, in milliseconds
+  double mean() const;
+
+  /// @return the longest interval, in milliseconds
+  double max() const { return _max; }
+
+  /// @brief Interval under which a fraction of the intervals fall
+  /// @param fraction The fraction (ie: 0.99 for the p99)
+  /// @return the upper bound of its bucket, in milliseconds
+  double percentile(double fraction) const;
+
+  /// @brief Write the percentiles, then the count of each non-empty bucket
+  /// @param out The stream to write to
+  void write(std::ostream &out) const;
+
+ private:
+  std::array<std::uint32_t, FRAME_HISTOGRAM_BUCKETS> _buckets = {0};
+  std::uint64_t _count = 0;
+  double _total = 0;
+  double _max = 0;
+};
+
+/// @brief Deadlines of the presented frames, see the pacing notes above
+class FramePacer {
+ public:
+  /// @param frame_time The target frame time, in seconds
+  explicit FramePacer(double frame_time);
+
+  /// @brief Let the swap pace the frames, when the window is vsynced at the
+  /// target rate
+  /// @param vsync `true` if the swap waits for a refresh at the target rate
+  void setVSync(bool vsync);
+
+  /// @brief Skip the drawing of the frames when behind, see the pacing notes
+  /// @param max_skip The most frames skipped in a row (0 to disable)
+  void setMaxSkip(std::uint8_t max_skip);
+
+  /// @param time The time the frame starts at, in seconds
+  /// @return `true` if the frame should be emulated without being drawn
+  bool shouldSkip(double time) const;
+
+  /// @brief Account for a frame emulated without being drawn
+  void frameSkipped();
+
+  /// @brief Account for a presented frame and set the next deadline
+  /// @param time The time the frame was presented at, in seconds
+  /// @return how late the frame was if it missed its deadline (the grid is
+  /// then re-anchored), in seconds, 0 otherwise
+  double framePresented(double time);
+
+  /// @return the time the display should wake up to present the next frame,
+  /// in seconds
+  double deadline() const;
+
+  /// @return the frames missed by more than a frame time (the grid was
+  /// re-anchored)
+  std::uint64_t missedFrames() const { return _missed_frames; }
+
+  /// @return the frames emulated without being drawn
+  std::uint64_t skippedFrames() const { return _skipped_frames; }
+
+  const FrameHistogram &histogram() const { return _histogram; }
+
+ private:
+  double _frame_time;
+  bool _vsync = false;
+  std::uint8_t _max_skip = 0;
+  // frames skipped since the last present
+  std::uint8_t _skipped_in_row = 0;
+  // time the next frame should be presented at, 0 until the first present
+  double _deadline = 0;
+  double _previous_present = 0;
+  std::uint64_t _missed_frames = 0;
+  std::uint64_t _skipped_frames = 0;
+  FrameHistogram _histogram;
+};
+
+}  // namespace SuperChip8::System::Graphics
+
+#endif  // SUPERCHIP8_SYSTEM_GRAPHICS_FRAMEPACER_HPP
@@ -5,7 +5,8 @@
 
 namespace SuperChip8::System::Input {
 
-constexpr uint8_t KEY_COUNT = 16;
+// number of keys in Key
+constexpr uint8_t KEY_COUNT = 17;
 
 /// @brief SuperChip-8 keypad keys
 enum class Key {
@@ -1,9 +1,38 @@
 #include "schip8_system_input_keyboard.hpp"
+#include "schip8_system_terminal_console.hpp"
+
+#include <algorithm>
 
 namespace SuperChip8::System::Input {
 
-bool Keyboard::isKeyDown(Key key) { return IsKeyDown(_keyMap.at(key)); }
+void Keyboard::setConsole(Terminal::Console *console) { _console = console; }
+
+bool Keyboard::isKeyDown(Key key) {
+  if (_console) {
+    return _console->isKeyDown(key);
+  }
+  return IsKeyDown(_keyMap[static_cast<std::size_t>(key)]);
+}
+
+bool Keyboard::isKeyReleased(Key key) {
+  if (_console) {
+    // a terminal reports no release
+    return false;
+  }
+  return IsKeyReleased(_keyMap[static_cast<std::size_t>(key)]);
+}
 
-bool Keyboard::isKeyReleased(Key key) { return IsKeyReleased(_keyMap.at(key)); }
+std::optional<Key> Keyboard::nextKeyPressed() {
+  if (_console) {
+    return _console->nextKeyPressed();
+  }
+  for (int key = GetKeyPressed(); key != 0; key = GetKeyPressed()) {
+    auto it = std::find(_keyMap.begin(), _keyMap.end(), key);
+    if (it != _keyMap.end()) {
+      return static_cast<Key>(it - _keyMap.begin());
+    }
+  }
+  return std::nullopt;
+}
 
-}  // namespace SuperChip8::System::Input
\ No newline at end of file
+}  // namespace SuperChip8::System::Input
@@ -3,38 +3,46 @@
 
 #include "schip8_system_input_key.hpp"
 
-#include <map>
+#include <array>
+#include <optional>
 #include <raylib.h>
 
+namespace SuperChip8::System::Terminal {
+class Console;
+}  // namespace SuperChip8::System::Terminal
+
 namespace SuperChip8::System::Input {
 
 class Keyboard {
  public:
+  /// @brief Read the keys from a terminal instead of the window
+  /// @param console The console, owned by the caller
+  void setConsole(Terminal::Console *console);
+
   bool isKeyDown(Key key);
   bool isKeyReleased(Key key);
 
- private:
+  /// @brief Pop the next key pressed during the last input poll
+  ///
+  /// @details Unlike isKeyDown(), a key pressed and released between two
+  /// polls is reported. The keys that are not mapped are skipped.
+  /// @return the key, `std::nullopt` once every pressed key was popped
+  std::optional<Key> nextKeyPressed();
 
-  /// @brief Map of SuperChip-8 keys to Raylib keys
-  const std::map<Key, int> _keyMap = {{Key::RIGHT, KeyboardKey::KEY_RIGHT},
-                                      {Key::ONE, KeyboardKey::KEY_ONE},
-                                      {Key::TWO, KeyboardKey::KEY_TWO},
-                                      {Key::THREE, KeyboardKey::KEY_THREE},
-                                      {Key::FOUR, KeyboardKey::KEY_FOUR},
-                                      {Key::Q, KeyboardKey::KEY_Q},
-                                      {Key::W, KeyboardKey::KEY_W},
-                                      {Key::E, KeyboardKey::KEY_E},
-                                      {Key::R, KeyboardKey::KEY_R},
-                                      {Key::A, KeyboardKey::KEY_A},
-                                      {Key::S, KeyboardKey::KEY_S},
-                                      {Key::D, KeyboardKey::KEY_D},
-                                      {Key::F, KeyboardKey::KEY_F},
-                                      {Key::Z, KeyboardKey::KEY_Z},
-                                      {Key::X, KeyboardKey::KEY_X},
-                                      {Key::C, KeyboardKey::KEY_C},
-                                      {Key::V, KeyboardKey::KEY_V}};
+ private:
+  /// @brief Raylib keys, indexed by SuperChip-8 key (shared by every instance)
+  static constexpr std::array<int, KEY_COUNT> _keyMap = {
+      KeyboardKey::KEY_RIGHT, KeyboardKey::KEY_ONE, KeyboardKey::KEY_TWO,
+      KeyboardKey::KEY_THREE, KeyboardKey::KEY_FOUR, KeyboardKey::KEY_Q,
+      KeyboardKey::KEY_W,     KeyboardKey::KEY_E,    KeyboardKey::KEY_R,
+      KeyboardKey::KEY_A,     KeyboardKey::KEY_S,    KeyboardKey::KEY_D,
+      KeyboardKey::KEY_F,     KeyboardKey::KEY_Z,    KeyboardKey::KEY_X,
+      KeyboardKey::KEY_C,     KeyboardKey::KEY_V};
+
+  // terminal read instead of the window, if set
+  Terminal::Console *_console = nullptr;
 };
 
 }  // namespace SuperChip8::System::Input
 
-#endif  // SUPERCHIP8_SYSTEM_INPUT_KEYBOARD_HPP
\ No newline at end of file
+#endif  // SUPERCHIP8_SYSTEM_INPUT_KEYBOARD_HPP
@@ -0,0 +1,297 @@
+#include "schip8_system_log_logger.hpp"
+#include "schip8_error.hpp"
+
+#include <algorithm>
+#include <cinttypes>
+#include <cstring>
+
+namespace SuperChip8::System::Log {
+
+namespace {
+
+const char *levelName(Level level) {
+  switch (level) {
+    case Level::DEBUG:
+      return "DEBUG";
+    case Level::INFO:
+      return "INFO";
+    case Level::WARNING:
+      return "WARNING";
+    case Level::ERROR:
+      return "ERROR";
+    case Level::OFF:
+      break;
+  }
+  return "OFF";
+}
+
+/// @brief Append a text value, quoted if it has a space or a quote
+void appendText(std::string &line, std::string_view text) {
+  if (!text.empty() && text.find_first_of(" \"=") == std::string_view::npos) {
+    line += text;
+    return;
+  }
+  line += '"';
+  for (char c : text) {
+    if (c == '"' || c == '\\') {
+      line += '\\';
+    }
+    line += c;
+  }
+  line += '"';
+}
+
+}  // namespace
+
+/// @brief The ring of a thread, given back to the logger when the thread
+/// exits
+struct ThreadRing {
+  Logger::RingSlot *slot = nullptr;
+
+  ~ThreadRing() {
+    if (slot) {
+      slot->in_use.store(false, std::memory_order_release);
+    }
+  }
+};
+
+namespace {
+
+thread_local ThreadRing t_ring;
+
+}  // namespace
+
+bool parseLevel(std::string_view name, Level &level) {
+  if (name == "debug") {
+    level = Level::DEBUG;
+  } else if (name == "info") {
+    level = Level::INFO;
+  } else if (name == "warning") {
+    level = Level::WARNING;
+  } else if (name == "error") {
+    level = Level::ERROR;
+  } else if (name == "off") {
+    level = Level::OFF;
+  } else {
+    return false;
+  }
+  return true;
+}
+
+void Record::add(Hex value) {
+  Field &field = fields[field_count++];
+  field.type = Field::Type::HEX;
+  field.size = value.digits;
+  field.unsigned_value = value.value;
+}
+
+void Record::add(double value) {
+  Field &field = fields[field_count++];
+  field.type = Field::Type::FLOAT;
+  field.float_value = value;
+}
+
+void Record::add(const std::error_code &value) {
+  Field &field = fields[field_count++];
+  field.type = Field::Type::ERROR_CODE;
+  field.signed_value = value.value();
+  field.category = &value.category();
+}
+
+void Record::add(std::string_view value) {
+  Field &field = fields[field_count++];
+  std::size_t size = std::min(value.size(), TEXT_CAPACITY - text_size);
+  field.type = Field::Type::TEXT;
+  field.offset = text_size;
+  field.size = size;
+  std::memcpy(text.data() + text_size, value.data(), size);
+  text_size += size;
+}
+
+Logger &Logger::instance() {
+  static Logger logger;
+  return logger;
+}
+
+Logger::Logger()
+    : _start(std::chrono::steady_clock::now()),
+      _writer([this](std::stop_token stop_token) { writerLoop(stop_token); }) {}
+
+Logger::~Logger() {
+  _writer.request_stop();
+  _wake_cv.notify_one();
+  _writer.join();
+  flush();
+  if (_file != stderr) {
+    std::fclose(_file);
+  }
+}
+
+void Logger::setLevel(Level level) {
+  _level.store(level, std::memory_order_relaxed);
+}
+
+void Logger::open(const std::string &path, std::error_code &ec) {
+  std::FILE *file = std::fopen(path.c_str(), "a");
+  if (!file) {
+    ec = Error::LOG_FILE_ERROR;
+    return;
+  }
+  std::lock_guard lock(_write_mutex);
+  if (_file != stderr) {
+    std::fclose(_file);
+  }
+  _file = file;
+}
+
+void Logger::flush() {
+  std::lock_guard lock(_write_mutex);
+  drain();
+}
+
+bool Logger::admit(MessageSite &site, Record &record) {
+  std::uint64_t time = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                           std::chrono::steady_clock::now() - _start)
+                           .count();
+  std::uint64_t window = time / 1'000'000'000 + 1;
+  std::uint64_t site_window = site.window.load(std::memory_order_relaxed);
+  if (site_window != window &&
+      site.window.compare_exchange_strong(site_window, window,
+                                          std::memory_order_relaxed)) {
+    site.count.store(0, std::memory_order_relaxed);
+  }
+  if (site.count.fetch_add(1, std::memory_order_relaxed) >= RATE_LIMIT) {
+    site.suppressed.fetch_add(1, std::memory_order_relaxed);
+    return false;
+  }
+
+  record.site = &site;
+  record.time = time;
+  record.suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+  record.field_count = 0;
+  record.text_size = 0;
+  return true;
+}
+
+void Logger::push(const Record &record) {
+  if (!threadRing().push(record)) {
+    _dropped.fetch_add(1, std::memory_order_relaxed);
+    return;
+  }
+  if (record.site->level >= Level::ERROR) {
+    _wake.store(true, std::memory_order_relaxed);
+    _wake_cv.notify_one();
+  }
+}
+
+Logger::Ring &Logger::threadRing() {
+  if (t_ring.slot) {
+    return t_ring.slot->ring;
+  }
+  // once per thread: a ring left by an exited thread, or a new one
+  std::lock_guard lock(_rings_mutex);
+  for (auto &slot : _rings) {
+    bool in_use = false;
+    if (slot->in_use.compare_exchange_strong(in_use, true,
+                                             std::memory_order_acquire)) {
+      t_ring.slot = slot.get();
+      return slot->ring;
+    }
+  }
+  _rings.push_back(std::make_unique<RingSlot>());
+  t_ring.slot = _rings.back().get();
+  return t_ring.slot->ring;
+}
+
+void Logger::writerLoop(std::stop_token stop_token) {
+  while (!stop_token.stop_requested()) {
+    {
+      std::unique_lock lock(_wake_mutex);
+      _wake_cv.wait_for(lock, stop_token, DRAIN_INTERVAL, [this] {
+        return _wake.load(std::memory_order_relaxed);
+      });
+      _wake.store(false, std::memory_order_relaxed);
+    }
+    flush();
+  }
+}
+
+void Logger::drain() {
+  _batch.clear();
+  {
+    std::lock_guard lock(_rings_mutex);
+    for (auto &slot : _rings) {
+      Record record;
+      while (slot->ring.pop(record)) {
+        _batch.push_back(record);
+      }
+    }
+  }
+  std::uint64_t dropped = _dropped.exchange(0, std::memory_order_relaxed);
+  if (_batch.empty() && dropped == 0) {
+    return;
+  }
+
+  std::stable_sort(_batch.begin(), _batch.end(),
+                   [](const Record &a, const Record &b) {
+                     return a.time < b.time;
+                   });
+  for (const Record &record : _batch) {
+    writeRecord(record);
+  }
+  if (dropped > 0) {
+    std::fprintf(_file, "%" PRIu64 " log records dropped (full queue)\n",
+                 dropped);
+  }
+  std::fflush(_file);
+}
+
+void Logger::writeRecord(const Record &record) {
+  char buffer[64];
+  std::snprintf(buffer, sizeof(buffer), "[%5" PRIu64 ".%06" PRIu64 "] %s ",
+                record.time / 1'000'000'000,
+                record.time / 1'000 % 1'000'000,
+                levelName(record.site->level));
+  _line = buffer;
+  _line += record.site->component;
+  _line += '.';
+  _line += record.site->event;
+
+  for (std::uint8_t i = 0; i < record.field_count; i++) {
+    const Field &field = record.fields[i];
+    _line += ' ';
+    _line += record.site->fields[i] ? record.site->fields[i] : "value";
+    _line += '=';
+    switch (field.type) {
+      case Field::Type::UNSIGNED:
+        _line += std::to_string(field.unsigned_value);
+        break;
+      case Field::Type::SIGNED:
+        _line += std::to_string(field.signed_value);
+        break;
+      case Field::Type::HEX:
+        std::snprintf(buffer, sizeof(buffer), "0x%0*" PRIx64, field.size,
+                      field.unsigned_value);
+        _line += buffer;
+        break;
+      case Field::Type::FLOAT:
+        std::snprintf(buffer, sizeof(buffer), "%g", field.float_value);
+        _line += buffer;
+        break;
+      case Field::Type::ERROR_CODE:
+        appendText(_line, field.category->message(field.signed_value));
+        break;
+      case Field::Type::TEXT:
+        appendText(_line, std::string_view(record.text.data() + field.offset,
+                                           field.size));
+        break;
+    }
+  }
+  if (record.suppressed > 0) {
+    _line += " suppressed=" + std::to_string(record.suppressed);
+  }
+  _line += '\n';
+  std::fwrite(_line.data(), 1, _line.size(), _file);
+}
+
+}  // namespace SuperChip8::System::Log
@@ -0,0 +1,267 @@
+#ifndef SUPERCHIP8_SYSTEM_LOG_LOGGER_HPP
+#define SUPERCHIP8_SYSTEM_LOG_LOGGER_HPP
+
+#include "schip8_spscring.hpp"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace SuperChip8::System::Log {
+
+/** Asynchronous structured logging
+ *
+ * A message is declared once per call site, with its level, its component,
+ * its event and the names of its fields:
+ *
+ *   Log::Message<Log::Level::ERROR> UNKNOWN_OPCODE{
+ *       "vm", "unknown_opcode", {"opcode", "pc"}};
+ *
+ * and written with the field values only:
+ *
+ *   Log::write(UNKNOWN_OPCODE, Log::Hex{opcode.raw, 4}, Log::Hex{pc, 3});
+ *
+ * The values are copied in binary into a record, pushed to a lock-free ring
+ * of the calling thread: no formatting, no lock and no system call on the
+ * calling thread (an ERROR record only wakes the writer up). A background
+ * writer drains the rings every DRAIN_INTERVAL, sorts the records by time and
+ * formats them as one line each:
+ *
+ *   [    1.204311] ERROR vm.unknown_opcode opcode=0x00ff pc=0x204
+ *
+ * The messages below SUPERCHIP8_LOG_LEVEL (cmake -DLOG_LEVEL=<level>) are
+ * compiled out, the others are filtered by the level set at run time. A call
+ * site writes at most RATE_LIMIT records per second, the next record of the
+ * site reports how many were suppressed. A full ring drops the record (the
+ * drops are reported by the writer).
+ */
+
+enum class Level : std::uint8_t { DEBUG, INFO, WARNING, ERROR, OFF };
+
+#ifndef SUPERCHIP8_LOG_LEVEL
+#define SUPERCHIP8_LOG_LEVEL 0
+#endif
+// lowest level compiled in
+constexpr Level COMPILED_LEVEL = static_cast<Level>(SUPERCHIP8_LOG_LEVEL);
+
+constexpr std::size_t MAX_FIELDS = 4;
+// bytes of the text fields of a record, longer texts are truncated
+constexpr std::size_t TEXT_CAPACITY = 64;
+// records queued per thread
+constexpr std::size_t RING_CAPACITY = 256;
+// records written per second and call site
+constexpr std::uint32_t RATE_LIMIT = 10;
+constexpr std::chrono::milliseconds DRAIN_INTERVAL(50);
+
+/// @brief Parse a level name (debug, info, warning, error, off)
+/// @param name The name
+/// @param level The level, set if the name is known
+/// @return `false` if the name is unknown
+bool parseLevel(std::string_view name, Level &level);
+
+/// @brief An unsigned value written in hexadecimal
+struct Hex {
+  std::uint64_t value;
+  // minimum number of digits
+  std::uint8_t digits = 1;
+};
+
+/// @brief A call site: the level, the names and the rate limit state, the
+/// records only point to it
+struct MessageSite {
+  Level level;
+  const char *component;
+  const char *event;
+  std::array<const char *, MAX_FIELDS> fields;
+
+  // second (plus one) of the current rate limit window, records written in
+  // it, and records suppressed since the last one written
+  std::atomic<std::uint64_t> window = 0;
+  std::atomic<std::uint32_t> count = 0;
+  std::atomic<std::uint32_t> suppressed = 0;
+};
+
+/// @brief A call site of a given level, see write()
+template <Level LEVEL>
+struct Message : MessageSite {
+  constexpr Message(const char *component, const char *event,
+                    std::array<const char *, MAX_FIELDS> fields = {})
+      : MessageSite{LEVEL, component, event, fields} {}
+};
+
+/// @brief A field value, as copied by the calling thread
+struct Field {
+  enum class Type : std::uint8_t {
+    UNSIGNED,
+    SIGNED,
+    HEX,
+    FLOAT,
+    ERROR_CODE,
+    TEXT
+  };
+
+  Type type;
+  // HEX: minimum number of digits, TEXT: size
+  std::uint8_t size;
+  // TEXT: offset in the text of the record
+  std::uint8_t offset;
+  union {
+    std::uint64_t unsigned_value;
+    std::int64_t signed_value;
+    double float_value;
+  };
+  // ERROR_CODE: the category of signed_value
+  const std::error_category *category;
+};
+
+/// @brief A queued message
+struct Record {
+  const MessageSite *site;
+  // nanoseconds since the logger started
+  std::uint64_t time;
+  std::uint32_t suppressed;
+  std::uint8_t field_count;
+  std::uint8_t text_size;
+  std::array<Field, MAX_FIELDS> fields;
+  std::array<char, TEXT_CAPACITY> text;
+
+  void add(Hex value);
+  void add(double value);
+  void add(const std::error_code &value);
+  void add(std::string_view value);
+  void add(const char *value) { add(std::string_view(value)); }
+  void add(const std::string &value) { add(std::string_view(value)); }
+  void add(bool value) { addInteger(value); }
+  template <typename T>
+  std::enable_if_t<std::is_integral_v<T>> add(T value) {
+    addInteger(value);
+  }
+
+ private:
+  template <typename T>
+  void addInteger(T value) {
+    Field &field = fields[field_count++];
+    if constexpr (std::is_signed_v<T>) {
+      field.type = Field::Type::SIGNED;
+      field.signed_value = value;
+    } else {
+      field.type = Field::Type::UNSIGNED;
+      field.unsigned_value = value;
+    }
+  }
+};
+
+/// @brief The process logger: the rings of the threads, and their writer
+class Logger {
+ public:
+  /// @return the logger, its writer is started by the first call
+  static Logger &instance();
+
+  ~Logger();
+
+  Logger(const Logger &) = delete;
+  Logger &operator=(const Logger &) = delete;
+
+  /// @brief Set the lowest level written (WARNING by default)
+  void setLevel(Level level);
+
+  /// @return the lowest level written
+  Level level() const { return _level.load(std::memory_order_relaxed); }
+
+  /// @brief Write the records to a file (appended) instead of stderr
+  /// @param path The file path
+  /// @param ec Error::LOG_FILE_ERROR
+  ///
+  /// - If the file cannot be opened
+  void open(const std::string &path, std::error_code &ec);
+
+  /// @brief Write the records queued so far, on the calling thread
+  void flush();
+
+  /// @brief Start a record of a call site (calling thread), see write()
+  /// @param site The call site
+  /// @param record Stamped if admitted
+  /// @return `false` if the site is over its rate limit
+  bool admit(MessageSite &site, Record &record);
+
+  /// @brief Queue a record to the ring of the calling thread
+  /// @param record The record
+  void push(const Record &record);
+
+ private:
+  using Ring = SpscRing<Record, RING_CAPACITY>;
+
+  /// @brief A ring, reused once its thread exited
+  struct RingSlot {
+    Ring ring;
+    std::atomic<bool> in_use = true;
+  };
+  friend struct ThreadRing;
+
+  Logger();
+
+  /// @return the ring of the calling thread, taken on its first record
+  Ring &threadRing();
+
+  /// @brief Writer thread
+  void writerLoop(std::stop_token stop_token);
+
+  /// @brief Pop, sort and write the queued records (under _write_mutex)
+  void drain();
+  void writeRecord(const Record &record);
+
+  std::atomic<Level> _level = Level::WARNING;
+  std::chrono::steady_clock::time_point _start;
+
+  std::mutex _rings_mutex;
+  std::vector<std::unique_ptr<RingSlot>> _rings;
+  std::atomic<std::uint64_t> _dropped = 0;
+
+  // the records are written by a single thread at a time
+  std::mutex _write_mutex;
+  std::FILE *_file = stderr;
+  std::vector<Record> _batch;
+  std::string _line;
+
+  std::mutex _wake_mutex;
+  std::condition_variable_any _wake_cv;
+  std::atomic<bool> _wake = false;
+  std::jthread _writer;
+};
+
+/// @brief Write a message: compiled out below COMPILED_LEVEL, dropped below
+/// the level of the logger or over the rate limit of the call site
+/// @param message The call site
+/// @param values The field values (integers, bool, Hex, double,
+/// std::error_code, strings)
+template <Level LEVEL, typename... Values>
+void write(Message<LEVEL> &message, const Values &...values) {
+  static_assert(sizeof...(Values) <= MAX_FIELDS, "too many log fields");
+  if constexpr (LEVEL >= COMPILED_LEVEL && LEVEL != Level::OFF) {
+    Logger &logger = Logger::instance();
+    if (LEVEL < logger.level()) {
+      return;
+    }
+    Record record;
+    if (!logger.admit(message, record)) {
+      return;
+    }
+    (record.add(values), ...);
+    logger.push(record);
+  }
+}
+
+}  // namespace SuperChip8::System::Log
+
+#endif  // SUPERCHIP8_SYSTEM_LOG_LOGGER_HPP
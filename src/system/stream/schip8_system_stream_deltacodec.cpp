@@ -0,0 +1,177 @@
+#include "schip8_system_stream_deltacodec.hpp"
+
+#include <algorithm>
+#include <cstring>
+
+namespace SuperChip8::System::Stream {
+
+namespace {
+
+constexpr std::uint8_t KEYFRAME_FLAG = 0x1;
+// longest PackBits run or literal sequence
+constexpr std::size_t PACKBITS_MAX_LENGTH = 128;
+
+/// @brief PackBits compression: a header byte N followed by N + 1 literal
+/// bytes (N < 128), or by one byte repeated 257 - N times (N > 128)
+void packBits(const std::uint8_t *data, std::size_t size,
+              std::vector<std::uint8_t> &out) {
+  std::size_t i = 0;
+  while (i < size) {
+    std::size_t run = 1;
+    while (i + run < size && run < PACKBITS_MAX_LENGTH &&
+           data[i + run] == data[i]) {
+      run++;
+    }
+    if (run > 1) {
+      out.push_back(static_cast<std::uint8_t>(257 - run));
+      out.push_back(data[i]);
+      i += run;
+      continue;
+    }
+
+    // literals, up to the next run
+    std::size_t start = i;
+    while (i < size && i - start < PACKBITS_MAX_LENGTH &&
+           !(i + 1 < size && data[i] == data[i + 1])) {
+      i++;
+    }
+    out.push_back(static_cast<std::uint8_t>(i - start - 1));
+    out.insert(out.end(), data + start, data + i);
+  }
+}
+
+/// @brief PackBits decompression
+/// @return `false` if the data does not decompress to exactly `size` bytes
+bool unpackBits(const std::uint8_t *data, std::size_t size, std::uint8_t *out,
+                std::size_t out_size) {
+  std::size_t read = 0;
+  std::size_t written = 0;
+  while (read < size) {
+    std::uint8_t header = data[read++];
+    if (header < 128) {
+      std::size_t length = header + 1;
+      if (read + length > size || written + length > out_size) {
+        return false;
+      }
+      std::memcpy(out + written, data + read, length);
+      read += length;
+      written += length;
+    } else if (header > 128) {
+      std::size_t length = 257 - header;
+      if (read >= size || written + length > out_size) {
+        return false;
+      }
+      std::memset(out + written, data[read++], length);
+      written += length;
+    }
+  }
+  return written == out_size;
+}
+
+void writeLE(std::vector<std::uint8_t> &out, std::uint64_t value,
+             std::size_t bytes) {
+  for (std::size_t i = 0; i < bytes; i++) {
+    out.push_back(static_cast<std::uint8_t>(value >> (8 * i)));
+  }
+}
+
+std::uint64_t readLE(const std::uint8_t *data, std::size_t bytes) {
+  std::uint64_t value = 0;
+  for (std::size_t i = 0; i < bytes; i++) {
+    value |= static_cast<std::uint64_t>(data[i]) << (8 * i);
+  }
+  return value;
+}
+
+}  // namespace
+
+void encodeFrame(const Graphics::Frame &frame,
+                 const Graphics::Frame *previous, std::uint32_t number,
+                 std::vector<std::uint8_t> &out) {
+  bool keyframe = !previous || previous->width != frame.width ||
+                  previous->height != frame.height;
+  std::size_t row_size = frame.width / 8;
+
+  // the changed rows, raw
+  std::uint64_t changed_rows = 0;
+  std::uint8_t rows[Graphics::FRAME_ROW_BYTES *
+                    Graphics::HIGH_RES_VIRTUAL_SCREEN_HEIGHT];
+  std::size_t rows_size = 0;
+  for (std::uint8_t y = 0; y < frame.height; y++) {
+    const std::uint8_t *row = &frame.pixels[y * Graphics::FRAME_ROW_BYTES];
+    if (!keyframe &&
+        std::equal(row, row + row_size,
+                   &previous->pixels[y * Graphics::FRAME_ROW_BYTES])) {
+      continue;
+    }
+    changed_rows |= std::uint64_t(1) << y;
+    std::memcpy(rows + rows_size, row, row_size);
+    rows_size += row_size;
+  }
+
+  std::size_t header = out.size();
+  writeLE(out, number, 4);
+  out.push_back(keyframe ? KEYFRAME_FLAG : 0);
+  out.push_back(frame.width);
+  out.push_back(frame.height);
+  writeLE(out, changed_rows, 8);
+  writeLE(out, 0, 2);
+  packBits(rows, rows_size, out);
+
+  // payload size, now that it is known
+  std::size_t payload_size = out.size() - header - DELTA_HEADER_SIZE;
+  out[header + 15] = static_cast<std::uint8_t>(payload_size);
+  out[header + 16] = static_cast<std::uint8_t>(payload_size >> 8);
+}
+
+bool readDeltaHeader(const std::uint8_t *data, std::size_t size,
+                     DeltaHeader &header) {
+  if (size < DELTA_HEADER_SIZE) {
+    return false;
+  }
+  header.number = static_cast<std::uint32_t>(readLE(data, 4));
+  header.keyframe = data[4] & KEYFRAME_FLAG;
+  header.width = data[5];
+  header.height = data[6];
+  header.changed_rows = readLE(data + 7, 8);
+  header.payload_size = static_cast<std::uint16_t>(readLE(data + 15, 2));
+  return (header.width == Graphics::LOW_RES_VIRTUAL_SCREEN_WIDTH &&
+          header.height == Graphics::LOW_RES_VIRTUAL_SCREEN_HEIGHT) ||
+         (header.width == Graphics::HIGH_RES_VIRTUAL_SCREEN_WIDTH &&
+          header.height == Graphics::HIGH_RES_VIRTUAL_SCREEN_HEIGHT);
+}
+
+bool decodeFrame(const DeltaHeader &header, const std::uint8_t *payload,
+                 Graphics::Frame &frame) {
+  if (!header.keyframe &&
+      (frame.width != header.width || frame.height != header.height)) {
+    return false;
+  }
+  std::size_t row_size = header.width / 8;
+  std::size_t row_count = 0;
+  for (std::uint8_t y = 0; y < header.height; y++) {
+    row_count += (header.changed_rows >> y) & 1;
+  }
+
+  std::uint8_t rows[Graphics::FRAME_ROW_BYTES *
+                    Graphics::HIGH_RES_VIRTUAL_SCREEN_HEIGHT];
+  if (!unpackBits(payload, header.payload_size, rows, row_count * row_size)) {
+    return false;
+  }
+
+  if (header.keyframe) {
+    frame.pixels.fill(0);
+  }
+  frame.width = header.width;
+  frame.height = header.height;
+  const std::uint8_t *row = rows;
+  for (std::uint8_t y = 0; y < header.height; y++) {
+    if ((header.changed_rows >> y) & 1) {
+      std::memcpy(&frame.pixels[y * Graphics::FRAME_ROW_BYTES], row, row_size);
+      row += row_size;
+    }
+  }
+  return true;
+}
+
+}  // namespace SuperChip8::System::Stream
@@ -0,0 +1,72 @@
+#ifndef SUPERCHIP8_SYSTEM_STREAM_DELTACODEC_HPP
+#define SUPERCHIP8_SYSTEM_STREAM_DELTACODEC_HPP
+
+#include "schip8_system_graphics_display.hpp"
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace SuperChip8::System::Stream {
+
+/** Delta frame format (little endian)
+ *
+ * +--------+------+--------------------------------------------------+
+ * | offset | size | field                                            |
+ * +--------+------+--------------------------------------------------+
+ * | 0      | 4    | frame number                                     |
+ * | 4      | 1    | flags, bit 0: keyframe                           |
+ * | 5      | 1    | width (64 or 128)                                |
+ * | 6      | 1    | height (32 or 64)                                |
+ * | 7      | 8    | changed rows (bit N: row N is in the payload)    |
+ * | 15     | 2    | payload size                                     |
+ * | 17     | ...  | payload: the changed rows in order, width / 8    |
+ * |        |      | bytes each (see Graphics::Frame), PackBits       |
+ * |        |      | compressed                                       |
+ * +--------+------+--------------------------------------------------+
+ *
+ * A keyframe carries every row, a delta frame the rows that changed since
+ * the previous frame of the stream (an unchanged frame is 17 bytes long). A
+ * decoder must start from a keyframe.
+ */
+constexpr std::size_t DELTA_HEADER_SIZE = 17;
+
+struct DeltaHeader {
+  std::uint32_t number = 0;
+  bool keyframe = false;
+  std::uint8_t width = 0;
+  std::uint8_t height = 0;
+  std::uint64_t changed_rows = 0;
+  std::uint16_t payload_size = 0;
+};
+
+/// @brief Encode a frame
+/// @param frame The frame to encode
+/// @param previous The previous frame of the stream, `nullptr` to encode a
+/// keyframe (also encoded if the resolution changed)
+/// @param number The frame number
+/// @param out The buffer the encoded frame is appended to
+void encodeFrame(const Graphics::Frame &frame,
+                 const Graphics::Frame *previous, std::uint32_t number,
+                 std::vector<std::uint8_t> &out);
+
+/// @brief Read the header of an encoded frame
+/// @param data The encoded frame
+/// @param size The size of data (at least DELTA_HEADER_SIZE)
+/// @param header The header read
+/// @return `false` if the header is invalid
+bool readDeltaHeader(const std::uint8_t *data, std::size_t size,
+                     DeltaHeader &header);
+
+/// @brief Apply an encoded frame to the previous frame of the stream
+/// @param header The frame header (see readDeltaHeader())
+/// @param payload The header.payload_size bytes following the header
+/// @param frame The previous frame, updated (ignored for a keyframe)
+/// @return `false` if the payload is corrupted, or if a delta frame does not
+/// match the resolution of `frame`
+bool decodeFrame(const DeltaHeader &header, const std::uint8_t *payload,
+                 Graphics::Frame &frame);
+
+}  // namespace SuperChip8::System::Stream
+
+#endif  // SUPERCHIP8_SYSTEM_STREAM_DELTACODEC_HPP
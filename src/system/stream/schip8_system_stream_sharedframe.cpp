@@ -0,0 +1,100 @@
+#include "schip8_system_stream_sharedframe.hpp"
+#include "schip8_error.hpp"
+
+#include <fcntl.h>
+#include <new>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace SuperChip8::System::Stream {
+
+SharedFrameWriter::~SharedFrameWriter() {
+  if (_shared) {
+    munmap(_shared, sizeof(SharedFrame));
+    shm_unlink(_name.c_str());
+  }
+}
+
+void SharedFrameWriter::open(const std::string &name, std::error_code &ec) {
+  // a previous export of the same name is replaced, its readers keep the old
+  // mapping
+  shm_unlink(name.c_str());
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    ec = Error::SHARED_MEMORY_ERROR;
+    return;
+  }
+  void *memory = MAP_FAILED;
+  if (ftruncate(fd, sizeof(SharedFrame)) == 0) {
+    memory = mmap(nullptr, sizeof(SharedFrame), PROT_READ | PROT_WRITE,
+                  MAP_SHARED, fd, 0);
+  }
+  close(fd);
+  if (memory == MAP_FAILED) {
+    shm_unlink(name.c_str());
+    ec = Error::SHARED_MEMORY_ERROR;
+    return;
+  }
+
+  _name = name;
+  _shared = new (memory) SharedFrame{SHARED_FRAME_MAGIC, SHARED_FRAME_VERSION,
+                                     0, Graphics::Frame{}};
+}
+
+void SharedFrameWriter::publish(const Graphics::Frame &frame) {
+  std::uint64_t sequence = _shared->sequence.load(std::memory_order_relaxed);
+  _shared->sequence.store(sequence + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  _shared->frame = frame;
+  _shared->sequence.store(sequence + 2, std::memory_order_release);
+}
+
+SharedFrameReader::~SharedFrameReader() {
+  if (_shared) {
+    munmap(const_cast<SharedFrame *>(_shared), sizeof(SharedFrame));
+  }
+}
+
+void SharedFrameReader::open(const std::string &name, std::error_code &ec) {
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    ec = Error::SHARED_MEMORY_ERROR;
+    return;
+  }
+  void *memory = mmap(nullptr, sizeof(SharedFrame), PROT_READ, MAP_SHARED, fd,
+                      0);
+  close(fd);
+  if (memory == MAP_FAILED) {
+    ec = Error::SHARED_MEMORY_ERROR;
+    return;
+  }
+
+  const SharedFrame *shared = static_cast<const SharedFrame *>(memory);
+  if (shared->magic != SHARED_FRAME_MAGIC ||
+      shared->version != SHARED_FRAME_VERSION) {
+    munmap(memory, sizeof(SharedFrame));
+    ec = Error::SHARED_MEMORY_ERROR;
+    return;
+  }
+  _shared = shared;
+}
+
+std::uint64_t SharedFrameReader::read(Graphics::Frame &frame) const {
+  while (true) {
+    std::uint64_t before = _shared->sequence.load(std::memory_order_acquire);
+    if (before & 1) {
+      continue;
+    }
+    frame = _shared->frame;
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (_shared->sequence.load(std::memory_order_relaxed) == before) {
+      return before / 2;
+    }
+  }
+}
+
+std::uint64_t SharedFrameReader::frameNumber() const {
+  return _shared->sequence.load(std::memory_order_acquire) / 2;
+}
+
+}  // namespace SuperChip8::System::Stream
@@ -0,0 +1,99 @@
+#ifndef SUPERCHIP8_SYSTEM_STREAM_SHAREDFRAME_HPP
+#define SUPERCHIP8_SYSTEM_STREAM_SHAREDFRAME_HPP
+
+#include "schip8_system_graphics_display.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <system_error>
+
+namespace SuperChip8::System::Stream {
+
+/** Shared-memory frame export
+ *
+ * The emulator maps a POSIX shared-memory object (`/dev/shm/<name>` on
+ * Linux) holding a SharedFrame, and writes each published frame to it in
+ * place. Readers in other processes map the same object read-only: reading a
+ * frame takes no system call and no copy through the kernel.
+ *
+ * The frame is guarded by a seqlock: the writer makes `sequence` odd, writes
+ * the frame, then makes it even again. A reader copies the frame between two
+ * loads of `sequence`, and keeps the copy only if both are the same even
+ * value (the writer never waits for the readers).
+ */
+
+// "S8FB", SharedFrame::magic
+constexpr std::uint32_t SHARED_FRAME_MAGIC = 0x42463853;
+constexpr std::uint32_t SHARED_FRAME_VERSION = 1;
+
+/// @brief Layout of the shared-memory object
+struct SharedFrame {
+  std::uint32_t magic;
+  std::uint32_t version;
+  // seqlock sequence, odd while the frame is written, twice the number of
+  // frames published otherwise
+  std::atomic<std::uint64_t> sequence;
+  Graphics::Frame frame;
+};
+static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+              "the seqlock needs a lock-free 64 bits atomic");
+
+/// @brief Writer side of a shared-memory frame export (the emulator)
+class SharedFrameWriter {
+ public:
+  SharedFrameWriter() = default;
+
+  /// @brief Unmap and remove the shared-memory object
+  ~SharedFrameWriter();
+
+  SharedFrameWriter(const SharedFrameWriter &) = delete;
+  SharedFrameWriter &operator=(const SharedFrameWriter &) = delete;
+
+  /// @brief Create (or replace) and map the shared-memory object
+  /// @param name The object name, ie: `/schip8`
+  /// @param ec Error::SHARED_MEMORY_ERROR
+  void open(const std::string &name, std::error_code &ec);
+
+  /// @brief Write a frame (from a single thread, ie: after the vblank)
+  /// @param frame The frame to publish
+  void publish(const Graphics::Frame &frame);
+
+ private:
+  std::string _name;
+  SharedFrame *_shared = nullptr;
+};
+
+/// @brief Reader side of a shared-memory frame export
+class SharedFrameReader {
+ public:
+  SharedFrameReader() = default;
+
+  /// @brief Unmap the shared-memory object
+  ~SharedFrameReader();
+
+  SharedFrameReader(const SharedFrameReader &) = delete;
+  SharedFrameReader &operator=(const SharedFrameReader &) = delete;
+
+  /// @brief Map an exported shared-memory object, read-only
+  /// @param name The object name, ie: `/schip8`
+  /// @param ec Error::SHARED_MEMORY_ERROR, if it does not exist or is not a
+  /// SharedFrame
+  void open(const std::string &name, std::error_code &ec);
+
+  /// @brief Copy the last published frame
+  /// @details Retries while the writer is writing it, never blocks otherwise.
+  /// @param frame The frame to fill
+  /// @return the frame number (0 if no frame was published yet)
+  std::uint64_t read(Graphics::Frame &frame) const;
+
+  /// @return the number of the last published frame, without copying it
+  std::uint64_t frameNumber() const;
+
+ private:
+  const SharedFrame *_shared = nullptr;
+};
+
+}  // namespace SuperChip8::System::Stream
+
+#endif  // SUPERCHIP8_SYSTEM_STREAM_SHAREDFRAME_HPP
@@ -0,0 +1,131 @@
+#include "schip8_system_stream_socket.hpp"
+#include "schip8_error.hpp"
+
+#include <arpa/inet.h>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <string_view>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace SuperChip8::System::Stream {
+
+namespace {
+
+constexpr std::string_view UNIX_PREFIX = "unix:";
+constexpr std::string_view TCP_PREFIX = "tcp:";
+constexpr const char *DEFAULT_TCP_HOST = "127.0.0.1";
+// pending connections
+constexpr int LISTEN_BACKLOG = 16;
+
+/// @brief Socket address of a stream address
+struct SocketAddress {
+  int family = AF_UNSPEC;
+  sockaddr_storage storage = {};
+  socklen_t length = 0;
+};
+
+bool parseAddress(const std::string &address, SocketAddress &socket_address) {
+  if (address.starts_with(UNIX_PREFIX)) {
+    std::string path = address.substr(UNIX_PREFIX.size());
+    sockaddr_un *un = reinterpret_cast<sockaddr_un *>(&socket_address.storage);
+    if (path.empty() || path.size() >= sizeof(un->sun_path)) {
+      return false;
+    }
+    un->sun_family = AF_UNIX;
+    std::memcpy(un->sun_path, path.c_str(), path.size() + 1);
+    socket_address.family = AF_UNIX;
+    socket_address.length = sizeof(sockaddr_un);
+    return true;
+  }
+
+  if (address.starts_with(TCP_PREFIX)) {
+    std::string host = DEFAULT_TCP_HOST;
+    std::string port = address.substr(TCP_PREFIX.size());
+    std::size_t colon = port.rfind(':');
+    if (colon != std::string::npos) {
+      host = port.substr(0, colon);
+      port = port.substr(colon + 1);
+    }
+    sockaddr_in *in = reinterpret_cast<sockaddr_in *>(&socket_address.storage);
+    in->sin_family = AF_INET;
+    if (inet_pton(AF_INET, host.c_str(), &in->sin_addr) != 1) {
+      return false;
+    }
+    char *end = nullptr;
+    unsigned long number = std::strtoul(port.c_str(), &end, 10);
+    if (port.empty() || *end != '\0' || number == 0 || number > 65535) {
+      return false;
+    }
+    in->sin_port = htons(static_cast<std::uint16_t>(number));
+    socket_address.family = AF_INET;
+    socket_address.length = sizeof(sockaddr_in);
+    return true;
+  }
+
+  return false;
+}
+
+}  // namespace
+
+int listenSocket(const std::string &address, std::error_code &ec) {
+  SocketAddress socket_address;
+  if (!parseAddress(address, socket_address)) {
+    ec = Error::INVALID_STREAM_ADDRESS;
+    return -1;
+  }
+
+  int fd = socket(socket_address.family, SOCK_STREAM, 0);
+  if (fd < 0) {
+    ec = Error::STREAM_SOCKET_ERROR;
+    return -1;
+  }
+  if (socket_address.family == AF_UNIX) {
+    unlinkSocket(address);
+  } else {
+    int reuse = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+  }
+  if (bind(fd, reinterpret_cast<sockaddr *>(&socket_address.storage),
+           socket_address.length) < 0 ||
+      listen(fd, LISTEN_BACKLOG) < 0) {
+    close(fd);
+    ec = Error::STREAM_SOCKET_ERROR;
+    return -1;
+  }
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  return fd;
+}
+
+int connectSocket(const std::string &address, std::error_code &ec) {
+  SocketAddress socket_address;
+  if (!parseAddress(address, socket_address)) {
+    ec = Error::INVALID_STREAM_ADDRESS;
+    return -1;
+  }
+
+  int fd = socket(socket_address.family, SOCK_STREAM, 0);
+  if (fd < 0) {
+    ec = Error::STREAM_SOCKET_ERROR;
+    return -1;
+  }
+  if (connect(fd, reinterpret_cast<sockaddr *>(&socket_address.storage),
+              socket_address.length) < 0) {
+    close(fd);
+    ec = Error::STREAM_SOCKET_ERROR;
+    return -1;
+  }
+  return fd;
+}
+
+void unlinkSocket(const std::string &address) {
+  if (address.starts_with(UNIX_PREFIX)) {
+    unlink(address.substr(UNIX_PREFIX.size()).c_str());
+  }
+}
+
+}  // namespace SuperChip8::System::Stream
@@ -0,0 +1,37 @@
+#ifndef SUPERCHIP8_SYSTEM_STREAM_SOCKET_HPP
+#define SUPERCHIP8_SYSTEM_STREAM_SOCKET_HPP
+
+#include <string>
+#include <system_error>
+
+namespace SuperChip8::System::Stream {
+
+/** Stream addresses
+ *
+ * - `unix:<path>`: Unix-domain stream socket at path
+ * - `tcp:<port>`: TCP on the loopback interface (127.0.0.1)
+ * - `tcp:<ipv4>:<port>`: TCP on the given interface (0.0.0.0 for all of
+ *   them), or the given host when connecting
+ */
+
+/// @brief Create a listening socket (non-blocking)
+///
+/// @details An existing Unix-domain socket file is replaced.
+/// @param address The address to listen on
+/// @param ec Error::INVALID_STREAM_ADDRESS, Error::STREAM_SOCKET_ERROR
+/// @return the socket file descriptor, -1 on error
+int listenSocket(const std::string &address, std::error_code &ec);
+
+/// @brief Connect to a listening socket (blocking)
+/// @param address The address to connect to
+/// @param ec Error::INVALID_STREAM_ADDRESS, Error::STREAM_SOCKET_ERROR
+/// @return the socket file descriptor, -1 on error
+int connectSocket(const std::string &address, std::error_code &ec);
+
+/// @brief Remove the socket file of a Unix-domain address (nothing for TCP)
+/// @param address The address listened on
+void unlinkSocket(const std::string &address);
+
+}  // namespace SuperChip8::System::Stream
+
+#endif  // SUPERCHIP8_SYSTEM_STREAM_SOCKET_HPP
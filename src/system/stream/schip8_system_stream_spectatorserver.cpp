@@ -0,0 +1,208 @@
+#include "schip8_system_stream_spectatorserver.hpp"
+#include "schip8_error.hpp"
+#include "schip8_system_stream_deltacodec.hpp"
+#include "schip8_system_stream_socket.hpp"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+namespace SuperChip8::System::Stream {
+
+namespace {
+
+#ifdef MSG_NOSIGNAL
+// a viewer closing its socket must not raise SIGPIPE
+constexpr int SEND_FLAGS = MSG_DONTWAIT | MSG_NOSIGNAL;
+#else
+constexpr int SEND_FLAGS = MSG_DONTWAIT;
+#endif
+
+void setNonBlocking(int fd) {
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+}  // namespace
+
+SpectatorServer::SpectatorServer(std::uint32_t keyframe_interval)
+    : _keyframe_interval(keyframe_interval ? keyframe_interval : 1) {}
+
+SpectatorServer::~SpectatorServer() {
+  if (_thread.joinable()) {
+    _thread.request_stop();
+    char wake = 0;
+    (void)write(_wake_fds[1], &wake, 1);
+    _thread.join();
+  }
+  for (int fd : {_listen_fd, _wake_fds[0], _wake_fds[1]}) {
+    if (fd >= 0) {
+      close(fd);
+    }
+  }
+  if (_listen_fd >= 0) {
+    unlinkSocket(_address);
+  }
+}
+
+void SpectatorServer::listen(const std::string &address,
+                             std::error_code &ec) {
+  _listen_fd = listenSocket(address, ec);
+  if (ec) {
+    return;
+  }
+  _address = address;
+  if (pipe(_wake_fds) < 0) {
+    ec = Error::STREAM_SOCKET_ERROR;
+    return;
+  }
+  setNonBlocking(_wake_fds[0]);
+  setNonBlocking(_wake_fds[1]);
+
+  _thread = std::jthread(&SpectatorServer::serve, this);
+}
+
+void SpectatorServer::publish(const Graphics::Frame &frame) {
+  {
+    std::lock_guard lock(_frame_mutex);
+    _published_frame = frame;
+    _frame_pending = true;
+  }
+  // a full pipe already wakes the server thread up
+  char wake = 0;
+  (void)write(_wake_fds[1], &wake, 1);
+}
+
+std::uint64_t SpectatorServer::droppedFrames() const {
+  return _dropped_frames.load();
+}
+
+void SpectatorServer::serve(std::stop_token stop_token) {
+  std::vector<pollfd> fds;
+  while (!stop_token.stop_requested()) {
+    fds.clear();
+    fds.push_back({_wake_fds[0], POLLIN, 0});
+    fds.push_back({_listen_fd, POLLIN, 0});
+    for (const Viewer &viewer : _viewers) {
+      short events = POLLIN;
+      if (viewer.sent < viewer.pending.size()) {
+        events |= POLLOUT;
+      }
+      fds.push_back({viewer.fd, events, 0});
+    }
+    if (poll(fds.data(), fds.size(), -1) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      break;
+    }
+
+    if (fds[0].revents & POLLIN) {
+      char wake[64];
+      while (read(_wake_fds[0], wake, sizeof(wake)) > 0) {
+      }
+    }
+
+    if (fds[1].revents & POLLIN) {
+      for (int fd = accept(_listen_fd, nullptr, nullptr); fd >= 0;
+           fd = accept(_listen_fd, nullptr, nullptr)) {
+        setNonBlocking(fd);
+        _viewers.push_back({fd, {}});
+      }
+    }
+
+    // the viewers only send to disconnect, the rest is ignored
+    for (std::size_t i = 0; i + 2 < fds.size(); i++) {
+      Viewer &viewer = _viewers[i];
+      short revents = fds[i + 2].revents;
+      bool connected = !(revents & (POLLERR | POLLHUP | POLLNVAL));
+      if (connected && (revents & POLLIN)) {
+        char ignored[64];
+        connected = read(viewer.fd, ignored, sizeof(ignored)) != 0;
+      }
+      if (connected && (revents & POLLOUT)) {
+        connected = flush(viewer);
+      }
+      if (!connected) {
+        close(viewer.fd);
+        viewer.fd = -1;
+      }
+    }
+    std::erase_if(_viewers, [](const Viewer &viewer) { return viewer.fd < 0; });
+
+    bool frame_pending = false;
+    {
+      std::lock_guard lock(_frame_mutex);
+      std::swap(frame_pending, _frame_pending);
+    }
+    if (frame_pending) {
+      broadcast();
+    }
+  }
+
+  for (const Viewer &viewer : _viewers) {
+    close(viewer.fd);
+  }
+  _viewers.clear();
+}
+
+void SpectatorServer::broadcast() {
+  Graphics::Frame frame;
+  {
+    std::lock_guard lock(_frame_mutex);
+    frame = _published_frame;
+  }
+
+  bool keyframe = _frame_number % _keyframe_interval == 0;
+  _delta.clear();
+  encodeFrame(frame, keyframe ? nullptr : &_previous_frame, _frame_number,
+              _delta);
+  // encoded for the viewers that need it only
+  _keyframe.clear();
+
+  for (Viewer &viewer : _viewers) {
+    if (viewer.sent < viewer.pending.size()) {
+      // still sending a previous frame: this one is dropped, the stream of
+      // the viewer goes on with a keyframe
+      _dropped_frames++;
+      viewer.needs_keyframe = true;
+      continue;
+    }
+    if (viewer.needs_keyframe && !keyframe) {
+      if (_keyframe.empty()) {
+        encodeFrame(frame, nullptr, _frame_number, _keyframe);
+      }
+      viewer.pending = _keyframe;
+    } else {
+      viewer.pending = _delta;
+    }
+    viewer.sent = 0;
+    viewer.needs_keyframe = false;
+    if (!flush(viewer)) {
+      close(viewer.fd);
+      viewer.fd = -1;
+    }
+  }
+  std::erase_if(_viewers, [](const Viewer &viewer) { return viewer.fd < 0; });
+
+  _previous_frame = frame;
+  _frame_number++;
+}
+
+bool SpectatorServer::flush(Viewer &viewer) {
+  while (viewer.sent < viewer.pending.size()) {
+    ssize_t sent = send(viewer.fd, viewer.pending.data() + viewer.sent,
+                        viewer.pending.size() - viewer.sent, SEND_FLAGS);
+    if (sent < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return errno == EAGAIN || errno == EWOULDBLOCK;
+    }
+    viewer.sent += sent;
+  }
+  return true;
+}
+
+}  // namespace SuperChip8::System::Stream
@@ -0,0 +1,98 @@
+#ifndef SUPERCHIP8_SYSTEM_STREAM_SPECTATORSERVER_HPP
+#define SUPERCHIP8_SYSTEM_STREAM_SPECTATORSERVER_HPP
+
+#include "schip8_system_graphics_display.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+namespace SuperChip8::System::Stream {
+
+// frames between two keyframes of the broadcast stream
+constexpr std::uint32_t DEFAULT_KEYFRAME_INTERVAL = 60;
+
+/// @brief Spectator server, streams the published frames to any number of
+/// viewers as delta frames (see schip8_system_stream_deltacodec.hpp)
+///
+/// @details publish() only copies the frame and wakes the server thread up,
+/// which encodes it once and writes it to every viewer with non-blocking
+/// sends. A viewer still receiving a previous frame (slow consumer) has the
+/// new one dropped, and gets a keyframe once it caught up: the emulator never
+/// waits for a viewer, and each viewer decodes a consistent stream.
+class SpectatorServer {
+ public:
+  /// @param keyframe_interval Frames between two keyframes (the viewers that
+  /// joined or dropped frames get one right away)
+  explicit SpectatorServer(
+      std::uint32_t keyframe_interval = DEFAULT_KEYFRAME_INTERVAL);
+
+  /// @brief Stop the server, disconnecting the viewers
+  ~SpectatorServer();
+
+  SpectatorServer(const SpectatorServer &) = delete;
+  SpectatorServer &operator=(const SpectatorServer &) = delete;
+
+  /// @brief Listen for viewers and start the server thread
+  /// @param address The address to listen on (see
+  /// schip8_system_stream_socket.hpp)
+  /// @param ec Error::INVALID_STREAM_ADDRESS, Error::STREAM_SOCKET_ERROR
+  void listen(const std::string &address, std::error_code &ec);
+
+  /// @brief Publish a frame (from a single thread, ie: after the vblank)
+  /// @details Never blocks on the viewers.
+  /// @param frame The frame to stream
+  void publish(const Graphics::Frame &frame);
+
+  /// @return the frames dropped for slow viewers, summed over the viewers
+  std::uint64_t droppedFrames() const;
+
+ private:
+  struct Viewer {
+    int fd;
+    // encoded frame being sent, and its bytes already sent
+    std::vector<std::uint8_t> pending;
+    std::size_t sent = 0;
+    // the next frame sent must be a keyframe
+    bool needs_keyframe = true;
+  };
+
+  /// @brief Server loop: accept the viewers, stream the frames
+  void serve(std::stop_token stop_token);
+
+  /// @brief Encode the last published frame and send it to every viewer
+  void broadcast();
+
+  /// @brief Send the pending bytes of a viewer
+  /// @return `false` if the viewer disconnected
+  bool flush(Viewer &viewer);
+
+  std::uint32_t _keyframe_interval;
+  std::string _address;
+  int _listen_fd = -1;
+  // written by publish() to wake the server thread up
+  int _wake_fds[2] = {-1, -1};
+
+  // last published frame
+  std::mutex _frame_mutex;
+  Graphics::Frame _published_frame;
+  bool _frame_pending = false;
+
+  // SERVER THREAD STATE
+  std::vector<Viewer> _viewers;
+  Graphics::Frame _previous_frame;
+  std::uint32_t _frame_number = 0;
+  std::vector<std::uint8_t> _delta;
+  std::vector<std::uint8_t> _keyframe;
+  std::atomic<std::uint64_t> _dropped_frames = 0;
+
+  std::jthread _thread;
+};
+
+}  // namespace SuperChip8::System::Stream
+
+#endif  // SUPERCHIP8_SYSTEM_STREAM_SPECTATORSERVER_HPP
@@ -0,0 +1,264 @@
+#include "schip8_system_terminal_console.hpp"
+#include "schip8_error.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <unistd.h>
+
+namespace SuperChip8::System::Terminal {
+
+namespace {
+
+// characters sent by the terminal, indexed by key (Key::RIGHT is an escape
+// sequence)
+constexpr std::array<char, Input::KEY_COUNT> KEY_CHARACTERS = {
+    '\0', '1', '2', '3', '4', 'q', 'w', 'e', 'r',
+    'a',  's', 'd', 'f', 'z', 'x', 'c', 'v'};
+
+// half block glyphs, indexed by the top (bit 0) and bottom (bit 1) pixels
+const char *const HALF_BLOCKS[] = {" ", "▀", "▄", "█"};
+
+// braille dot bits, indexed by the pixel position in the cell [y][x]
+constexpr std::uint8_t BRAILLE_DOTS[4][2] = {
+    {0x01, 0x08}, {0x02, 0x10}, {0x04, 0x20}, {0x40, 0x80}};
+
+// pressed keys kept between two polls, the older ones are dropped
+constexpr std::size_t MAX_PRESSED_KEYS = 32;
+
+const char ESCAPE = '\x1b';
+
+bool pixel(const Graphics::Frame &frame, int x, int y) {
+  return frame.pixels[y * Graphics::FRAME_ROW_BYTES + x / 8] &
+         (0x80 >> (x % 8));
+}
+
+}  // namespace
+
+Console::Console(Glyphs glyphs) : _glyphs(glyphs) {}
+
+Console::~Console() { close(); }
+
+void Console::open(std::error_code &ec) {
+  if (!isatty(STDOUT_FILENO)) {
+    ec = Error::TERMINAL_ERROR;
+    return;
+  }
+  // without a terminal on stdin (ie: redirected), the console only draws
+  if (isatty(STDIN_FILENO) && tcgetattr(STDIN_FILENO, &_saved_mode) == 0) {
+    struct termios raw_mode = _saved_mode;
+    raw_mode.c_lflag &= ~(ICANON | ECHO);
+    raw_mode.c_cc[VMIN] = 0;
+    raw_mode.c_cc[VTIME] = 0;
+    _raw_input = tcsetattr(STDIN_FILENO, TCSANOW, &raw_mode) == 0;
+  }
+
+  // alternate screen, hidden cursor
+  write("\x1b[?1049h\x1b[?25l\x1b[2J");
+  _screen_width = 0;
+  _screen_height = 0;
+  _open = true;
+}
+
+void Console::close() {
+  if (!_open) {
+    return;
+  }
+  write("\x1b[?25h\x1b[?1049l");
+  if (_raw_input) {
+    tcsetattr(STDIN_FILENO, TCSANOW, &_saved_mode);
+    _raw_input = false;
+  }
+  _open = false;
+}
+
+void Console::render(const Graphics::Frame &frame) {
+  computeCells(frame);
+  int columns = frame.width;
+  int rows = frame.height / 2;
+  if (_glyphs == Glyphs::BRAILLE) {
+    columns = frame.width / 2;
+    rows = frame.height / 4;
+  }
+
+  _output.clear();
+  if (frame.width != _screen_width || frame.height != _screen_height) {
+    _output += "\x1b[H\x1b[2J";
+    _screen_cells.assign(_cells.size(), 0);
+    _screen_width = frame.width;
+    _screen_height = frame.height;
+  }
+
+  // the cursor is only moved to the first cell of each run of changed cells
+  int cursor_row = -1;
+  int cursor_column = -1;
+  for (int row = 0; row < rows; row++) {
+    for (int column = 0; column < columns; column++) {
+      std::size_t cell = row * columns + column;
+      if (_cells[cell] == _screen_cells[cell]) {
+        continue;
+      }
+      if (row != cursor_row || column != cursor_column) {
+        _output += "\x1b[" + std::to_string(row + 1) + ";" +
+                   std::to_string(column + 1) + "H";
+      }
+      appendGlyph(_cells[cell]);
+      cursor_row = row;
+      cursor_column = column + 1;
+    }
+  }
+  _screen_cells.swap(_cells);
+
+  if (!_output.empty()) {
+    write(_output);
+  }
+}
+
+void Console::pollInput() {
+  if (!_raw_input) {
+    return;
+  }
+  char buffer[64];
+  for (ssize_t count = ::read(STDIN_FILENO, buffer, sizeof(buffer));
+       count > 0; count = ::read(STDIN_FILENO, buffer, sizeof(buffer))) {
+    _pending_input.append(buffer, count);
+  }
+
+  std::size_t i = 0;
+  while (i < _pending_input.size()) {
+    char c = _pending_input[i];
+    if (c != ESCAPE) {
+      auto it = std::find(KEY_CHARACTERS.begin() + 1, KEY_CHARACTERS.end(),
+                          std::tolower(static_cast<unsigned char>(c)));
+      if (it != KEY_CHARACTERS.end()) {
+        pressKey(static_cast<Input::Key>(it - KEY_CHARACTERS.begin()));
+      }
+      i++;
+      continue;
+    }
+
+    if (i + 1 == _pending_input.size()) {
+      // a lone escape is the Escape key, unless the rest of a sequence comes
+      // in the next reads
+      auto now = std::chrono::steady_clock::now();
+      if (_escape_time == std::chrono::steady_clock::time_point{}) {
+        _escape_time = now;
+      }
+      if (now - _escape_time < ESCAPE_TIMEOUT) {
+        break;
+      }
+      _close_requested = true;
+      i++;
+      continue;
+    }
+    if (_pending_input[i + 1] != '[' && _pending_input[i + 1] != 'O') {
+      // Alt + key
+      i += 2;
+      continue;
+    }
+    // control sequence, up to its final byte
+    std::size_t end = i + 2;
+    while (end < _pending_input.size() &&
+           (_pending_input[end] < 0x40 || _pending_input[end] > 0x7E)) {
+      end++;
+    }
+    if (end == _pending_input.size()) {
+      // the rest of the sequence is in the next read
+      break;
+    }
+    if (end == i + 2 && _pending_input[end] == 'C') {
+      pressKey(Input::Key::RIGHT);
+    }
+    i = end + 1;
+  }
+  _pending_input.erase(0, i);
+  if (_pending_input.size() != 1 || _pending_input[0] != ESCAPE) {
+    _escape_time = {};
+  }
+}
+
+bool Console::closeRequested() const { return _close_requested; }
+
+bool Console::isKeyDown(Input::Key key) const {
+  auto time = _key_times[static_cast<std::size_t>(key)];
+  return time != std::chrono::steady_clock::time_point{} &&
+         std::chrono::steady_clock::now() - time < KEY_HOLD_TIME;
+}
+
+std::optional<Input::Key> Console::nextKeyPressed() {
+  if (_pressed_keys.empty()) {
+    return std::nullopt;
+  }
+  Input::Key key = _pressed_keys.front();
+  _pressed_keys.pop_front();
+  return key;
+}
+
+void Console::write(const std::string &data) {
+  std::size_t written = 0;
+  while (written < data.size()) {
+    ssize_t count =
+        ::write(STDOUT_FILENO, data.data() + written, data.size() - written);
+    if (count < 0 && errno == EINTR) {
+      continue;
+    }
+    if (count <= 0) {
+      return;
+    }
+    written += count;
+  }
+}
+
+void Console::computeCells(const Graphics::Frame &frame) {
+  if (_glyphs == Glyphs::HALF_BLOCKS) {
+    _cells.resize(frame.width * (frame.height / 2));
+    auto cell = _cells.begin();
+    for (int y = 0; y < frame.height; y += 2) {
+      for (int x = 0; x < frame.width; x++) {
+        *cell++ = pixel(frame, x, y) | pixel(frame, x, y + 1) << 1;
+      }
+    }
+    return;
+  }
+
+  _cells.resize((frame.width / 2) * (frame.height / 4));
+  auto cell = _cells.begin();
+  for (int y = 0; y < frame.height; y += 4) {
+    for (int x = 0; x < frame.width; x += 2) {
+      std::uint8_t dots = 0;
+      for (int dy = 0; dy < 4; dy++) {
+        for (int dx = 0; dx < 2; dx++) {
+          if (pixel(frame, x + dx, y + dy)) {
+            dots |= BRAILLE_DOTS[dy][dx];
+          }
+        }
+      }
+      *cell++ = dots;
+    }
+  }
+}
+
+void Console::appendGlyph(std::uint8_t cell) {
+  if (_glyphs == Glyphs::HALF_BLOCKS) {
+    _output += HALF_BLOCKS[cell];
+    return;
+  }
+  if (cell == 0) {
+    _output += ' ';
+    return;
+  }
+  // U+2800 + dots, in UTF-8
+  _output += static_cast<char>(0xE2);
+  _output += static_cast<char>(0xA0 | cell >> 6);
+  _output += static_cast<char>(0x80 | (cell & 0x3F));
+}
+
+void Console::pressKey(Input::Key key) {
+  if (_pressed_keys.size() == MAX_PRESSED_KEYS) {
+    _pressed_keys.pop_front();
+  }
+  _pressed_keys.push_back(key);
+  _key_times[static_cast<std::size_t>(key)] = std::chrono::steady_clock::now();
+}
+
+}  // namespace SuperChip8::System::Terminal
@@ -0,0 +1,120 @@
+#ifndef SUPERCHIP8_SYSTEM_TERMINAL_CONSOLE_HPP
+#define SUPERCHIP8_SYSTEM_TERMINAL_CONSOLE_HPP
+
+#include "schip8_system_graphics_display.hpp"
+#include "schip8_system_input_key.hpp"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <optional>
+#include <string>
+#include <system_error>
+#include <termios.h>
+#include <vector>
+
+namespace SuperChip8::System::Terminal {
+
+/** Terminal rendering
+ *
+ * The frame is drawn with one character cell per 1x2 pixels (half blocks:
+ * ' ', '▀', '▄', '█') or per 2x4 pixels (braille patterns, U+2800 to U+28FF),
+ * ie: 128x32 or 64x16 cells in high resolution. Only the cells that changed
+ * since the previous frame are written, each run of them after an ANSI cursor
+ * move: an unchanged frame writes nothing, which keeps the bandwidth over SSH
+ * tiny. The whole screen is redrawn when the resolution changes.
+ *
+ * Terminal input
+ *
+ * stdin is read in raw mode (no line buffering, no echo, the keys of
+ * schip8_system_input_keyboard.hpp, the right arrow for Key::RIGHT). A
+ * terminal reports no key release: a key is down while it repeats, and for
+ * KEY_HOLD_TIME after its last repeat. Escape closes the console, Ctrl+C
+ * still raises SIGINT. An escape byte also starts the sequence of an arrow
+ * key, which a read may split: it is the Escape key only when nothing follows
+ * it for ESCAPE_TIMEOUT.
+ */
+
+// how long a key stays down after the terminal sent it (the key repeat
+// interval, around 30 ms, must be shorter)
+constexpr std::chrono::milliseconds KEY_HOLD_TIME(100);
+// how long a lone escape byte waits for the rest of a sequence
+constexpr std::chrono::milliseconds ESCAPE_TIMEOUT(50);
+
+/// @brief Terminal display and keyboard, in place of the raylib window
+class Console {
+ public:
+  enum class Glyphs { HALF_BLOCKS, BRAILLE };
+
+  explicit Console(Glyphs glyphs = Glyphs::HALF_BLOCKS);
+
+  /// @brief Restore the terminal, see close()
+  ~Console();
+
+  Console(const Console &) = delete;
+  Console &operator=(const Console &) = delete;
+
+  /// @brief Switch the terminal to the alternate screen, stdin to raw mode
+  /// @param ec Error::TERMINAL_ERROR, if stdout is not a terminal
+  void open(std::error_code &ec);
+
+  /// @brief Restore the screen and the mode of the terminal
+  void close();
+
+  /// @brief Draw a frame, writing the changed cells only
+  /// @param frame The frame
+  void render(const Graphics::Frame &frame);
+
+  /// @brief Read the keys sent since the last poll (never blocks)
+  void pollInput();
+
+  /// @return `true` once Escape was pressed
+  bool closeRequested() const;
+
+  /// @return `true` if the key was sent in the last KEY_HOLD_TIME
+  bool isKeyDown(Input::Key key) const;
+
+  /// @brief Pop the next key sent during the last input poll
+  /// @return the key, `std::nullopt` once every key was popped
+  std::optional<Input::Key> nextKeyPressed();
+
+ private:
+  /// @brief Write a string to stdout, entirely
+  void write(const std::string &data);
+
+  /// @brief Compute the glyph index of every cell of a frame
+  void computeCells(const Graphics::Frame &frame);
+
+  /// @brief Append the UTF-8 glyph of a cell
+  void appendGlyph(std::uint8_t cell);
+
+  /// @brief Record a key sent by the terminal
+  void pressKey(Input::Key key);
+
+  Glyphs _glyphs;
+  bool _open = false;
+  bool _raw_input = false;
+  struct termios _saved_mode;
+
+  // cells of the frame being drawn and of the frame on screen (half blocks:
+  // bit 0 top pixel, bit 1 bottom pixel, braille: the dot bits)
+  std::vector<std::uint8_t> _cells;
+  std::vector<std::uint8_t> _screen_cells;
+  std::uint8_t _screen_width = 0;
+  std::uint8_t _screen_height = 0;
+  std::string _output;
+
+  std::deque<Input::Key> _pressed_keys;
+  std::array<std::chrono::steady_clock::time_point, Input::KEY_COUNT>
+      _key_times = {};
+  // bytes of an escape sequence split between two reads
+  std::string _pending_input;
+  // time a lone escape byte was read at, while it waits for ESCAPE_TIMEOUT
+  std::chrono::steady_clock::time_point _escape_time;
+  bool _close_requested = false;
+};
+
+}  // namespace SuperChip8::System::Terminal
+
+#endif  // SUPERCHIP8_SYSTEM_TERMINAL_CONSOLE_HPP
@@ -0,0 +1,346 @@
+#include "schip8_emulator_inputscript.hpp"
+#include "schip8_emulator_vm.hpp"
+#include "schip8_system_capture_recorder.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cxxopts.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+/** Batch ROM runner
+ *
+ * Runs every ROM headless (one VM per ROM, no window, no audio) on a pool of
+ * worker threads, for the same number of frames and with the same input
+ * script, then writes a single JSON report:
+ *
+ * {
+ *   "frames": 600, "cycles": 10, "jobs": 8, "elapsed_s": 1.234,
+ *   "results": [
+ *     {"rom": "games/RPS.ch8", "platform": "schip",
+ *      "exit_reason": "completed", "frames": 600, "frame_hash": "...",
+ *      "state_hash": "...", "instructions": 6000, "ips": 1.2e7,
+ *      "verified": true, "error": null},
+ *     ...
+ *   ]
+ * }
+ *
+ * exit_reason is one of "completed" (all the frames were run), "exited" (the
+ * ROM executed 00FD) or "error" (see "error": {"code", "message"}). verified
+ * tells if the ROM was proven to stay in bounds, and ran unchecked (see
+ * schip8_emulator_analysis_verifier.hpp). platform is the platform and quirks
+ * profile the ROM ran with (see schip8_emulator_platform.hpp).
+ *
+ * With `--capture <directory>`, the frames of each ROM are also recorded to
+ * `<directory>/<rom name>.<format>` (see
+ * schip8_system_capture_videowriter.hpp). Every frame is recorded: the VM
+ * waits for the encoder thread when its queue is full.
+ */
+
+namespace {
+
+namespace fs = std::filesystem;
+
+// extensions picked up when a directory is given
+const std::vector<std::string> ROM_EXTENSIONS = {".ch8", ".c8", ".sc8",
+                                                 ".xo8"};
+
+struct CaptureOptions {
+  // no capture if empty
+  fs::path directory;
+  std::string format;
+  std::uint8_t scale = 1;
+};
+
+struct BatchResult {
+  std::string_view platform;
+  std::string exit_reason;
+  std::uint32_t frames = 0;
+  std::uint64_t frame_hash = 0;
+  std::uint64_t state_hash = 0;
+  std::uint64_t instructions = 0;
+  double seconds = 0;
+  bool verified = false;
+  std::error_code ec;
+};
+
+std::vector<fs::path> collectRoms(const std::vector<std::string> &inputs) {
+  std::vector<fs::path> roms;
+  for (const std::string &input : inputs) {
+    if (!fs::is_directory(input)) {
+      roms.emplace_back(input);
+      continue;
+    }
+
+    std::vector<fs::path> found;
+    for (const fs::directory_entry &entry :
+         fs::recursive_directory_iterator(input)) {
+      if (entry.is_regular_file() &&
+          std::find(ROM_EXTENSIONS.begin(), ROM_EXTENSIONS.end(),
+                    entry.path().extension().string()) !=
+              ROM_EXTENSIONS.end()) {
+        found.push_back(entry.path());
+      }
+    }
+    std::sort(found.begin(), found.end());
+    roms.insert(roms.end(), found.begin(), found.end());
+  }
+  return roms;
+}
+
+template <typename Machine>
+BatchResult runRom(const fs::path &rom, std::uint32_t frames,
+                   std::uint16_t cycles,
+                   const std::vector<SuperChip8::Emulator::InputEvent> &events,
+                   const CaptureOptions &capture) {
+  BatchResult result;
+  auto start = std::chrono::steady_clock::now();
+
+  Machine vm(cycles);
+  vm.seed(0);
+  vm.boot(rom.string(), result.ec);
+
+  std::unique_ptr<SuperChip8::System::Capture::Recorder> recorder;
+  SuperChip8::System::Graphics::Frame frame;
+  if (!result.ec && !capture.directory.empty()) {
+    recorder = std::make_unique<SuperChip8::System::Capture::Recorder>();
+    fs::path path = capture.directory / rom.stem();
+    path += "." + capture.format;
+    recorder->open(path.string(), capture.scale, result.ec);
+  }
+
+  std::size_t next_event = 0;
+  while (!result.ec && result.frames < frames && vm.isRunning()) {
+    while (next_event < events.size() &&
+           events[next_event].frame <= result.frames) {
+      vm.setKey(events[next_event].key, events[next_event].pressed);
+      next_event++;
+    }
+    vm.runFrame(result.ec);
+    result.frames++;
+    if (recorder) {
+      vm.display().packFrontBuffer(frame);
+      recorder->push(frame, true);
+    }
+  }
+  if (recorder) {
+    std::error_code capture_ec;
+    recorder->close(capture_ec);
+    if (!result.ec) {
+      result.ec = capture_ec;
+    }
+  }
+
+  result.seconds = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+  result.frame_hash = vm.display().hashBackBuffer();
+  result.state_hash = vm.registers().hash();
+  result.instructions = vm.executedInstructions();
+  result.verified = vm.isVerified();
+  if (result.ec) {
+    result.exit_reason = "error";
+  } else if (!vm.isRunning()) {
+    result.exit_reason = "exited";
+  } else {
+    result.exit_reason = "completed";
+  }
+  return result;
+}
+
+std::string jsonString(const std::string &value) {
+  std::ostringstream out;
+  out << '"';
+  for (char c : value) {
+    switch (c) {
+      case '"':
+        out << "\\\"";
+        break;
+      case '\\':
+        out << "\\\\";
+        break;
+      case '\n':
+        out << "\\n";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          out << "\\u" << std::hex << std::setw(4) << std::setfill('0')
+              << static_cast<int>(c) << std::dec;
+        } else {
+          out << c;
+        }
+        break;
+    }
+  }
+  out << '"';
+  return out.str();
+}
+
+std::string toHex(std::uint64_t value) {
+  std::ostringstream out;
+  out << std::hex << std::setw(16) << std::setfill('0') << value;
+  return out.str();
+}
+
+void writeReport(std::ostream &out, const std::vector<fs::path> &roms,
+                 const std::vector<BatchResult> &results, std::uint32_t frames,
+                 std::uint16_t cycles, unsigned jobs, double elapsed) {
+  out << "{\n"
+      << "  \"frames\": " << frames << ",\n"
+      << "  \"cycles\": " << cycles << ",\n"
+      << "  \"jobs\": " << jobs << ",\n"
+      << "  \"elapsed_s\": " << elapsed << ",\n"
+      << "  \"results\": [";
+  for (std::size_t i = 0; i < roms.size(); i++) {
+    const BatchResult &result = results[i];
+    double ips =
+        result.seconds > 0 ? result.instructions / result.seconds : 0.0;
+    out << (i == 0 ? "\n" : ",\n") << "    {\"rom\": "
+        << jsonString(roms[i].string())
+        << ", \"platform\": " << jsonString(std::string(result.platform))
+        << ", \"exit_reason\": " << jsonString(result.exit_reason)
+        << ", \"frames\": " << result.frames
+        << ", \"frame_hash\": " << jsonString(toHex(result.frame_hash))
+        << ", \"state_hash\": " << jsonString(toHex(result.state_hash))
+        << ", \"instructions\": " << result.instructions
+        << ", \"ips\": " << ips
+        << ", \"verified\": " << (result.verified ? "true" : "false")
+        << ", \"error\": ";
+    if (result.ec) {
+      out << "{\"code\": " << result.ec.value()
+          << ", \"message\": " << jsonString(result.ec.message()) << "}";
+    } else {
+      out << "null";
+    }
+    out << "}";
+  }
+  out << "\n  ]\n}\n";
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  cxxopts::Options options("SuperChip8_batch",
+                           "SuperChip8 parallel headless batch ROM runner");
+
+  // clang-format off
+  options.add_options()
+  ("h,help", "Print help")
+  ("f,frames", "Frames to run per ROM", cxxopts::value<std::uint32_t>()->default_value("600"))
+  ("c,cpu", "CPU cycles per frame", cxxopts::value<std::uint16_t>()->default_value("10"))
+  ("i,input", "Input script applied to every ROM (see schip8_emulator_inputscript.hpp)", cxxopts::value<std::string>()->default_value(""))
+  ("p,platform", "Platform and quirks of every ROM - [schip] | [schip-modern] | [schip-legacy] | [chip8] | [xo-chip] (default: xo-chip for .xo8 files, schip otherwise)", cxxopts::value<std::string>())
+  ("j,jobs", "Worker threads (default: one per hardware thread)", cxxopts::value<unsigned>()->default_value("0"))
+  ("o,output", "Path of the JSON report (default: stdout)", cxxopts::value<std::string>())
+  ("capture", "Record the frames of each ROM in this directory", cxxopts::value<std::string>())
+  ("capture-format", "Format of the recorded videos - [y4m] | [gif]", cxxopts::value<std::string>()->default_value("y4m"))
+  ("capture-scale", "Integer scale of the recorded videos (1: 128x64) - [1-16]", cxxopts::value<std::uint8_t>()->default_value("1"))
+  ("roms", "ROM files or directories", cxxopts::value<std::vector<std::string>>());
+  // clang-format on
+  options.parse_positional({"roms"});
+  options.positional_help("<rom|directory>...");
+
+  auto result = options.parse(argc, argv);
+  if (result.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+  if (!result.count("roms")) {
+    std::cerr << "Error: no ROM provided" << std::endl;
+    std::cout << options.help() << std::endl;
+    return 1;
+  }
+
+  std::error_code ec;
+  std::vector<SuperChip8::Emulator::InputEvent> events =
+      SuperChip8::Emulator::parseInputScript(result["input"].as<std::string>(),
+                                             ec);
+  if (ec) {
+    std::cerr << "Error: " << ec.message() << std::endl;
+    return 1;
+  }
+
+  std::vector<fs::path> roms =
+      collectRoms(result["roms"].as<std::vector<std::string>>());
+  std::uint32_t frames = result["frames"].as<std::uint32_t>();
+  std::uint16_t cycles = result["cpu"].as<std::uint16_t>();
+  unsigned jobs = result["jobs"].as<unsigned>();
+  if (jobs == 0) {
+    jobs = std::max(1u, std::thread::hardware_concurrency());
+  }
+  jobs = std::min<unsigned>(jobs, std::max<std::size_t>(1, roms.size()));
+  std::string forced_platform;
+  if (result.count("platform")) {
+    forced_platform = result["platform"].as<std::string>();
+    if (!SuperChip8::Emulator::visitPlatform(forced_platform, [](auto) {})) {
+      std::cerr << "Error: unknown platform " << forced_platform << " ("
+                << SuperChip8::Emulator::PLATFORM_NAMES << ")" << std::endl;
+      return 1;
+    }
+  }
+
+  CaptureOptions capture;
+  if (result.count("capture")) {
+    capture.directory = result["capture"].as<std::string>();
+    capture.format = result["capture-format"].as<std::string>();
+    capture.scale = result["capture-scale"].as<std::uint8_t>();
+    fs::create_directories(capture.directory, ec);
+    if (ec) {
+      std::cerr << "Error: " << ec.message() << std::endl;
+      return 1;
+    }
+  }
+
+  // each worker picks the next ROM to run until none is left
+  std::vector<BatchResult> results(roms.size());
+  std::atomic<std::size_t> next_rom = 0;
+  auto start = std::chrono::steady_clock::now();
+  {
+    std::vector<std::jthread> workers;
+    for (unsigned i = 0; i < jobs; i++) {
+      workers.emplace_back([&]() {
+        for (std::size_t rom = next_rom++; rom < roms.size();
+             rom = next_rom++) {
+          // .xo8 ROMs run on the XO-CHIP VM, unless a platform is forced
+          std::string_view platform =
+              forced_platform.empty()
+                  ? SuperChip8::Emulator::defaultPlatform(roms[rom])
+                  : forced_platform;
+          SuperChip8::Emulator::visitPlatform(platform, [&](auto tag) {
+            results[rom] = runRom<SuperChip8::Emulator::BasicVM<decltype(tag)>>(
+                roms[rom], frames, cycles, events, capture);
+          });
+          results[rom].platform = platform;
+        }
+      });
+    }
+  }
+  double elapsed = std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+  if (result.count("output")) {
+    std::ofstream out(result["output"].as<std::string>());
+    if (!out.is_open()) {
+      std::cerr << "Error: cannot write " << result["output"].as<std::string>()
+                << std::endl;
+      return 1;
+    }
+    writeReport(out, roms, results, frames, cycles, jobs, elapsed);
+  } else {
+    writeReport(std::cout, roms, results, frames, cycles, jobs, elapsed);
+  }
+
+  return std::any_of(results.begin(), results.end(),
+                     [](const BatchResult &r) { return bool(r.ec); })
+             ? 1
+             : 0;
+}
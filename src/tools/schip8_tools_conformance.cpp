@@ -0,0 +1,431 @@
+#include "schip8_emulator_batch_engine.hpp"
+#include "schip8_emulator_host_vmhost.hpp"
+#include "schip8_emulator_inputscript.hpp"
+#include "schip8_emulator_vm.hpp"
+#include "schip8_error.hpp"
+
+#include <chrono>
+#include <cstring>
+#include <cxxopts.hpp>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+#include <vector>
+
+/** Conformance manifest format
+ *
+ * One ROM per line, blank lines and lines starting with '#' are ignored:
+ *
+ *   <rom> <platform> <frames> <cycles> <status> <frame_hash> <state_hash>
+ *   [input_script]
+ *
+ * - rom: path to the ROM, relative to the manifest directory
+ * - platform: the VM platform (see PLATFORM_NAMES)
+ * - frames: number of frames to run
+ * - cycles: CPU cycles per frame
+ * - status: expected end of the run, `verified` (the program is proven in
+ *   bounds and runs unchecked, see Analysis::verify()), `unverified` (it runs
+ *   with the bounds checks), or the fault that stops it: `out-of-range`,
+ *   `stack-overflow`, `stack-underflow` or `unknown-opcode`
+ * - frame_hash: expected Display back buffer hash (hex), '-' if unknown
+ * - state_hash: expected Registers hash (hex), '-' if unknown
+ * - input_script: optional, see schip8_emulator_inputscript.hpp
+ *
+ * Every run is deterministic: the VM runs headless and its random number
+ * generator is seeded with 0. The hashes of a faulting run are those of the
+ * VM stopped on the fault.
+ *
+ * With --cross-check, each ROM also runs in lockstep with the VM, and the
+ * first difference after a frame fails the ROM:
+ * - on a single lane of the batch engine (a second implementation of the
+ *   instructions, see schip8_emulator_batch_engine.hpp): registers, delay
+ *   timer and framebuffer
+ * - on a VMHost instance (see schip8_emulator_host_vmhost.hpp): framebuffer
+ * - on a fork of the VM taken before the frame (see VM::fork()), that must
+ *   end the frame as its parent did, whatever pages they both wrote to:
+ *   registers and back buffer
+ * The engine and the host only run the `schip` platform, and do not draw
+ * CXNN from the seeded generator of the VM: the ROMs of the other platforms
+ * are not cross-checked, and a ROM using CXNN diverges.
+ */
+
+namespace {
+
+namespace fs = std::filesystem;
+
+struct ConformanceCase {
+  std::string rom;
+  std::string platform;
+  std::uint32_t frames;
+  std::uint16_t cycles;
+  std::string status;
+  std::string frame_hash;
+  std::string state_hash;
+  std::string input_script;
+};
+
+struct ConformanceResult {
+  std::string status;
+  std::string frame_hash;
+  std::string state_hash;
+  // PBM dump of a mismatch, empty if none was written
+  fs::path dump;
+  // the error of the input script or of the ROM loading (a fault is a status)
+  std::error_code ec;
+};
+
+// an unknown ('-') expected hash matches any computed one
+bool hashMatches(const std::string &expected, const std::string &computed) {
+  return expected == "-" || expected == computed;
+}
+
+/// @return the status of a run (see the manifest format)
+std::string statusOf(bool verified, const std::error_code &fault) {
+  if (!fault) {
+    return verified ? "verified" : "unverified";
+  }
+  if (fault == SuperChip8::Error::OUT_OF_RANGE) {
+    return "out-of-range";
+  }
+  if (fault == SuperChip8::Error::STACK_OVERFLOW) {
+    return "stack-overflow";
+  }
+  if (fault == SuperChip8::Error::STACK_UNDERFLOW) {
+    return "stack-underflow";
+  }
+  if (fault == SuperChip8::Error::UNKNOWN_OPCODE) {
+    return "unknown-opcode";
+  }
+  return "error";
+}
+
+std::string toHex(std::uint64_t value) {
+  std::ostringstream out;
+  out << std::hex << std::setw(16) << std::setfill('0') << value;
+  return out.str();
+}
+
+template <typename Machine>
+ConformanceResult runCase(const ConformanceCase &test, const fs::path &base,
+                          const fs::path &output_dir) {
+  ConformanceResult result;
+  std::vector<SuperChip8::Emulator::InputEvent> events =
+      SuperChip8::Emulator::parseInputScript(test.input_script, result.ec);
+  if (result.ec) {
+    return result;
+  }
+
+  Machine vm(test.cycles);
+  vm.seed(0);
+  vm.boot((base / test.rom).string(), result.ec);
+  if (result.ec) {
+    return result;
+  }
+
+  std::size_t next_event = 0;
+  std::error_code fault;
+  for (std::uint32_t frame = 0; frame < test.frames && vm.isRunning();
+       frame++) {
+    while (next_event < events.size() && events[next_event].frame <= frame) {
+      vm.setKey(events[next_event].key, events[next_event].pressed);
+      next_event++;
+    }
+    vm.runFrame(fault);
+    if (fault) {
+      break;
+    }
+  }
+
+  result.status = statusOf(vm.isVerified(), fault);
+  result.frame_hash = toHex(vm.display().hashBackBuffer());
+  result.state_hash = toHex(vm.registers().hash());
+
+  // dumping the framebuffer of a mismatch, to compare it by eye
+  if (test.status != result.status ||
+      !hashMatches(test.frame_hash, result.frame_hash) ||
+      !hashMatches(test.state_hash, result.state_hash)) {
+    fs::path dump =
+        output_dir / (fs::path(test.rom).stem().string() + ".pbm");
+    std::ofstream pbm(dump);
+    if (pbm.is_open()) {
+      vm.display().writeBackBufferPBM(pbm);
+      result.dump = dump;
+    }
+  }
+  return result;
+}
+
+/// @brief Run a case on the VM, the batch engine, a VMHost instance and the
+/// forks of the VM in lockstep
+/// @param ec The error of the input script or of the ROM loading
+/// @return the first difference between the two, empty if none
+std::string crossCheck(const ConformanceCase &test, const fs::path &base,
+                       std::error_code &ec) {
+  namespace Graphics = SuperChip8::System::Graphics;
+  std::vector<SuperChip8::Emulator::InputEvent> events =
+      SuperChip8::Emulator::parseInputScript(test.input_script, ec);
+  if (ec) {
+    return {};
+  }
+
+  std::string path = (base / test.rom).string();
+  SuperChip8::Emulator::VM vm(test.cycles);
+  vm.seed(0);
+  vm.boot(path, ec);
+  if (ec) {
+    return {};
+  }
+  SuperChip8::Emulator::Batch::Engine engine(1, test.cycles);
+  engine.loadProgram(path, ec);
+  if (ec) {
+    return {};
+  }
+  engine.reset({0});
+  SuperChip8::Emulator::Host::VMHost host(1);
+  SuperChip8::Emulator::Host::VMHost::instance_id_t instance =
+      host.addInstance(path, test.cycles, ec);
+  if (ec) {
+    return {};
+  }
+
+  std::vector<std::uint16_t> actions = {0};
+  Graphics::Frame frame;
+  Graphics::Frame host_frame;
+  std::size_t next_event = 0;
+  for (std::uint32_t frame_index = 0;
+       frame_index < test.frames && vm.isRunning(); frame_index++) {
+    while (next_event < events.size() &&
+           events[next_event].frame <= frame_index) {
+      const SuperChip8::Emulator::InputEvent &event = events[next_event++];
+      vm.setKey(event.key, event.pressed);
+      host.setKey(instance, event.key, event.pressed);
+      std::uint16_t bit = static_cast<std::uint16_t>(1 << event.key);
+      actions[0] = event.pressed ? actions[0] | bit : actions[0] & ~bit;
+    }
+
+    std::unique_ptr<SuperChip8::Emulator::VM> child = vm.fork();
+    std::error_code vm_ec;
+    vm.runFrame(vm_ec);
+    std::error_code child_ec;
+    child->runFrame(child_ec);
+    SuperChip8::Emulator::Batch::Engine::Observation observation =
+        engine.step(actions);
+    host.runFrame();
+
+    std::ostringstream difference;
+    difference << "frame " << frame_index << ": ";
+    std::error_code engine_ec = engine.error(0);
+    if (vm_ec != engine_ec) {
+      difference << "error \"" << vm_ec.message() << "\" (engine \""
+                 << engine_ec.message() << "\")";
+      return difference.str();
+    }
+    if (vm_ec != child_ec || vm_ec != host.error(instance)) {
+      difference << "error \"" << vm_ec.message() << "\" (fork \""
+                 << child_ec.message() << "\", host \""
+                 << host.error(instance).message() << "\")";
+      return difference.str();
+    }
+    if (vm_ec) {
+      break;
+    }
+    if (vm.isRunning() == static_cast<bool>(observation.done[0])) {
+      difference << (vm.isRunning() ? "engine" : "VM") << " exited alone";
+      return difference.str();
+    }
+
+    SuperChip8::Emulator::Memory::Registers registers = engine.registers(0);
+    if (vm.registers().hash() != registers.hash()) {
+      difference << "state " << toHex(vm.registers().hash()) << " (engine "
+                 << toHex(registers.hash()) << "), pc " << std::hex
+                 << vm.registers().pc << " (engine " << registers.pc << ")";
+      return difference.str();
+    }
+    if (vm.registers().delay_timer != registers.delay_timer) {
+      difference << "delay timer " << +vm.registers().delay_timer
+                 << " (engine " << +registers.delay_timer << ")";
+      return difference.str();
+    }
+
+    if (child->registers().hash() != vm.registers().hash() ||
+        child->display().hashBackBuffer() != vm.display().hashBackBuffer()) {
+      difference << "fork state " << toHex(child->registers().hash())
+                 << ", frame " << toHex(child->display().hashBackBuffer());
+      return difference.str();
+    }
+
+    vm.display().packFrontBuffer(frame);
+    host.frame(instance, host_frame);
+    if (host_frame.width != frame.width ||
+        host_frame.height != frame.height ||
+        host_frame.pixels != frame.pixels) {
+      difference << "host framebuffer";
+      return difference.str();
+    }
+    bool high_res = frame.width == Graphics::HIGH_RES_VIRTUAL_SCREEN_WIDTH;
+    bool same_frame = high_res == static_cast<bool>(observation.high_res[0]);
+    std::size_t row_bytes = (frame.width + 7) / 8;
+    for (std::size_t y = 0; y < frame.height && same_frame; y++) {
+      same_frame = std::memcmp(frame.pixels.data() +
+                                   y * Graphics::FRAME_ROW_BYTES,
+                               observation.frames +
+                                   y * Graphics::FRAME_ROW_BYTES,
+                               row_bytes) == 0;
+    }
+    if (!same_frame) {
+      difference << "framebuffer";
+      return difference.str();
+    }
+  }
+  return {};
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  cxxopts::Options options("SuperChip8_conformance",
+                           "SuperChip8 headless frame-hash conformance runner");
+
+  // clang-format off
+  options.add_options()
+  ("h,help", "Print help")
+  ("m,manifest", "Path to the conformance manifest", cxxopts::value<std::string>())
+  ("o,output", "Directory where the PBM dumps of mismatches are written", cxxopts::value<std::string>()->default_value("."))
+  ("u,update", "Write the computed hashes back to the manifest")
+  ("c,cross-check", "Also run each ROM on the batch engine, in lockstep with the VM, and compare them after every frame");
+  // clang-format on
+
+  auto result = options.parse(argc, argv);
+  if (result.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+  if (!result.count("manifest")) {
+    std::cerr << "Error: manifest not provided" << std::endl;
+    std::cout << options.help() << std::endl;
+    return 1;
+  }
+
+  fs::path manifest_path = result["manifest"].as<std::string>();
+  fs::path output_dir = result["output"].as<std::string>();
+  bool update = result.count("update") > 0;
+  bool cross_check = result.count("cross-check") > 0;
+
+  std::ifstream manifest(manifest_path);
+  if (!manifest.is_open()) {
+    std::cerr << "Error: " << manifest_path.string() << ": "
+              << std::make_error_code(std::errc::no_such_file_or_directory)
+                     .message()
+              << std::endl;
+    return 1;
+  }
+  fs::create_directories(output_dir);
+
+  std::vector<std::string> updated_lines;
+  std::size_t passed = 0;
+  std::size_t failed = 0;
+  auto start = std::chrono::steady_clock::now();
+
+  std::string line;
+  while (std::getline(manifest, line)) {
+    std::istringstream fields(line);
+    ConformanceCase test;
+    if (line.empty() || line[0] == '#' ||
+        !(fields >> test.rom >> test.platform >> test.frames >> test.cycles >>
+          test.status >> test.frame_hash >> test.state_hash)) {
+      updated_lines.push_back(line);
+      continue;
+    }
+    fields >> test.input_script;
+
+    ConformanceResult outcome;
+    if (!SuperChip8::Emulator::visitPlatform(test.platform, [&](auto tag) {
+          outcome = runCase<SuperChip8::Emulator::BasicVM<decltype(tag)>>(
+              test, manifest_path.parent_path(), output_dir);
+        })) {
+      std::cerr << "ERROR    " << test.rom << ": unknown platform "
+                << test.platform << std::endl;
+      updated_lines.push_back(line);
+      failed++;
+      continue;
+    }
+    if (outcome.ec) {
+      std::cerr << "ERROR    " << test.rom << ": " << outcome.ec.message()
+                << std::endl;
+      updated_lines.push_back(line);
+      failed++;
+      continue;
+    }
+
+    if (update) {
+      std::ostringstream updated;
+      updated << test.rom << " " << test.platform << " " << test.frames << " "
+              << test.cycles << " " << outcome.status << " "
+              << outcome.frame_hash << " " << outcome.state_hash;
+      if (!test.input_script.empty()) {
+        updated << " " << test.input_script;
+      }
+      updated_lines.push_back(updated.str());
+      passed++;
+      continue;
+    }
+    updated_lines.push_back(line);
+
+    if (cross_check &&
+        test.platform == SuperChip8::Emulator::SuperChip::NAME) {
+      std::error_code ec;
+      std::string difference =
+          crossCheck(test, manifest_path.parent_path(), ec);
+      if (!difference.empty()) {
+        std::cerr << "DIVERGED " << test.rom << " " << difference
+                  << std::endl;
+        failed++;
+        continue;
+      }
+    }
+
+    bool status_ok = test.status == outcome.status;
+    bool frame_ok = hashMatches(test.frame_hash, outcome.frame_hash);
+    bool state_ok = hashMatches(test.state_hash, outcome.state_hash);
+    if (status_ok && frame_ok && state_ok) {
+      passed++;
+      continue;
+    }
+
+    failed++;
+    std::cerr << "MISMATCH " << test.rom;
+    if (!status_ok) {
+      std::cerr << " status " << outcome.status << " (expected "
+                << test.status << ")";
+    }
+    if (!frame_ok) {
+      std::cerr << " frame " << outcome.frame_hash << " (expected "
+                << test.frame_hash << ")";
+    }
+    if (!state_ok) {
+      std::cerr << " state " << outcome.state_hash << " (expected "
+                << test.state_hash << ")";
+    }
+    if (!outcome.dump.empty()) {
+      std::cerr << " -> " << outcome.dump.string();
+    }
+    std::cerr << std::endl;
+  }
+  manifest.close();
+
+  if (update) {
+    std::ofstream out(manifest_path, std::ios::trunc);
+    for (const std::string &updated : updated_lines) {
+      out << updated << "\n";
+    }
+  }
+
+  std::chrono::duration<double> elapsed =
+      std::chrono::steady_clock::now() - start;
+  std::cout << passed << " passed, " << failed << " failed in " << std::fixed
+            << std::setprecision(3) << elapsed.count() << "s" << std::endl;
+
+  return failed == 0 ? 0 : 1;
+}
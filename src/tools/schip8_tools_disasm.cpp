@@ -0,0 +1,92 @@
+#include "schip8_emulator_analysis_cfg.hpp"
+#include "schip8_emulator_analysis_verifier.hpp"
+
+#include <cxxopts.hpp>
+#include <fstream>
+#include <iostream>
+
+/** ROM disassembler
+ *
+ * Disassembles a ROM from its control-flow graph (see
+ * schip8_emulator_analysis_cfg.hpp):
+ *
+ * - text: the instructions grouped by basic block (main, sub_XXX for the
+ *   subroutines, L_XXX for the other blocks) and the data regions, with the
+ *   computed jumps (BNNN) and the writes to code flagged in comments, then
+ *   the result of the bounds verifier (see
+ *   schip8_emulator_analysis_verifier.hpp)
+ *
+ * - dot: the graph, for Graphviz (ie: `dot -Tsvg cfg.dot -o cfg.svg`); the
+ *   calls are dashed, the blocks ending with a computed jump are red and the
+ *   blocks writing to code orange
+ */
+
+int main(int argc, char *argv[]) {
+  cxxopts::Options options("SuperChip8_disasm",
+                           "SuperChip8 ROM disassembler and CFG analyzer");
+
+  // clang-format off
+  options.add_options()
+  ("h,help", "Print help")
+  ("f,format", "Output format - [text] | [dot]", cxxopts::value<std::string>()->default_value("text"))
+  ("o,output", "Path of the output (default: stdout)", cxxopts::value<std::string>())
+  ("rom", "Path to the ROM file", cxxopts::value<std::string>());
+  // clang-format on
+  options.parse_positional({"rom"});
+  options.positional_help("<rom>");
+
+  auto result = options.parse(argc, argv);
+  if (result.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+  if (!result.count("rom")) {
+    std::cerr << "Error: ROM file not provided" << std::endl;
+    std::cout << options.help() << std::endl;
+    return 1;
+  }
+  std::string format = result["format"].as<std::string>();
+  if (format != "text" && format != "dot") {
+    std::cerr << "Error: unknown format " << format << std::endl;
+    return 1;
+  }
+
+  std::error_code ec;
+  SuperChip8::Emulator::Analysis::ControlFlowGraph cfg =
+      SuperChip8::Emulator::Analysis::ControlFlowGraph::fromFile(
+          result["rom"].as<std::string>(), ec);
+  if (ec) {
+    std::cerr << "Error: " << ec.message() << std::endl;
+    return 1;
+  }
+
+  std::ofstream file;
+  if (result.count("output")) {
+    file.open(result["output"].as<std::string>());
+    if (!file.is_open()) {
+      std::cerr << "Error: cannot write " << result["output"].as<std::string>()
+                << std::endl;
+      return 1;
+    }
+  }
+  std::ostream &out = file.is_open() ? file : std::cout;
+
+  if (format == "dot") {
+    cfg.writeDot(out);
+  } else {
+    cfg.writeText(out);
+
+    SuperChip8::Emulator::Analysis::Verification verification =
+        SuperChip8::Emulator::Analysis::verify(cfg);
+    if (verification.proven) {
+      out << "\n; verified: in bounds, max stack depth "
+          << static_cast<int>(verification.max_stack_depth) << "\n";
+    } else {
+      out << "\n; not verified:\n";
+      for (const std::string &failure : verification.failures) {
+        out << ";   " << failure << "\n";
+      }
+    }
+  }
+  return 0;
+}
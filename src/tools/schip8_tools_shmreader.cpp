@@ -0,0 +1,94 @@
+#include "schip8_system_stream_sharedframe.hpp"
+
+#include <chrono>
+#include <cxxopts.hpp>
+#include <iomanip>
+#include <iostream>
+#include <thread>
+
+/** Shared-memory frame reader
+ *
+ * Reference reader of the shared-memory frame export of an emulator
+ * (`SuperChip8 --export-shm <name>`, see
+ * schip8_system_stream_sharedframe.hpp). Polls the frame number and, for
+ * each new frame, prints its number, its resolution and its hash:
+ *
+ * `42 64x32 8a2f...`
+ *
+ * The frames published between two polls are counted as skipped, and
+ * reported on exit.
+ */
+
+namespace {
+
+namespace Graphics = SuperChip8::System::Graphics;
+namespace Stream = SuperChip8::System::Stream;
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  cxxopts::Options options("SuperChip8_shmreader",
+                           "SuperChip8 shared-memory frame reader");
+
+  // clang-format off
+  options.add_options()
+  ("h,help", "Print help")
+  ("f,frames", "Frames to read before exiting (0: until the export stops)", cxxopts::value<std::uint64_t>()->default_value("0"))
+  ("p,poll", "Poll period in milliseconds", cxxopts::value<std::uint32_t>()->default_value("1"))
+  ("name", "Name of the shared-memory object, ie: /schip8", cxxopts::value<std::string>());
+  // clang-format on
+  options.parse_positional({"name"});
+  options.positional_help("<name>");
+
+  auto result = options.parse(argc, argv);
+  if (result.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+  if (!result.count("name")) {
+    std::cerr << "Error: shared-memory object name not provided" << std::endl;
+    std::cout << options.help() << std::endl;
+    return 1;
+  }
+  std::uint64_t frames = result["frames"].as<std::uint64_t>();
+  std::chrono::milliseconds poll(result["poll"].as<std::uint32_t>());
+
+  std::error_code ec;
+  Stream::SharedFrameReader reader;
+  reader.open(result["name"].as<std::string>(), ec);
+  if (ec) {
+    std::cerr << "Error: " << ec.message() << std::endl;
+    return 1;
+  }
+
+  // the export is considered stopped after a second without a frame
+  const auto timeout = std::chrono::seconds(1);
+  Graphics::Frame frame;
+  std::uint64_t last_number = reader.frameNumber();
+  std::uint64_t read = 0;
+  std::uint64_t skipped = 0;
+  auto last_frame_time = std::chrono::steady_clock::now();
+  while (frames == 0 || read < frames) {
+    if (reader.frameNumber() == last_number) {
+      if (std::chrono::steady_clock::now() - last_frame_time > timeout) {
+        break;
+      }
+      std::this_thread::sleep_for(poll);
+      continue;
+    }
+
+    std::uint64_t number = reader.read(frame);
+    if (read > 0) {
+      skipped += number - last_number - 1;
+    }
+    last_number = number;
+    last_frame_time = std::chrono::steady_clock::now();
+    read++;
+    std::cout << number << " " << +frame.width << "x" << +frame.height << " "
+              << std::hex << std::setw(16) << std::setfill('0')
+              << Graphics::hashFrame(frame) << std::dec << std::endl;
+  }
+
+  std::cerr << read << " frames read, " << skipped << " skipped" << std::endl;
+  return 0;
+}
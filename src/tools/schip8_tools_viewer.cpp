@@ -0,0 +1,144 @@
+#include "schip8_system_stream_deltacodec.hpp"
+#include "schip8_system_stream_socket.hpp"
+
+#include <cxxopts.hpp>
+#include <iomanip>
+#include <iostream>
+#include <raylib.h>
+#include <unistd.h>
+#include <vector>
+
+/** Spectator viewer
+ *
+ * Connects to the spectator server of an emulator (`SuperChip8 --spectate
+ * <address>`, see schip8_system_stream_spectatorserver.hpp) and decodes its
+ * delta frames:
+ *
+ * - in a window, by default
+ * - with `--no-window`, one line per frame on stdout: the frame number, its
+ *   type (key or delta), its encoded size in bytes and the hash of the decoded
+ *   frame, ie: `42 delta 17 8a2f...`
+ */
+
+namespace {
+
+namespace Graphics = SuperChip8::System::Graphics;
+namespace Stream = SuperChip8::System::Stream;
+
+constexpr int PIXEL_SIZE = 8;
+
+/// @brief Read exactly `size` bytes from a socket
+/// @return `false` if the server closed the stream
+bool readExactly(int fd, std::uint8_t *data, std::size_t size) {
+  while (size > 0) {
+    ssize_t count = read(fd, data, size);
+    if (count <= 0) {
+      return false;
+    }
+    data += count;
+    size -= count;
+  }
+  return true;
+}
+
+void drawFrame(const Graphics::Frame &frame) {
+  int pixel_size = PIXEL_SIZE * Graphics::HIGH_RES_VIRTUAL_SCREEN_WIDTH /
+                   frame.width;
+  BeginDrawing();
+  ClearBackground(BLACK);
+  for (int y = 0; y < frame.height; y++) {
+    for (int x = 0; x < frame.width; x++) {
+      if (frame.pixels[y * Graphics::FRAME_ROW_BYTES + x / 8] &
+          (0x80 >> (x % 8))) {
+        DrawRectangle(x * pixel_size, y * pixel_size, pixel_size, pixel_size,
+                      WHITE);
+      }
+    }
+  }
+  EndDrawing();
+}
+
+}  // namespace
+
+int main(int argc, char *argv[]) {
+  cxxopts::Options options("SuperChip8_viewer",
+                           "SuperChip8 spectator stream viewer");
+
+  // clang-format off
+  options.add_options()
+  ("h,help", "Print help")
+  ("n,no-window", "Print one line per frame instead of opening a window")
+  ("address", "Address of the spectator server - [unix:<path>] | [tcp:[<host>:]<port>]", cxxopts::value<std::string>());
+  // clang-format on
+  options.parse_positional({"address"});
+  options.positional_help("<address>");
+
+  auto result = options.parse(argc, argv);
+  if (result.count("help")) {
+    std::cout << options.help() << std::endl;
+    return 0;
+  }
+  if (!result.count("address")) {
+    std::cerr << "Error: address not provided" << std::endl;
+    std::cout << options.help() << std::endl;
+    return 1;
+  }
+  bool window = !result.count("no-window");
+
+  std::error_code ec;
+  int fd = Stream::connectSocket(result["address"].as<std::string>(), ec);
+  if (ec) {
+    std::cerr << "Error: " << ec.message() << std::endl;
+    return 1;
+  }
+
+  if (window) {
+    InitWindow(Graphics::HIGH_RES_VIRTUAL_SCREEN_WIDTH * PIXEL_SIZE,
+               Graphics::HIGH_RES_VIRTUAL_SCREEN_HEIGHT * PIXEL_SIZE,
+               "SuperChiP-8 viewer");
+  }
+
+  // the frames are drawn as they arrive, the server paces the stream
+  Graphics::Frame frame;
+  bool synced = false;
+  std::uint8_t header_data[Stream::DELTA_HEADER_SIZE];
+  std::vector<std::uint8_t> payload;
+  int status = 0;
+  while (!(window && WindowShouldClose())) {
+    Stream::DeltaHeader header;
+    if (!readExactly(fd, header_data, sizeof(header_data))) {
+      break;
+    }
+    if (!Stream::readDeltaHeader(header_data, sizeof(header_data), header)) {
+      std::cerr << "Error: invalid frame header" << std::endl;
+      status = 1;
+      break;
+    }
+    payload.resize(header.payload_size);
+    if (!readExactly(fd, payload.data(), payload.size())) {
+      break;
+    }
+    // the server always starts a viewer with a keyframe
+    synced = synced || header.keyframe;
+    if (!synced || !Stream::decodeFrame(header, payload.data(), frame)) {
+      std::cerr << "Error: corrupted frame " << header.number << std::endl;
+      status = 1;
+      break;
+    }
+
+    if (window) {
+      drawFrame(frame);
+    } else {
+      std::cout << header.number << (header.keyframe ? " key " : " delta ")
+                << Stream::DELTA_HEADER_SIZE + header.payload_size << " "
+                << std::hex << std::setw(16) << std::setfill('0')
+                << Graphics::hashFrame(frame) << std::dec << std::endl;
+    }
+  }
+
+  if (window) {
+    CloseWindow();
+  }
+  close(fd);
+  return status;
+}